@@ -0,0 +1,135 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "AllocCounter.h"
+#include "DataWriter.h"
+#include "SensorPipeline.h"
+#include "ShmRingSink.h"
+#include "StreamServer.h"
+
+// Verifica che l'acquisizione a regime non esegua allocazioni sull'heap: blocchi sintetici
+// attraverso DataWriter, pipeline (assetto + spettro) e destinazioni live, come nel ciclo principale.
+// Uso: bench_alloc [cartella]
+
+namespace {
+    const char* STATUS_JSON =
+        "{\"devices\": [{\"components\": ["
+        "{\"lsm6dsv16x_acc\": {\"sensitivity\": 0.000061, \"odr\": 960}},"
+        "{\"lsm6dsv16x_gyro\": {\"sensitivity\": 0.035, \"odr\": 960}},"
+        "{\"lis2mdl_mag\": {\"sensitivity\": 0.0015, \"odr\": 100}}]}]}";
+
+    int connectSubscriber(const std::string& path, const char* command) {
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+        if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) return -1;
+        send(fd, command, std::strlen(command), 0);
+        return fd;
+    }
+
+    void drain(int fd) {
+        static char buf[65536];
+        while (recv(fd, buf, sizeof(buf), MSG_DONTWAIT) > 0) {}
+    }
+
+    std::vector<uint8_t> makeTriaxialBlock(int nSamples, int phase) {
+        std::vector<uint8_t> block(4 + 6 * nSamples);
+        for (int i = 0; i < nSamples * 3; i++) {
+            int16_t v = static_cast<int16_t>((i * 37 + phase * 11) % 2000 - 1000);
+            std::memcpy(block.data() + 4 + 2 * i, &v, sizeof(v));
+        }
+        return block;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    std::string dir = argc > 1 ? argv[1] : "/tmp/bench_alloc";
+    std::system(("mkdir -p " + dir).c_str());
+
+    struct Scenario { const char* name; int mode; };
+    const Scenario scenarios[] = { { "json", 0 }, { "delta codec", 1 }, { "async I/O", 2 }, { "mmap .dat", 3 } };
+    const int warmup = 300;
+    const int iterations = 3000;
+    int failures = 0;
+
+    std::cout << std::left << std::setw(14) << "Writer" << std::right << std::setw(14) << "allocations"
+              << std::setw(12) << "bytes" << std::setw(18) << "per iteration" << "\n";
+
+    for (const auto& sc : scenarios) {
+        std::vector<uint8_t> acc = makeTriaxialBlock(96, 0), gyro = makeTriaxialBlock(96, 1), mag = makeTriaxialBlock(10, 2);
+        std::vector<uint8_t> temp(16 * 4), mlc(256, 0x5A);
+        for (int i = 0; i < 4; i++) {
+            float value = 25.0f + i;
+            double ts = 1.0e9 + i;
+            std::memcpy(temp.data() + 16 * i + 4, &value, sizeof(value));
+            std::memcpy(temp.data() + 16 * i + 8, &ts, sizeof(ts));
+        }
+
+        uint64_t allocs = 0, bytes = 0;
+        {
+            DataWriter writer(dir);
+            if (sc.mode == 1) writer.setCodec(DataWriter::OutputCodec::DeltaVarint);
+            if (sc.mode == 2) writer.enableAsyncIo();
+            if (sc.mode == 3) writer.enableMappedOutput();
+            // Nomi costruiti una volta, come activeSensors nel ciclo principale
+            const std::vector<std::string> names = { "lsm6dsv16x_acc", "lsm6dsv16x_gyro", "lis2mdl_mag", "stts22h_temp", "ism330dhcx_mlc" };
+            const std::vector<std::vector<uint8_t>*> blocks = { &acc, &gyro, &mag, &temp, &mlc };
+            writer.initSensorFiles(names);
+
+            SensorPipeline pipeline(dir);
+            UnitConverter units;
+            DeviceStatus status;
+            status.parse(STATUS_JSON);
+            units.configure(status);
+            pipeline.configure(status, units);
+            pipeline.enableOrientation(100.0);
+            pipeline.enableSpectral(256);
+
+            ShmRingSink ring("bench_alloc_ring");
+            if (ring.open()) writer.addSink(&ring);
+            std::string socketPath = dir + "/bench_alloc.sock";
+            StreamServer server(socketPath);
+            if (server.start()) writer.addSink(&server);
+            int binaryFd = connectSubscriber(socketPath, "SUBSCRIBE * binary\n");
+            int jsonFd = connectSubscriber(socketPath, "SUBSCRIBE lsm6dsv16x_acc ndjson\n");
+
+            for (int it = 0; it < warmup + iterations; it++) {
+                if (it == warmup) {
+                    allocs = AllocCounter::allocations();
+                    bytes = AllocCounter::bytes();
+                }
+                for (size_t b = 0; b < names.size(); b++) {
+                    const std::vector<uint8_t>& block = *blocks[b];
+                    writer.writeData(names[b], block.data(), static_cast<int>(block.size()));
+                    pipeline.processBlock(names[b], block.data(), static_cast<int>(block.size()));
+                }
+                writer.poll();
+                if (binaryFd >= 0) drain(binaryFd);
+                if (jsonFd >= 0) drain(jsonFd);
+            }
+            allocs = AllocCounter::allocations() - allocs;
+            bytes = AllocCounter::bytes() - bytes;
+
+            if (binaryFd >= 0) ::close(binaryFd);
+            if (jsonFd >= 0) ::close(jsonFd);
+            pipeline.close();
+            writer.closeAll();
+        }
+
+        if (allocs > 0) failures++;
+        std::cout << std::left << std::setw(14) << sc.name << std::right << std::setw(14) << allocs
+                  << std::setw(12) << bytes << std::setw(18) << std::fixed << std::setprecision(3)
+                  << static_cast<double>(allocs) / iterations << "\n";
+    }
+
+    std::cout << (failures == 0 ? "Steady state: zero heap allocations\n" : "Steady state: heap allocations detected\n");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,165 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include <cstring>
+#include "ImuCodec.h"
+#include "SampleDecoder.h"
+
+// Rapporto di compressione e throughput del codec delta+zigzag+varint.
+// Uso: bench_codec [<sensore>.json | cattura.bin [sensore]]
+//   <sensore>.json: flusso registrato dalla CLI senza -u (x/y/z in conteggi grezzi)
+//   cattura.bin:    blocchi in Formato B registrati dal server di streaming (-l) in modalità binary,
+//                   es. printf 'SUBSCRIBE lsm6dsv16x_acc binary\n' | socat -t 60 - UNIX-CONNECT:<socket> > cattura.bin
+// Senza argomenti usa un accelerometro sintetico.
+namespace {
+    bool endsWith(const std::string& s, const std::string& suffix) {
+        return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+    // Terne x/y/z da un JSON della CLI; false se i valori non sono conteggi interi (acquisizione con -u)
+    bool loadJson(const std::string& path, std::vector<int16_t>& samples) {
+        std::ifstream in(path);
+        if (!in) return false;
+        std::string line;
+        const char* keys[] = { "\"x\": ", "\"y\": ", "\"z\": " };
+        while (std::getline(in, line)) {
+            size_t pos = 0;
+            int16_t xyz[3];
+            bool found = true;
+            for (int axis = 0; axis < 3 && found; axis++) {
+                pos = line.find(keys[axis], pos);
+                if (pos == std::string::npos) {
+                    found = false;
+                    break;
+                }
+                pos += std::strlen(keys[axis]);
+                char* end = nullptr;
+                double value = std::strtod(line.c_str() + pos, &end);
+                if (value != std::floor(value) || value < -32768.0 || value > 32767.0) {
+                    std::cerr << path << ": non-integer sample values (recorded with -u?), counts are required\n";
+                    return false;
+                }
+                xyz[axis] = static_cast<int16_t>(value);
+            }
+            if (found) samples.insert(samples.end(), xyz, xyz + 3);
+        }
+        return true;
+    }
+
+    // Blocchi in Formato B di un sensore da una cattura binary del server di streaming:
+    // [uint32 lunghezza][uint16 len nome][nome][float64 timestamp][byte grezzi]
+    bool loadCapture(const std::string& path, std::string& sensor, std::vector<int16_t>& samples,
+                     std::vector<uint32_t>& blockSamples) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) return false;
+        std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        const size_t headerSize = PacketLayout::PACKED_HEADER_SIZE;
+        size_t pos = 0;
+        while (pos + 4 + 2 <= bytes.size()) {
+            uint32_t frameLen;
+            uint16_t nameLen;
+            std::memcpy(&frameLen, bytes.data() + pos, 4);
+            std::memcpy(&nameLen, bytes.data() + pos + 4, 2);
+            if (pos + 4 + frameLen > bytes.size() || frameLen < 2u + nameLen + 8u) break;
+            std::string name(reinterpret_cast<const char*>(bytes.data() + pos + 6), nameLen);
+            const uint8_t* raw = bytes.data() + pos + 6 + nameLen + 8;
+            size_t size = frameLen - 2 - nameLen - 8;
+            pos += 4 + frameLen;
+
+            if (size < headerSize + 6 || (size - headerSize) % 6 != 0) continue;
+            if (sensor.empty()) sensor = name;
+            if (name != sensor) continue;
+            size_t n = (size - headerSize) / 6;
+            size_t old = samples.size();
+            samples.resize(old + n * 3);
+            std::memcpy(samples.data() + old, raw + headerSize, n * 6);
+            blockSamples.push_back(static_cast<uint32_t>(n));
+        }
+        return true;
+    }
+
+    void measure(const std::string& label, const std::vector<int16_t>& samples, const std::vector<uint32_t>& blocks) {
+        size_t rawBytes = 0;
+        for (uint32_t n : blocks) rawBytes += static_cast<size_t>(n) * 6;
+        if (rawBytes == 0) return;
+
+        std::vector<uint8_t> encoded;
+        encoded.reserve(rawBytes * 2);
+        std::vector<uint16_t> scratch;
+
+        auto t0 = std::chrono::steady_clock::now();
+        size_t offset = 0;
+        for (size_t b = 0; b < blocks.size(); b++) {
+            ImuCodec::encodeFrame(samples.data() + offset, blocks[b], 3, static_cast<uint32_t>(b), 0.0, 0.0, encoded, scratch);
+            offset += static_cast<size_t>(blocks[b]) * 3;
+        }
+        auto t1 = std::chrono::steady_clock::now();
+
+        std::vector<int16_t> decoded;
+        ImuCodec::FrameInfo info;
+        size_t pos = 0, mismatches = 0;
+        offset = 0;
+        for (size_t b = 0; b < blocks.size(); b++) {
+            size_t used = ImuCodec::decodeFrame(encoded.data() + pos, encoded.size() - pos, info, decoded);
+            if (used == 0) { mismatches++; break; }
+            pos += used;
+            if (std::memcmp(decoded.data(), samples.data() + offset, blocks[b] * 6) != 0) mismatches++;
+            offset += static_cast<size_t>(blocks[b]) * 3;
+        }
+        auto t2 = std::chrono::steady_clock::now();
+
+        double encSec = std::chrono::duration<double>(t1 - t0).count();
+        double decSec = std::chrono::duration<double>(t2 - t1).count();
+        std::cout << label << ": ratio " << (double)rawBytes / encoded.size()
+                  << "x, encode " << rawBytes / encSec / 1e6 << " MB/s, decode "
+                  << rawBytes / decSec / 1e6 << " MB/s"
+                  << (mismatches ? " [ROUND-TRIP MISMATCH]" : "") << "\n";
+    }
+}
+
+int main(int argc, char *argv[]) {
+    std::vector<int16_t> samples;
+    std::vector<uint32_t> recordedBlocks;
+
+    if (argc > 1) {
+        std::string path = argv[1];
+        std::string sensor = (argc > 2) ? argv[2] : "";
+        bool ok = endsWith(path, ".json") ? loadJson(path, samples)
+                                          : loadCapture(path, sensor, samples, recordedBlocks);
+        if (!ok || samples.empty()) {
+            std::cerr << "No int16 triaxial samples read from " << path << "\n";
+            return 1;
+        }
+        std::cout << "Input: " << path << (sensor.empty() ? "" : " (" + sensor + ")") << ", "
+                  << samples.size() / 3 << " samples\n";
+    } else {
+        // Accelerometro sintetico: gravità su z, vibrazione e rumore di pochi LSB
+        std::mt19937 rng(42);
+        std::normal_distribution<double> noise(0.0, 6.0);
+        size_t n = 4 * 1024 * 1024;
+        samples.resize(n * 3);
+        for (size_t i = 0; i < n; i++) {
+            double vib = 400.0 * std::sin(2.0 * 3.14159265358979 * 37.0 * i / 7680.0);
+            samples[3 * i] = static_cast<int16_t>(120 + vib + noise(rng));
+            samples[3 * i + 1] = static_cast<int16_t>(-80 + 0.5 * vib + noise(rng));
+            samples[3 * i + 2] = static_cast<int16_t>(2048 + noise(rng));
+        }
+        std::cout << "Input: synthetic accelerometer\n";
+    }
+
+    // Blocchi come ricevuti dal dispositivo (solo per le catture), poi dimensioni fisse
+    if (!recordedBlocks.empty()) measure("recorded blocks", samples, recordedBlocks);
+    for (uint32_t blockSamples : { 64u, 384u, 2048u }) {
+        std::vector<uint32_t> blocks(samples.size() / 3 / blockSamples, blockSamples);
+        std::ostringstream label;
+        label << blockSamples << " samples/block";
+        measure(label.str(), samples, blocks);
+    }
+    return 0;
+}
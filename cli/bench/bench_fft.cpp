@@ -0,0 +1,39 @@
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <vector>
+#include "SpectralAnalyzer.h"
+
+// Throughput della FFT a finestre per 1024 e 4096 punti (overlap 50%)
+int main(int argc, char *argv[]) {
+    const double seconds = (argc > 1) ? std::stod(argv[1]) : 60.0;
+    const double fs = 7680.0;
+    const std::vector<double> bands = { 0.0, 5.0, 10.0, 20.0, 50.0, 100.0, 200.0, 400.0, fs / 2.0 };
+
+    // Segnale sintetico: gravità + vibrazione a 37 Hz + armonica a 180 Hz
+    size_t nSamples = static_cast<size_t>(seconds * fs);
+    std::vector<float> signal(nSamples);
+    for (size_t i = 0; i < nSamples; i++) {
+        double t = i / fs;
+        signal[i] = static_cast<float>(1.0 + 0.3 * std::sin(2.0 * 3.14159265358979 * 37.0 * t)
+                                           + 0.05 * std::sin(2.0 * 3.14159265358979 * 180.0 * t));
+    }
+
+    for (size_t windowSize : { 1024, 4096 }) {
+        SpectralAnalyzer analyzer(windowSize, 0.5, fs, bands);
+        size_t frames = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < nSamples; i++) {
+            if (analyzer.push(signal[i], i / fs)) frames++;
+        }
+        auto end = std::chrono::steady_clock::now();
+        double sec = std::chrono::duration<double>(end - start).count();
+
+        std::cout << windowSize << "-point: " << frames << " windows in " << sec << " s, "
+                  << (sec * 1e6 / frames) << " us/window, "
+                  << (nSamples / sec) << " samples/s ("
+                  << (nSamples / sec / fs) << "x real time @ " << fs << " Hz)"
+                  << ", dominant " << analyzer.frame().dominantFreq << " Hz\n";
+    }
+    return 0;
+}
@@ -0,0 +1,47 @@
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <vector>
+#include "OrientationFilter.h"
+
+// Misura il costo per campione del filtro AHRS e lo confronta con l'ODR massimo dell'IMU
+int main(int argc, char *argv[]) {
+    const size_t nSamples = (argc > 1) ? std::stoul(argv[1]) : 2000000;
+    const double imuOdr = 7680.0; // ODR massimo lsm6dsv16x
+    const float dt = static_cast<float>(1.0 / imuOdr);
+
+    // Dati sintetici: rotazione lenta con rumore deterministico
+    std::vector<float> g(3 * 1024), a(3 * 1024), m(3 * 1024);
+    for (size_t i = 0; i < 1024; i++) {
+        float ph = 0.01f * i;
+        g[3 * i] = 0.2f * std::sin(ph); g[3 * i + 1] = 0.1f; g[3 * i + 2] = -0.05f;
+        a[3 * i] = 0.02f * std::cos(ph); a[3 * i + 1] = 0.01f; a[3 * i + 2] = 0.98f;
+        m[3 * i] = 0.3f; m[3 * i + 1] = 0.1f * std::sin(ph); m[3 * i + 2] = -0.4f;
+    }
+
+    for (int mode = 0; mode < 2; mode++) {
+        OrientationFilter filter;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < nSamples; i++) {
+            size_t k = 3 * (i & 1023);
+            if (mode == 0) {
+                filter.updateImu(g[k], g[k + 1], g[k + 2], a[k], a[k + 1], a[k + 2], dt);
+            } else {
+                filter.update(g[k], g[k + 1], g[k + 2], a[k], a[k + 1], a[k + 2],
+                              m[k], m[k + 1], m[k + 2], dt);
+            }
+        }
+        auto end = std::chrono::steady_clock::now();
+        double sec = std::chrono::duration<double>(end - start).count();
+
+        float roll, pitch, yaw;
+        filter.getEuler(roll, pitch, yaw);
+        double rate = nSamples / sec;
+        std::cout << (mode == 0 ? "6-axis" : "9-axis")
+                  << ": " << (sec * 1e9 / nSamples) << " ns/sample, "
+                  << rate << " samples/s, "
+                  << (rate / imuOdr) << "x full-rate IMU (" << imuOdr << " Hz)"
+                  << " [rpy " << roll << " " << pitch << " " << yaw << "]\n";
+    }
+    return 0;
+}
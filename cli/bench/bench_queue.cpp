@@ -0,0 +1,124 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include "BlockQueue.h"
+#include "LatencyStats.h"
+
+// Coda dei callback di dati pronti: prova di carico con molti produttori (ordine per
+// produttore, integrità dei blocchi anche su più slot, nessuna perdita) e latenza
+// callback -> consumatore con il consumatore addormentato sul doorbell.
+// Uso: bench_queue [blocchi_per_produttore]
+
+namespace {
+    // Blocco: [uint32 produttore][uint32 sequenza][byte = (sequenza + i) & 0xFF]
+    size_t blockSize(uint32_t seq) {
+        // Per lo più pacchetti piccoli, uno su 64 più grande di uno slot
+        return (seq % 64 == 63) ? 9000 + seq % 1000 : 16 + (seq * 37) % 2000;
+    }
+
+    void fill(std::vector<uint8_t>& buf, uint32_t producer, uint32_t seq) {
+        buf.resize(blockSize(seq));
+        std::memcpy(buf.data(), &producer, 4);
+        std::memcpy(buf.data() + 4, &seq, 4);
+        for (size_t i = 8; i < buf.size(); i++) buf[i] = static_cast<uint8_t>(seq + i);
+    }
+
+    bool stress(int producers, uint32_t blocks) {
+        BlockQueue queue(256, 4096);
+        std::atomic<bool> go(false);
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producers; p++) {
+            threads.emplace_back([&, p]() {
+                std::vector<uint8_t> buf;
+                while (!go.load()) std::this_thread::yield();
+                for (uint32_t seq = 0; seq < blocks; seq++) {
+                    fill(buf, static_cast<uint32_t>(p), seq);
+                    // Coda piena: nuovo tentativo (nella CLI il blocco verrebbe scartato)
+                    while (!queue.push(static_cast<uint32_t>(p), buf.data(), buf.size())) std::this_thread::yield();
+                }
+            });
+        }
+
+        std::vector<uint32_t> expected(producers, 0);
+        uint64_t received = 0, errors = 0;
+        uint64_t total = static_cast<uint64_t>(producers) * blocks;
+        auto t0 = std::chrono::steady_clock::now();
+        go.store(true);
+        BlockQueue::Block block;
+        while (received < total) {
+            if (!queue.front(block)) {
+                queue.wait(100);
+                continue;
+            }
+            uint32_t producer, seq;
+            std::memcpy(&producer, block.data, 4);
+            std::memcpy(&seq, block.data + 4, 4);
+            bool ok = producer == block.sensor && producer < expected.size() && seq == expected[producer]
+                      && block.size == blockSize(seq);
+            for (size_t i = 8; ok && i < block.size; i++) ok = block.data[i] == static_cast<uint8_t>(seq + i);
+            if (!ok) errors++;
+            if (producer < expected.size()) expected[producer] = seq + 1;
+            queue.release();
+            received++;
+        }
+        double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        for (auto& t : threads) t.join();
+
+        std::cout << "  " << producers << " producers: " << received << " blocks, "
+                  << std::fixed << std::setprecision(0) << received / sec << " blocks/s, "
+                  << errors << " errors, " << queue.droppedBlocks() << " rejected while full"
+                  << std::defaultfloat << "\n";
+        return errors == 0;
+    }
+
+    void latency(int producers, int blocksPerProducer) {
+        BlockQueue queue(1024, 4096);
+        LatencyStats stats;
+        std::atomic<int> done(0);
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producers; p++) {
+            threads.emplace_back([&, p]() {
+                uint8_t packet[512] = {0};
+                for (int i = 0; i < blocksPerProducer; i++) {
+                    // Ritmo di un pacchetto USB ogni ~1 ms per componente
+                    std::this_thread::sleep_for(std::chrono::microseconds(1000));
+                    queue.push(static_cast<uint32_t>(p), packet, sizeof(packet));
+                }
+                done++;
+            });
+        }
+
+        int total = producers * blocksPerProducer;
+        int received = 0;
+        BlockQueue::Block block;
+        while (received < total) {
+            queue.wait(100);
+            while (queue.front(block)) {
+                stats.record((BlockQueue::nowNs() - block.enqueueNs) / 1000.0);
+                queue.release();
+                received++;
+            }
+            if (done.load() == producers && !queue.front(block) && received < total) break;
+        }
+        for (auto& t : threads) t.join();
+        std::cout << "  " << producers << " producers: " << stats.summary() << "\n";
+    }
+}
+
+int main(int argc, char** argv) {
+    uint32_t blocks = (argc > 1) ? static_cast<uint32_t>(std::stoul(argv[1])) : 100000;
+
+    std::cout << "Stress (" << blocks << " blocks per producer, 256 slots of 4 KB):\n";
+    bool ok = true;
+    for (int producers : {1, 2, 4, 8, 16}) ok = stress(producers, blocks) && ok;
+
+    std::cout << "Callback -> consumer latency (consumer sleeping on the doorbell):\n";
+    for (int producers : {1, 4, 8}) latency(producers, 2000);
+
+    std::cout << (ok ? "OK\n" : "FAILED\n");
+    return ok ? 0 : 1;
+}
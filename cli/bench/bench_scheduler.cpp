@@ -0,0 +1,102 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <vector>
+#include <thread>
+#include "TaskScheduler.h"
+#include "SpectralAnalyzer.h"
+
+// Scalabilità del pool a furto di lavoro da 1 a 4 thread con un carico misto: quattro sensori
+// ad alto ODR (FFT a finestre, overlap 75%) e quattro sensori lenti, un task per blocco.
+// Verifica anche l'ordine dei blocchi per sensore. Uso: bench_scheduler [blocchi_per_sensore]
+
+namespace {
+    const double FS = 7680.0;
+    const size_t BLOCK_SAMPLES = 512;
+
+    struct SensorState {
+        TaskScheduler::Strand strand;
+        std::unique_ptr<SpectralAnalyzer> spectral;   // nullptr: sensore lento
+        uint32_t nextSeq = 0;
+        uint64_t orderErrors = 0;
+        double checksum = 0.0;
+    };
+
+    struct BlockTask : public TaskScheduler::Task {
+        SensorState* sensor = nullptr;
+        uint32_t seq = 0;
+        const std::vector<float>* samples = nullptr;
+
+        void run() override {
+            if (seq != sensor->nextSeq) sensor->orderErrors++;
+            sensor->nextSeq = seq + 1;
+            if (sensor->spectral) {
+                double t0 = seq * BLOCK_SAMPLES / FS;
+                for (size_t i = 0; i < BLOCK_SAMPLES; i++) {
+                    if (sensor->spectral->push((*samples)[i], t0 + i / FS)) {
+                        sensor->checksum += sensor->spectral->frame().dominantFreq;
+                    }
+                }
+            } else {
+                // Sensore lento: conversione e media di pochi campioni
+                double sum = 0.0;
+                for (size_t i = 0; i < 16; i++) sum += (*samples)[i] * 0.5;
+                sensor->checksum += sum;
+            }
+        }
+    };
+}
+
+int main(int argc, char* argv[]) {
+    const uint32_t blocks = (argc > 1) ? static_cast<uint32_t>(std::stoul(argv[1])) : 1000;
+    const int nSensors = 8, nFast = 4;
+    const std::vector<double> bands = { 0.0, 5.0, 10.0, 20.0, 50.0, 100.0, 200.0, 400.0, FS / 2.0 };
+
+    std::vector<float> samples(BLOCK_SAMPLES);
+    for (size_t i = 0; i < BLOCK_SAMPLES; i++) {
+        samples[i] = static_cast<float>(1.0 + 0.3 * std::sin(2.0 * 3.14159265358979 * 37.0 * i / FS));
+    }
+
+    std::cout << "Hardware threads: " << std::thread::hardware_concurrency() << "\n";
+    double baseline = 0.0;
+    bool ok = true;
+    for (int threads = 1; threads <= 4; threads++) {
+        std::vector<std::unique_ptr<SensorState>> sensors;
+        for (int s = 0; s < nSensors; s++) {
+            sensors.emplace_back(new SensorState());
+            if (s < nFast) sensors[s]->spectral.reset(new SpectralAnalyzer(1024, 0.75, FS, bands));
+        }
+        std::vector<BlockTask> tasks(static_cast<size_t>(nSensors) * blocks);
+
+        TaskScheduler scheduler(threads);
+        auto start = std::chrono::steady_clock::now();
+        // Invio intercalato, come in acquisizione: un blocco per sensore a ogni giro
+        for (uint32_t b = 0; b < blocks; b++) {
+            for (int s = 0; s < nSensors; s++) {
+                BlockTask& task = tasks[static_cast<size_t>(b) * nSensors + s];
+                task.sensor = sensors[s].get();
+                task.seq = b;
+                task.samples = &samples;
+                scheduler.submit(sensors[s]->strand, &task);
+            }
+        }
+        scheduler.wait();
+        double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        uint64_t orderErrors = 0;
+        for (auto& s : sensors) orderErrors += s->orderErrors + (s->nextSeq != blocks ? 1 : 0);
+        if (orderErrors > 0) ok = false;
+        if (threads == 1) baseline = sec;
+
+        double fastSamples = static_cast<double>(nFast) * blocks * BLOCK_SAMPLES;
+        std::cout << threads << " thread(s): " << std::fixed << std::setprecision(3) << sec << " s, "
+                  << std::setprecision(2) << (baseline / sec) << "x speedup, "
+                  << std::setprecision(1) << (fastSamples / sec / FS) << "x real time per fast sensor, "
+                  << scheduler.stolenCount() << " steals, " << orderErrors << " ordering errors"
+                  << std::defaultfloat << "\n";
+    }
+    std::cout << (ok ? "OK\n" : "FAILED\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,132 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <cstring>
+#include <ctime>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "ShmRingSink.h"
+#include "LatencyStats.h"
+
+// Ring buffer in memoria condivisa: latenza scrittore -> lettore in un processo separato
+// (come il motore di inferenza), controllo di sequenza (nessun record perso o sovrascritto).
+// Lo scrittore pubblica un blocco da 512 byte ogni ~1 ms (ritmo dei pacchetti USB) con
+// timestamp CLOCK_MONOTONIC; il lettore lo confronta con l'ora di lettura.
+// Due lettori: attesa attiva (con yield) e polling ogni 1 ms, tipico di un lettore Python.
+// Uso: bench_shm [blocchi]
+
+namespace {
+    const char* RING_NAME = "bench_shm_ring";
+    const size_t HEADER_SIZE = 4096;
+    const uint32_t PADDING_RECORD = 0xFFFFFFFF;
+
+    double monotonicSec() {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<double>(ts.tv_sec) + ts.tv_nsec * 1e-9;
+    }
+
+    // Lettore secondo il protocollo documentato in ShmRingSink.h. Ritorna 0 se tutti i record
+    // sono arrivati in ordine e nessuno è stato sovrascritto durante la copia
+    int runReader(uint64_t expected, bool busy) {
+        int fd = shm_open((std::string("/") + RING_NAME).c_str(), O_RDONLY, 0);
+        if (fd < 0) return 2;
+        struct stat st;
+        fstat(fd, &st);
+        void* p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) return 2;
+        const uint8_t* base = static_cast<const uint8_t*>(p);
+
+        uint64_t capacity;
+        std::memcpy(&capacity, base + 0x08, sizeof(capacity));
+        const uint8_t* data = base + HEADER_SIZE;
+        auto* reserve = reinterpret_cast<const std::atomic<uint64_t>*>(base + 0x40);
+        auto* commit = reinterpret_cast<const std::atomic<uint64_t>*>(base + 0x80);
+
+        LatencyStats stats;
+        std::vector<uint8_t> block(65536);
+        uint64_t pos = 0, lastSeq = 0, received = 0, gaps = 0, overwritten = 0;
+        double deadline = monotonicSec() + 10.0 + expected * 0.002;
+        while (received < expected && monotonicSec() < deadline) {
+            uint64_t end = commit->load(std::memory_order_acquire);
+            if (pos == end) {
+                if (busy) std::this_thread::yield();
+                else std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                continue;
+            }
+            while (pos < end) {
+                const uint8_t* rec = data + (pos & (capacity - 1));
+                uint32_t length, sensor, size;
+                uint64_t seq;
+                double ts;
+                std::memcpy(&length, rec, 4);
+                std::memcpy(&sensor, rec + 4, 4);
+                if (sensor != PADDING_RECORD) {
+                    std::memcpy(&seq, rec + 8, 8);
+                    std::memcpy(&ts, rec + 16, 8);
+                    std::memcpy(&size, rec + 24, 4);
+                    std::memcpy(block.data(), rec + 32, std::min<size_t>(size, block.size()));
+                    double now = monotonicSec();
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    if (reserve->load(std::memory_order_relaxed) - pos > capacity) {
+                        overwritten++;
+                        pos = end;
+                        break;
+                    }
+                    if (seq != lastSeq + 1) gaps++;
+                    lastSeq = seq;
+                    stats.record((now - ts) * 1e6);
+                    received++;
+                }
+                pos += length;
+            }
+        }
+        munmap(p, static_cast<size_t>(st.st_size));
+
+        std::cout << "  " << (busy ? "busy-wait reader:   " : "1 ms polling reader:") << " " << stats.summary()
+                  << ", " << received << "/" << expected << " records, " << gaps << " gaps, "
+                  << overwritten << " overwritten" << std::endl;   // _exit non svuota i buffer
+        return (received == expected && gaps == 0 && overwritten == 0) ? 0 : 1;
+    }
+
+    bool measure(uint64_t blocks, bool busy) {
+        ShmRingSink ring(RING_NAME);
+        if (!ring.open()) return false;
+
+        pid_t child = fork();
+        if (child == 0) _exit(runReader(blocks, busy));
+        if (child < 0) return false;
+
+        // Tempo al lettore per agganciarsi prima del primo record
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        uint8_t packet[512];
+        for (size_t i = 0; i < sizeof(packet); i++) packet[i] = static_cast<uint8_t>(i);
+        const char* sensors[] = { "lsm6dsv16x_acc", "lsm6dsv16x_gyro", "lis2mdl_mag", "stts22h_temp" };
+        for (uint64_t i = 0; i < blocks; i++) {
+            std::this_thread::sleep_for(std::chrono::microseconds(1000));
+            ring.onData(sensors[i % 4], packet, sizeof(packet), monotonicSec());
+        }
+
+        int status = 0;
+        waitpid(child, &status, 0);
+        ring.close();
+        return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+}
+
+int main(int argc, char** argv) {
+    uint64_t blocks = (argc > 1) ? std::stoull(argv[1]) : 5000;
+    std::cout << "Writer -> reader latency in us (" << blocks << " blocks of 512 bytes, one every ~1 ms, reader in a separate process):" << std::endl;
+    bool ok = measure(blocks, true);
+    ok = measure(blocks, false) && ok;
+    std::cout << (ok ? "OK\n" : "FAILED\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,14 @@
+#pragma once
+#include <cstdint>
+
+/**
+ * @brief Conteggio delle allocazioni sull'heap (operator new sostituito).
+ * Attivo solo nelle build Debug e nei benchmark (HSD_COUNT_ALLOCATIONS):
+ * serve a verificare che l'acquisizione a regime non allochi memoria.
+ * Nelle altre build enabled() è false e i contatori restano a zero.
+ */
+namespace AllocCounter {
+    bool enabled();
+    uint64_t allocations();
+    uint64_t bytes();
+}
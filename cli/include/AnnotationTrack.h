@@ -0,0 +1,63 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <fstream>
+#include "DataWriter.h"
+
+/**
+ * @brief Traccia delle annotazioni (tag software/hardware) di un'acquisizione.
+ *
+ * Ogni inizio/fine di un tag viene aggiunto subito ad annotations.jsonl, con il
+ * timestamp host e la posizione corrente (file del segmento, offset in byte) di
+ * ogni file dei sensori. Alla chiusura, annotations_index.json raccoglie gli
+ * intervalli completi {etichetta, inizio, fine, offset per sensore}: per estrarre
+ * la finestra di un tag basta leggere i byte [start_offset, end_offset) di ogni
+ * file, senza scorrere l'intera acquisizione. Gli offset cadono sempre tra due
+ * blocchi scritti (nei file JSON la fetta inizia con il separatore ",").
+ */
+class AnnotationTrack {
+public:
+    explicit AnnotationTrack(const std::string& outputDir);
+    ~AnnotationTrack();
+
+    bool open();
+
+    // Stato di un tag per etichetta (true se aperto)
+    bool isActive(const std::string& label) const;
+
+    // Registra l'inizio (on) o la fine di un tag; source: "key", "socket", "stop"...
+    // Ritorna la riga JSON scritta (da inoltrare alle destinazioni live)
+    const std::string& record(const std::string& label, bool on, const char* source, double timestamp,
+                              const std::vector<DataWriter::StreamPosition>& positions);
+
+    // Etichette dei tag ancora aperti (da chiudere alla fine dell'acquisizione)
+    std::vector<std::string> activeLabels() const;
+
+    // Tag registrati dal dispositivo (acquisition info), inclusi quelli hardware
+    void setDeviceTags(const std::string& acquisitionInfoJson);
+
+    // Scrive annotations_index.json
+    bool writeIndex();
+
+    size_t intervalCount() const { return intervals.size(); }
+
+private:
+    struct Interval {
+        std::string label;
+        std::string source;
+        double start = 0.0;
+        double end = 0.0;
+        std::vector<DataWriter::StreamPosition> startPositions;
+        std::vector<DataWriter::StreamPosition> endPositions;
+    };
+
+    std::string baseDir;
+    std::ofstream log;
+    std::string line;
+    std::map<std::string, Interval> openTags;
+    std::vector<Interval> intervals;
+    std::string deviceTags;   // Array JSON dei tag del dispositivo ("[]" se assente)
+
+    static void appendEscaped(std::string& out, const std::string& text);
+};
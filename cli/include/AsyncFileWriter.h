@@ -0,0 +1,232 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <ostream>
+#include <streambuf>
+#include <cstdint>
+#include "MemoryPool.h"
+
+/**
+ * @brief Politica di durabilità dei file scritti da AsyncFileWriter.
+ * Compromesso tra finestra di perdita in caso di interruzione dell'alimentazione
+ * e throughput di scrittura (vedi bench/bench_durability.cpp).
+ */
+struct DurabilityPolicy {
+    double syncIntervalSec = 0.0;   // fdatasync periodico su un thread dedicato (0 = solo alla chiusura del processo)
+    size_t preallocateBytes = 0;    // fallocate all'apertura del file (0 = disabilitato)
+    bool directIo = false;          // O_DIRECT: scritture allineate a 4 KB senza page cache
+};
+
+/**
+ * @brief Backend di scrittura asincrona su disco (solo Linux).
+ *
+ * I dati vengono scritti direttamente in buffer di un pool (allineati a 4 KB)
+ * che, una volta pieni, vengono accodati per la scrittura all'offset corrente
+ * del file. Le richieste di tutti i file vengono inviate insieme da flush()
+ * e i buffer tornano al pool al completamento.
+ * Due implementazioni: io_uring (buffer registrati, una sola io_uring_enter
+ * per lotto) e, se io_uring non è disponibile, un thread dedicato con pwrite.
+ * Tutti i metodi pubblici sono thread-safe.
+ */
+class AsyncFileWriter {
+public:
+    struct Buffer {
+        uint8_t* data = nullptr;
+        size_t capacity = 0;
+        int index = 0;
+    };
+
+    virtual ~AsyncFileWriter();
+
+    // Crea il backend migliore disponibile (nullptr se non supportato dalla piattaforma);
+    // preferUring = false forza il thread pwrite (confronti e benchmark)
+    static std::unique_ptr<AsyncFileWriter> create(size_t bufferSize = 64 * 1024, size_t nBuffers = 64, bool preferUring = true);
+
+    virtual const char* backendName() const = 0;
+
+    int openFile(const std::string& path);
+    Buffer* acquireBuffer();
+    void releaseBuffer(Buffer* buffer);
+
+    // Accoda la scrittura di len byte del buffer in coda al file (il buffer torna al pool al completamento)
+    void submit(int file, Buffer* buffer, size_t len);
+
+    // Invia le richieste in coda e raccoglie i completamenti senza attendere
+    void flush();
+
+    // Attende il completamento delle scritture del file e lo chiude
+    void closeFile(int file);
+
+    // Descrittore scritto fuori dal backend (file mappati): incluso nel fdatasync periodico.
+    // unwatchFile attende un fdatasync in corso; il descrittore resta del chiamante
+    int watchFile(int fd);
+    void unwatchFile(int file);
+
+    // Da impostare prima di aprire i file
+    void setDurability(const DurabilityPolicy& policy);
+
+    // Allineamento richiesto per offset e lunghezza delle scritture (4096 con O_DIRECT)
+    size_t writeAlignment() const { return policy.directIo ? BUFFER_ALIGNMENT : 1; }
+
+    // Numero di system call di scrittura/invio effettuate (statistica)
+    uint64_t syscallCount() const { return syscalls; }
+    uint64_t syncCount() const { return syncs; }
+
+    static const size_t BUFFER_ALIGNMENT = 4096;
+
+protected:
+    struct FileState {
+        int fd = -1;
+        uint64_t offset = 0;
+        int pending = 0;
+        bool direct = false;    // O_DIRECT ancora attivo sul descrittore
+        bool dirty = false;     // Scritture completate dopo l'ultimo fdatasync
+        int syncing = 0;        // fdatasync in corso sul thread di sincronizzazione
+        bool external = false;  // Da watchFile: scritto senza passare dal backend, sempre da sincronizzare
+    };
+
+    AsyncFileWriter(size_t bufferSize, size_t nBuffers);
+
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::vector<FileState> files;
+    std::vector<int> freeFiles;          // Slot chiusi (fd < 0, nessuna scrittura o fdatasync in corso), riusati
+    std::deque<Buffer> buffers;          // deque: i puntatori restano validi quando il pool cresce
+    std::vector<Buffer*> freeBuffers;
+    std::vector<std::unique_ptr<uint8_t[]>> storage;
+    size_t bufferSize;
+    size_t registeredBuffers;            // Buffer preallocati (registrabili dal backend)
+    int pendingTotal;
+    uint64_t syscalls;
+
+    DurabilityPolicy policy;
+    uint64_t syncs;
+    bool syncStopping;
+    std::condition_variable syncCv;
+    std::thread syncThread;
+
+    void addBuffers(size_t count);
+    int addFileLocked(const FileState& state);   // Con mtx acquisito; riusa uno slot chiuso se c'è
+    void syncRun();
+
+    // Da chiamare all'inizio del distruttore del backend, prima di chiudere i descrittori
+    void stopSyncThread();
+
+    // Interfaccia del backend, chiamata con mtx acquisito
+    virtual bool init() = 0;
+    virtual void enqueueLocked(int file, Buffer* buffer, size_t len, uint64_t offset) = 0;
+    virtual void submitLocked(bool wait, std::unique_lock<std::mutex>& lock) = 0;
+
+    void completeLocked(int file, Buffer* buffer);
+    void drainLocked(std::unique_lock<std::mutex>& lock);
+};
+
+/**
+ * @brief Backend io_uring (syscall dirette, senza liburing).
+ */
+class UringFileWriter : public AsyncFileWriter {
+public:
+    UringFileWriter(size_t bufferSize, size_t nBuffers);
+    ~UringFileWriter();
+    const char* backendName() const override { return "io_uring"; }
+
+protected:
+    bool init() override;
+    void enqueueLocked(int file, Buffer* buffer, size_t len, uint64_t offset) override;
+    void submitLocked(bool wait, std::unique_lock<std::mutex>& lock) override;
+
+private:
+    struct Op {
+        int file = -1;
+        size_t len = 0;
+        size_t done = 0;
+        uint64_t offset = 0;
+    };
+
+    int ringFd;
+    bool fixedBuffers;
+    unsigned toSubmit;
+    unsigned inflightOps;
+    std::vector<Op> ops;
+
+    // Mappature dell'anello (puntatori nelle aree condivise con il kernel)
+    void* sqRing;
+    void* cqRing;
+    void* sqes;
+    size_t sqRingSize, cqRingSize, sqesSize;
+    unsigned* sqHead; unsigned* sqTail; unsigned* sqMask; unsigned* sqArray; unsigned sqEntries;
+    unsigned* cqHead; unsigned* cqTail; unsigned* cqMask; void* cqes;
+
+    void pushSqe(Buffer* buffer);
+    void closeRing();
+    void enterLocked(bool wait);
+    void reapLocked();
+};
+
+/**
+ * @brief Backend di ripiego: thread dedicato che esegue pwrite.
+ */
+class ThreadFileWriter : public AsyncFileWriter {
+public:
+    ThreadFileWriter(size_t bufferSize, size_t nBuffers);
+    ~ThreadFileWriter();
+    const char* backendName() const override { return "pwrite thread"; }
+
+protected:
+    bool init() override;
+    void enqueueLocked(int file, Buffer* buffer, size_t len, uint64_t offset) override;
+    void submitLocked(bool wait, std::unique_lock<std::mutex>& lock) override;
+
+private:
+    struct Job {
+        int file = -1;
+        Buffer* buffer = nullptr;
+        size_t len = 0;
+        uint64_t offset = 0;
+    };
+    RingQueue<Job> jobs;
+    bool stopping;
+    std::thread worker;
+
+    void run();
+};
+
+/**
+ * @brief Stream di uscita che scrive direttamente nei buffer di un AsyncFileWriter.
+ * Compatibile con l'uso di std::ofstream in DataWriter (operator<<, write, tellp).
+ */
+class AsyncOutputStream : public std::ostream {
+public:
+    AsyncOutputStream(AsyncFileWriter* writer, const std::string& path);
+    ~AsyncOutputStream();
+
+    bool isOpen() const { return buf.file >= 0; }
+    void close();
+
+    // Invia la parte del buffer corrente già scritta (a blocchi interi se il backend usa O_DIRECT)
+    void flushPending();
+
+private:
+    class AsyncStreamBuf : public std::streambuf {
+    public:
+        AsyncFileWriter* writer = nullptr;
+        int file = -1;
+        AsyncFileWriter::Buffer* current = nullptr;
+        uint64_t submitted = 0;
+
+        void submitCurrent();
+        void submitAligned();
+
+    protected:
+        int_type overflow(int_type c) override;
+        int sync() override;
+        pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override;
+    };
+
+    AsyncStreamBuf buf;
+};
@@ -0,0 +1,72 @@
+#pragma once
+#include <atomic>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @brief Coda limitata multi-produttore / singolo consumatore di blocchi dati,
+ * senza lock, per i callback di dati pronti della libreria (thread interni).
+ *
+ * Ogni slot (allineato alla linea di cache) contiene descrittore e copia del
+ * payload, fino a slotPayload byte; i blocchi più grandi occupano più slot
+ * consecutivi, riservati con un'unica compare-and-swap, e vengono ricomposti
+ * dal consumatore. Il consumatore dorme su un eventfd (doorbell) che i
+ * produttori suonano solo se lo trovano addormentato.
+ */
+class BlockQueue {
+public:
+    struct Block {
+        uint32_t sensor = 0;
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+        uint64_t enqueueNs = 0;   // Istante di push (steady clock), per la latenza callback -> consumatore
+    };
+
+    // capacity: numero di slot (potenza di due)
+    BlockQueue(size_t capacity = 1024, size_t slotPayload = 4096);
+    ~BlockQueue();
+
+    BlockQueue(const BlockQueue&) = delete;
+    BlockQueue& operator=(const BlockQueue&) = delete;
+
+    // Produttore (qualsiasi thread): copia il blocco; false se la coda è piena (blocco scartato e contato)
+    bool push(uint32_t sensor, const uint8_t* data, size_t size);
+
+    // Consumatore: blocco più vecchio, valido fino a release()
+    bool front(Block& out);
+    void release();
+
+    // Consumatore: attende dati per al più timeoutMs; ritorna true se ce ne sono
+    bool wait(int timeoutMs);
+
+    uint64_t droppedBlocks() const { return drops.load(std::memory_order_relaxed); }
+
+    static uint64_t nowNs();
+
+private:
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> sequence;
+        uint32_t sensor;
+        uint32_t size;        // Byte del payload in questo slot
+        uint32_t chunks;      // Nel primo slot di un blocco: numero di slot occupati
+        uint64_t enqueueNs;
+    };
+
+    size_t capacity;
+    size_t mask;
+    size_t slotPayload;
+    Slot* slots;
+    uint8_t* payloads;
+
+    alignas(64) std::atomic<uint64_t> tail;       // Produttori
+    alignas(64) uint64_t head;                    // Consumatore
+    uint32_t frontChunks;
+    std::vector<uint8_t> reassembly;
+    alignas(64) std::atomic<bool> sleeping;
+    std::atomic<uint64_t> drops;
+    int eventFd;
+
+    bool ready(uint64_t pos) const;
+    void ringDoorbell();
+};
@@ -0,0 +1,50 @@
+#pragma once
+#include <string>
+#include <map>
+#include <cstdint>
+#include "DeviceStatus.h"
+
+/**
+ * @brief Impronte delle configurazioni applicate, per identità del dispositivo.
+ *
+ * Per ogni scheda (board id e firmware id di hs_datalog_get_identity) si ricordano
+ * l'hash del JSON di configurazione (-f), quello dell'UCF (-u) e l'impronta dello
+ * stato riportato dal dispositivo subito dopo l'ultima applicazione. Alla sessione
+ * successiva, se file e impronta dello stato coincidono, il dispositivo ha già quella
+ * configurazione e il nuovo invio può essere saltato; un dispositivo riavviato o
+ * riconfigurato da altri riporta uno stato diverso e la configurazione viene riapplicata.
+ * L'impronta copre tutto lo stato riportato dal dispositivo (vedi DeviceStatus::digest);
+ * ciò che lo stato non riporta, come il contenuto del programma MLC oltre a ucf_status,
+ * richiede -F dopo una riconfigurazione esterna.
+ * File: JSON in $HOME/.fastgo_device_cache.json (hash in esadecimale).
+ */
+class ConfigCache {
+public:
+    struct Entry {
+        uint64_t config = 0;   // 0: nessun file di configurazione
+        uint64_t ucf = 0;      // 0: nessun UCF
+        uint64_t status = 0;
+    };
+
+    explicit ConfigCache(const std::string& path = defaultPath());
+
+    bool load();
+    bool save() const;
+
+    bool lookup(const std::string& identity, Entry& entry) const;
+    void store(const std::string& identity, const Entry& entry);
+
+    static std::string defaultPath();
+    static std::string identityKey(int boardId, int fwId);
+
+    // FNV-1a a 64 bit (0 riservato a "assente": una stringa vuota dà 0)
+    static uint64_t hash(const std::string& data);
+
+    // Impronta dello stato del dispositivo: tutti i valori riportati, esclusi i campi che
+    // cambiano da soli (ODR misurato, offset, stato del logging e dei tag, acquisizione)
+    static uint64_t statusDigest(const DeviceStatus& status);
+
+private:
+    std::string path;
+    std::map<std::string, Entry> entries;
+};
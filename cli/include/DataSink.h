@@ -0,0 +1,27 @@
+#pragma once
+#include <string>
+#include <cstdint>
+
+/**
+ * @brief Interfaccia per le destinazioni "live" dei blocchi acquisiti.
+ * DataWriter inoltra ogni blocco ricevuto ai sink registrati, oltre a
+ * salvarlo su disco.
+ */
+class DataSink {
+public:
+    virtual ~DataSink() {}
+
+    // Chiamata per ogni blocco grezzo ricevuto dal dispositivo (timestamp host in secondi)
+    virtual void onData(const std::string& sensorName, const uint8_t* data, int size, double timestamp) = 0;
+
+    // Evento discreto (es. cambio di classe MLC, riga JSON): va inoltrato subito, senza accumulo.
+    // Predefinito: come un blocco del canale indicato
+    virtual void onEvent(const std::string& channel, const uint8_t* data, int size, double timestamp) {
+        onData(channel, data, size, timestamp);
+    }
+
+    // Chiamata ad ogni iterazione del loop principale (I/O non bloccante, timer)
+    virtual void poll() {}
+
+    virtual void close() {}
+};
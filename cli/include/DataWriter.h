@@ -1,10 +1,19 @@
 #pragma once
 #include <string>
 #include <map>
+#include <set>
 #include <fstream>
 #include <vector>
 #include <cstdint>
 #include <chrono> 
+#include <memory>
+#include "DataSink.h"
+#include "SegmentFinalizer.h"
+#include "AsyncFileWriter.h"
+#include "SampleDecoder.h"
+#include "UnitConverter.h"
+#include "MlcDecoder.h"
+#include "SparseIndex.h"
 
 /**
  * @brief Gestisce la scrittura dei dati su disco.
@@ -12,6 +21,12 @@
  */
 class DataWriter {
 public:
+    // Formato di uscita dei flussi vettoriali int16 (acc/gyro/mag)
+    enum class OutputCodec {
+        Json,          // <sensore>.json, un oggetto per campione
+        DeltaVarint    // <sensore>.imz, frame delta+zigzag+varint (vedi ImuCodec.h)
+    };
+
     DataWriter(const std::string& outputDir);
     ~DataWriter();
 
@@ -19,18 +34,133 @@ public:
     void writeData(const std::string& sensorName, const uint8_t* data, int size);
     void closeAll();
 
+    // Da impostare prima di initSensorFiles
+    void setCodec(OutputCodec codec);
+
+    // Rotazione dei file per sensore: nuovo segmento ogni maxSeconds secondi o maxBytes byte (0 = disabilitato)
+    void setRotation(double maxSeconds, size_t maxBytes, bool compress);
+
+    // Scrittura asincrona dei file (io_uring o thread pwrite); da chiamare prima di initSensorFiles
+    bool enableAsyncIo();
+
+    // File .dat mappati in memoria (lettura live tramite mmap, vedi MappedOutputStream.h); prima di initSensorFiles
+    bool enableMappedOutput();
+
+    // Valori int16 di acc/gyro/mag nei JSON convertiti in unità fisiche (g, dps, gauss);
+    // la tabella applicata viene salvata in units.json. I flussi .imz restano in conteggi grezzi
+    void enableUnitConversion(const UnitConverter& units);
+
+    // Uscite MLC decodificate in cambi di classe: mlc_events.jsonl (una riga JSON per evento, scritta
+    // a ogni blocco) e pubblicazione immediata sulle destinazioni live (canale <sensore>_events).
+    // I .dat grezzi restano invariati. labelsPath opzionale (vedi MlcDecoder.h)
+    bool enableMlcEvents(const std::vector<std::string>& sensorNames, const DeviceStatus& status,
+                         const std::string& labelsPath);
+
+    // Indice sparso per file (<file>.idx, vedi SparseIndex.h): una voce ogni N campioni; 0 = disabilitato.
+    // Predefinito 1000; da impostare prima di initSensorFiles
+    void setIndexInterval(uint32_t samples);
+
+    // Politica di durabilità (fdatasync periodico, preallocazione, O_DIRECT); abilita la scrittura asincrona
+    bool setDurability(const DurabilityPolicy& policy);
+
+    // Posizione corrente del file di un sensore (byte già scritti, a un confine di blocco)
+    struct StreamPosition {
+        std::string sensor;
+        std::string path;       // Relativo alla cartella di acquisizione (segmento corrente)
+        uint64_t offset = 0;
+    };
+    void getStreamPositions(std::vector<StreamPosition>& out);
+
+    // Evento discreto (riga JSON) inoltrato subito a tutte le destinazioni live
+    void publishEvent(const std::string& channel, const std::string& line, double timestamp);
+
+    // Registra una destinazione live che riceve ogni blocco (non ne acquisisce la proprietà)
+    void addSink(DataSink* sink);
+
+    // Da chiamare una volta per ciclo: invia in un unico lotto le scritture accodate e serve le destinazioni live
+    void poll();
+
 private:
     std::string baseDir;
-    std::map<std::string, std::ofstream> jsonFiles;
-    std::map<std::string, FILE*> binaryFiles;
+    std::map<std::string, std::unique_ptr<std::ostream>> jsonFiles;
+    std::map<std::string, std::unique_ptr<std::ostream>> binaryFiles;
     std::map<std::string, bool> firstSampleMap;
     
     // Mappa per tracciare l'ultimo timestamp ricevuto per ogni sensore 
     std::map<std::string, double> lastBlockEndTime;
 
+    std::vector<DataSink*> sinks;
+
+    // Stato della rotazione dei segmenti
+    struct SegmentState {
+        int index = 0;
+        double startTime = 0.0;
+        size_t bytes = 0;
+        std::string path;
+    };
+    double rotateSeconds;
+    size_t rotateBytes;
+    bool compressSegments;
+    std::map<std::string, SegmentState> segments;
+
+    // Dichiarato prima del finalizzatore: gli stream asincroni si chiudono prima del backend
+    std::unique_ptr<AsyncFileWriter> asyncWriter;
+    std::unique_ptr<SegmentFinalizer> finalizer;
+    double syncInterval;
+    double lastPendingFlush;
+    bool mappedOutput;
+
+    std::unique_ptr<std::ostream> openStream(const std::string& path, bool binary);
+    void openSegment(const std::string& name);
+    void rotateIfNeeded(const std::string& name, size_t incomingBytes);
+
     bool isJsonSensor(const std::string& name);
+    bool isCodecSensor(const std::string& name);
+
+    OutputCodec codec;
+    std::vector<uint8_t> codecBuffer;
+    std::vector<uint16_t> codecScratch;
+    std::vector<int16_t> codecSamples;
+    std::set<std::string> codecFallback;   // Sensori con layout non codificabile, scritti in JSON
+
+    // False se il blocco non è in Formato B (il sensore passa al JSON con leaveCodec)
+    bool writeCodecBlock(const std::string& name, const uint8_t* data, int size);
+    void leaveCodec(const std::string& name);
     
     double getCurrentTimeSec();
 
-    void writeJsonSample(std::ofstream& file, const std::string& name, const uint8_t* sample, bool& isFirst, bool isInt16, bool isTimestampAtEnd = false, double forcedTimestamp = 0.0);
+    // Blocco JSON con layout noto a tempo di compilazione (PacketLayout): decodifica SoA, poi testo.
+    // Ritorna i byte scritti; firstTime riceve il timestamp del primo campione scritto
+    template <typename Layout>
+    size_t writeJsonBlock(std::ostream& file, const uint8_t* data, size_t nSamples, bool& isFirst,
+                        double& firstTime, float scale = 1.0f, double t0 = 0.0, double dt = 0.0);
+    TriaxialBlock decoded;
+    std::vector<char> jsonBuffer;
+    UnitConverter units;
+
+    struct MlcStream {
+        MlcDecoder decoder;
+        std::string channel;
+    };
+    std::map<std::string, std::unique_ptr<MlcStream>> mlcStreams;
+    std::ofstream mlcLog;
+    void writeMlcEvents(MlcStream& stream, const uint8_t* data, int size);
+
+    // Indice del segmento corrente di ogni sensore. Stream standard anche con la scrittura asincrona:
+    // poche voci, chiusura immediata alla rotazione. Gli offset sono contati qui, senza tellp per blocco
+    struct IndexState {
+        std::ofstream file;
+        uint32_t interval = 0;
+        uint64_t bytes = 0;
+        uint64_t samples = 0;
+        uint64_t nextEntry = 0;
+        SparseIndex::Layout layout = SparseIndex::LAYOUT_UNKNOWN;
+    };
+    uint32_t indexInterval;
+    std::map<std::string, std::unique_ptr<IndexState>> indexFiles;
+    void openIndex(const std::string& name, const std::string& path, SparseIndex::Kind kind);
+    // Dopo la scrittura di un blocco di blockBytes byte (voce solo se sono passati abbastanza campioni)
+    // e con il layout dei valori, riportato nell'header al primo blocco
+    void indexBlock(const std::string& name, size_t blockBytes, double sampleTime, uint64_t nSamples,
+                    SparseIndex::Layout layout = SparseIndex::LAYOUT_UNKNOWN);
 };
\ No newline at end of file
@@ -0,0 +1,72 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdint>
+
+/**
+ * @brief Vista compatta dello stato del dispositivo (device status / component status).
+ *
+ * Il JSON viene letto in un solo passaggio SAX, senza costruire il DOM: si tengono
+ * solo le proprietà scalari elencate in FIELDS (alias, ODR, sensibilità, fondo scala,
+ * abilitazioni, formato del campione...) dei componenti, cioè degli oggetti
+ * devices[].components[].<nome> e, per le risposte di un singolo componente,
+ * <nome> alla radice. Tutto il resto (tag, descrizioni, stato del logging) viene
+ * scorso e scartato. I componenti restano nell'ordine del documento.
+ * Nello stesso passaggio si calcola l'impronta dell'intero stato, esclusi i campi
+ * che cambiano da soli (VOLATILE_KEYS): vedi digest().
+ */
+class DeviceStatus {
+public:
+    struct Value {
+        enum Type : uint8_t { Null, Boolean, Integer, Unsigned, Float, String };
+        Type type = Null;
+        bool boolean = false;
+        int64_t integer = 0;
+        uint64_t uinteger = 0;
+        double number = 0.0;
+        std::string text;
+
+        bool isNumber() const { return type == Integer || type == Unsigned || type == Float; }
+        double asNumber() const;
+
+        // Forma JSON del valore (identica a nlohmann::json::dump)
+        std::string dump() const;
+    };
+
+    struct Component {
+        std::string name;
+        std::map<std::string, Value> fields;
+
+        const Value* find(const std::string& key) const;
+        bool has(const std::string& key) const { return fields.count(key) > 0; }
+        double number(const std::string& key, double defaultValue) const;
+        std::string text(const std::string& key, const std::string& defaultValue = "") const;
+    };
+
+    // Proprietà estratte (tutte le altre vengono ignorate)
+    static const char* const FIELDS[];
+
+    // Chiavi escluse dall'impronta con tutto il loro contenuto: ODR misurato, offset dei
+    // timestamp, stato del logging e dei tag, batteria, dati della singola acquisizione
+    static const char* const VOLATILE_KEYS[];
+
+    // False (e stato vuoto) se il JSON non è valido
+    bool parse(const std::string& json);
+
+    const std::vector<Component>& components() const { return list; }
+    const Component* find(const std::string& name) const;
+    bool empty() const { return list.empty(); }
+
+    // Alias della scheda (componente firmware_info), vuoto se assente
+    std::string alias() const;
+
+    // FNV-1a di tutti gli scalari del documento con le chiavi che li contengono, in ordine,
+    // escluso quanto sta sotto VOLATILE_KEYS. 0 se lo stato è vuoto o non valido
+    uint64_t digest() const { return stateDigest; }
+
+private:
+    std::vector<Component> list;
+    std::map<std::string, size_t> byName;
+    uint64_t stateDigest = 0;
+};
@@ -0,0 +1,32 @@
+#pragma once
+#include <string>
+#include <fstream>
+#include "SpectralAnalyzer.h"
+
+/**
+ * @brief Rilevatore di eventi di trasporto a partire dalle feature online.
+ * Gli eventi vengono salvati in events.json come array di oggetti.
+ */
+class EventDetector {
+public:
+    // vibrationThreshold: potenza (g²) oltre la quale inizia un evento di vibrazione
+    EventDetector(const std::string& outputDir, double vibrationThreshold);
+    ~EventDetector();
+
+    void onSpectralFrame(const SpectralFrame& frame);
+    void close();
+
+private:
+    std::ofstream file;
+    bool firstEvent;
+    double vibrationThreshold;
+
+    // Stato dell'evento di vibrazione in corso
+    bool inVibration;
+    double vibrationStart;
+    double vibrationPeak;
+    double vibrationPeakFreq;
+    double lastFrameTs;
+
+    void writeVibrationEvent(double endTs);
+};
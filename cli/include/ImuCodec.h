@@ -0,0 +1,47 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @brief Codec delta + zigzag + varint per flussi int16 triassiali (Formato B).
+ *
+ * Ogni blocco ricevuto dal dispositivo diventa un frame indipendente, così un
+ * lettore può risincronizzarsi cercando il magic al confine di blocco.
+ * Frame (little endian):
+ *   uint32  magic 0x5A445346 ("FSDZ")
+ *   uint32  lunghezza del payload in byte
+ *   uint32  checksum FNV-1a dei byte che seguono (header restante + payload)
+ *   uint16  canali (3)
+ *   uint16  flag (0)
+ *   uint32  numero di campioni
+ *   uint32  header/counter originale del blocco
+ *   float64 timestamp host di inizio blocco
+ *   float64 timestamp host di fine blocco
+ *   payload: per ogni valore, delta rispetto al campione precedente dello stesso
+ *            asse (modulo 2^16), codificato zigzag e poi varint (1-3 byte)
+ */
+namespace ImuCodec {
+
+    const uint32_t FRAME_MAGIC = 0x5A445346;
+    const size_t FRAME_HEADER_SIZE = 40;
+
+    struct FrameInfo {
+        uint32_t channels = 0;
+        uint32_t nSamples = 0;
+        uint32_t deviceHeader = 0;
+        double tStart = 0.0;
+        double tEnd = 0.0;
+    };
+
+    // Accoda a out il frame che codifica nSamples campioni interleaved (x0 y0 z0 x1 ...)
+    void encodeFrame(const int16_t* samples, uint32_t nSamples, uint32_t channels,
+                     uint32_t deviceHeader, double tStart, double tEnd,
+                     std::vector<uint8_t>& out, std::vector<uint16_t>& scratch);
+
+    // Decodifica il frame che inizia in data. Ritorna i byte consumati, 0 se il frame non è valido
+    size_t decodeFrame(const uint8_t* data, size_t size, FrameInfo& info, std::vector<int16_t>& samples);
+
+    // Cerca il prossimo frame valido a partire da offset (risincronizzazione)
+    size_t findNextFrame(const uint8_t* data, size_t size, size_t offset);
+}
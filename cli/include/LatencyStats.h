@@ -0,0 +1,34 @@
+#pragma once
+#include <string>
+#include <cstdint>
+
+/**
+ * @brief Statistiche di latenza di schedulazione (ritardo del risveglio rispetto
+ * a quello richiesto), in microsecondi. Istogramma a bucket fissi: la
+ * registrazione non alloca ed è adatta al ciclo di acquisizione.
+ */
+class LatencyStats {
+public:
+    LatencyStats();
+
+    void record(double latencyUs);
+
+    uint64_t count() const { return samples; }
+    double mean() const { return samples ? sum / samples : 0.0; }
+    double max() const { return maxValue; }
+
+    // Stima del percentile (estremo superiore del bucket che lo contiene)
+    double percentile(double p) const;
+
+    // Riga riassuntiva: n, media, p50, p99, p99.9, max
+    std::string summary() const;
+
+private:
+    static const int BUCKETS = 20;
+    static const double BUCKET_LIMITS[BUCKETS];   // Estremi superiori (us); l'ultimo bucket è aperto
+
+    uint64_t histogram[BUCKETS + 1];
+    uint64_t samples;
+    double sum;
+    double maxValue;
+};
@@ -0,0 +1,78 @@
+#pragma once
+#include <string>
+#include <ostream>
+#include <streambuf>
+#include <atomic>
+#include <cstdint>
+
+class AsyncFileWriter;
+
+/**
+ * @brief File di uscita mappato in memoria per i flussi binari (.dat), solo Linux.
+ *
+ * Il file cresce per estensioni preallocate (fallocate) e ogni blocco viene
+ * copiato direttamente nella mappatura: nessun buffer stdio e nessuna system
+ * call per blocco. Durante la registrazione il file termina con un footer di
+ * 64 byte che riporta la lunghezza dei dati completi, aggiornata con release
+ * dopo ogni blocco; i processi sullo stesso dispositivo possono quindi leggere
+ * i dati in tempo reale mappando il file.
+ *
+ * Footer (little endian, agli ultimi 64 byte del file, st_size - 64):
+ *   0x00 uint32 magic 0x46444D48 ("HMDF")
+ *   0x04 uint32 versione (1)
+ *   0x08 uint64 committed: byte di dati validi dall'inizio del file
+ *   0x10 uint64 capacità dell'estensione corrente (= st_size - 64)
+ *   0x18 uint32 flag (bit 0 = file chiuso)
+ *
+ * Lettura: si legge st_size, si mappa il file e si legge committed (acquire);
+ * se magic vale 0 il file sta crescendo e va riletto st_size. Alla chiusura
+ * il file viene troncato a committed e il footer scompare: il .dat finale è
+ * identico a quello scritto con fwrite.
+ *
+ * Con syncWriter (politica -y) il descrittore entra nel fdatasync periodico del
+ * backend asincrono, che scrive anche le pagine sporcate attraverso la mappatura.
+ * Se la mappatura non può crescere lo stream passa in errore (badbit) e i blocchi
+ * successivi vengono scartati; i dati già scritti restano nel file.
+ */
+class MappedOutputStream : public std::ostream {
+public:
+    static const uint32_t FOOTER_MAGIC = 0x46444D48;
+    static const size_t FOOTER_SIZE = 64;
+
+    MappedOutputStream(const std::string& path, size_t extentSize = 16 * 1024 * 1024,
+                       AsyncFileWriter* syncWriter = nullptr);
+    ~MappedOutputStream();
+
+    void close();
+
+private:
+    struct Footer {
+        uint32_t magic;
+        uint32_t version;
+        std::atomic<uint64_t> committed;
+        uint64_t capacity;
+        uint32_t flags;
+    };
+
+    class MappedBuf : public std::streambuf {
+    public:
+        int fd = -1;
+        uint8_t* base = nullptr;
+        size_t mapSize = 0;
+        size_t capacity = 0;
+        size_t extentSize = 0;
+        uint64_t committed = 0;
+        Footer* footer = nullptr;
+        AsyncFileWriter* syncWriter = nullptr;
+        int syncId = -1;
+
+        bool grow(size_t minCapacity);
+
+    protected:
+        std::streamsize xsputn(const char* s, std::streamsize n) override;
+        int_type overflow(int_type c) override;
+        pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override;
+    };
+
+    MappedBuf buf;
+};
@@ -0,0 +1,100 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+/**
+ * @brief Arena di sessione: allocatore a incremento per la memoria che vive
+ * quanto l'acquisizione (buffer di lavoro, slab dei pool). Nessuna
+ * deallocazione singola: tutto viene rilasciato con l'arena.
+ */
+class Arena {
+public:
+    explicit Arena(size_t chunkSize = 1024 * 1024);
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+    template <typename T>
+    T* allocateArray(size_t count, size_t alignment = alignof(T)) {
+        return static_cast<T*>(allocate(count * sizeof(T), alignment));
+    }
+
+    size_t bytesReserved() const { return reserved; }
+
+private:
+    size_t chunkSize;
+    std::vector<std::unique_ptr<uint8_t[]>> chunks;
+    uint8_t* cursor;
+    uint8_t* limit;
+    size_t reserved;
+};
+
+/**
+ * @brief Pool di blocchi a dimensione fissa con free list intrusiva.
+ * Gli slab vengono presi dall'arena e mai restituiti: a regime acquire/release
+ * non toccano l'heap.
+ */
+class BlockPool {
+public:
+    BlockPool(Arena& arena, size_t blockSize, size_t blocksPerSlab = 32);
+
+    void* acquire();
+    void release(void* block);
+
+    size_t blockSize() const { return size; }
+
+private:
+    struct FreeNode { FreeNode* next; };
+
+    Arena& arena;
+    size_t size;
+    size_t blocksPerSlab;
+    FreeNode* freeList;
+};
+
+/**
+ * @brief Coda FIFO su buffer circolare: a differenza di std::deque non alloca
+ * né libera nodi a regime, la capacità cresce solo (potenze di due).
+ */
+template <typename T>
+class RingQueue {
+public:
+    bool empty() const { return count == 0; }
+    size_t size() const { return count; }
+
+    T& front() { return items[head]; }
+    T& at(size_t i) { return items[(head + i) & (items.size() - 1)]; }
+
+    void push_back(T value) {
+        if (count == items.size()) grow();
+        items[(head + count) & (items.size() - 1)] = std::move(value);
+        count++;
+    }
+
+    void pop_front() {
+        items[head] = T();
+        head = (head + 1) & (items.size() - 1);
+        count--;
+    }
+
+    void clear() {
+        while (count > 0) pop_front();
+    }
+
+private:
+    std::vector<T> items;
+    size_t head = 0;
+    size_t count = 0;
+
+    void grow() {
+        std::vector<T> next(items.empty() ? 16 : items.size() * 2);
+        for (size_t i = 0; i < count; i++) next[i] = std::move(at(i));
+        items.swap(next);
+        head = 0;
+    }
+};
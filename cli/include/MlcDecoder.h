@@ -0,0 +1,63 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdint>
+#include "DeviceStatus.h"
+
+/**
+ * @brief Decodifica delle uscite del Machine Learning Core (componente *_mlc).
+ *
+ * Ogni campione contiene i registri di uscita degli alberi di decisione
+ * (MLC0_SRC...MLCn_SRC, un byte ciascuno, "dim" nello stato del dispositivo);
+ * ogni samples_per_ts campioni segue un timestamp double del dispositivo.
+ * Un gruppo spezzato tra due blocchi viene ricomposto al blocco successivo.
+ * Vengono restituiti solo i cambi di classe: il primo campione fissa lo stato
+ * iniziale di ogni albero, poi un evento per ogni registro che cambia valore.
+ *
+ * Le etichette delle classi sono opzionali, da file JSON:
+ *   { "<albero>": { "<valore registro>": "<etichetta>", ... }, ... }
+ */
+class MlcDecoder {
+public:
+    struct Event {
+        double timestamp;      // Timestamp del dispositivo (o host se il blocco non lo contiene)
+        uint8_t tree;
+        uint8_t value;
+        uint8_t previous;
+        bool initial;          // Primo valore dell'albero (previous non significativo)
+        const std::string* label;   // nullptr se non definita
+    };
+
+    MlcDecoder();
+
+    // Numero di registri e campioni per timestamp del componente, dallo stato del dispositivo
+    void configure(const std::string& sensorName, const DeviceStatus& status);
+
+    bool loadLabels(const std::string& path);
+
+    // Decodifica un blocco; gli eventi restano validi fino al blocco successivo
+    const std::vector<Event>& process(const uint8_t* data, int size, double hostTime);
+
+    // Riga JSON dell'evento (senza a capo), in un buffer riutilizzato
+    const std::string& formatEvent(const Event& event);
+
+    size_t outputCount() const { return outputs; }
+
+private:
+    size_t outputs;
+    size_t samplesPerTs;
+    std::vector<uint8_t> state;
+    bool haveState;
+    std::map<int, std::map<int, std::string>> labels;
+    std::vector<const std::string*> labelTable;   // [albero * 256 + valore], nessuna ricerca per evento
+    std::vector<Event> events;
+    std::string line;
+    std::vector<uint8_t> carry;   // Gruppo incompleto in coda al blocco precedente
+
+    void buildLabelTable();
+    size_t unitSize() const;
+    void resetCarry();
+    void decodeUnit(const uint8_t* unit, double hostTime);
+    void decodeSample(const uint8_t* sample, double timestamp);
+};
@@ -0,0 +1,115 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <functional>
+#include <cstdint>
+#include <future>
+#ifdef __linux__
+    #include <sys/socket.h>
+#endif
+
+/**
+ * @brief Client MQTT 3.1.1 minimale (solo publish) su socket TCP non bloccante.
+ * I pacchetti vengono accodati in un buffer di uscita e inviati da flush(),
+ * così il loop di acquisizione non resta mai bloccato sul broker.
+ *
+ * Anche la connessione è non bloccante: beginConnect() risolve il nome in un thread
+ * a parte (la prima volta), avvia il connect TCP e accoda il CONNECT; service() ne
+ * segue l'avanzamento fino al CONNACK, un passo per chiamata.
+ *
+ * Ogni PUBLISH resta conservato finché non è consegnato (QoS 0: inviato per intero,
+ * QoS 1: PUBACK ricevuto). Se la connessione cade, takeUndelivered() restituisce in
+ * ordine i messaggi non consegnati, segnalando quelli che il broker potrebbe aver
+ * già ricevuto (da ripubblicare con DUP).
+ */
+class MqttClient {
+public:
+    MqttClient();
+    ~MqttClient();
+
+    // Connessione bloccante (al più timeoutMs): solo all'avvio, fuori dal ciclo di acquisizione
+    bool connect(const std::string& host, int port, const std::string& clientId, int keepAliveSec = 30,
+                 int timeoutMs = 3000);
+
+    // Avvia una connessione senza bloccare; l'esito arriva con le chiamate successive a service()
+    void beginConnect(const std::string& host, int port, const std::string& clientId, int keepAliveSec = 30);
+
+    void disconnect();
+    bool isConnected() const { return state == State::Connected; }
+    bool isConnecting() const { return state != State::Connected && state != State::Idle; }
+
+    // Accoda un PUBLISH (qos 0 o 1; dup: nuova consegna di un QoS 1). Ritorna false se non connesso
+    bool publish(const std::string& topic, const uint8_t* payload, size_t len, int qos, bool dup = false);
+
+    // Messaggi non consegnati dopo una disconnessione, dal più vecchio: onMessage(topic, payload,
+    // len, qos, dup). dup: almeno in parte trasmesso, il broker potrebbe averlo già ricevuto
+    using UndeliveredFn = std::function<void(const std::string&, const uint8_t*, size_t, int, bool)>;
+    void takeUndelivered(const UndeliveredFn& onMessage);
+    bool hasUndelivered() const { return retainedHead < retainedList.size(); }
+
+    // Invia i byte in coda e gestisce CONNACK/PUBACK/PINGRESP e keep-alive
+    void service();
+
+    size_t pendingBytes() const { return outBuffer.size() - outOffset; }
+    int inflight() const { return inflightCount; }
+
+private:
+    enum class State { Idle, Resolving, Connecting, AwaitConnack, Connected };
+
+    struct Address {
+#ifdef __linux__
+        sockaddr_storage addr;
+        socklen_t len;
+        int family;
+#endif
+    };
+
+    State state;
+    int sock;
+    std::string host;
+    int port;
+    std::string clientId;
+    std::vector<Address> addresses;   // Risoluzione conservata per le riconnessioni
+    size_t nextAddress;
+    std::future<std::vector<Address>> resolving;
+    double stateDeadline;
+    int keepAlive;
+    uint16_t nextPacketId;
+    int inflightCount;
+    double lastSendTime;
+    double lastReceiveTime;   // Ultimo byte dal broker: senza risposta per 1.5 x keep-alive la connessione è morta
+    bool pingPending;
+
+    std::vector<uint8_t> outBuffer;
+    size_t outOffset;
+    uint64_t sentBase;     // Byte del flusso già usciti da outBuffer (posizione di outBuffer[0])
+    std::vector<uint8_t> inBuffer;
+
+    // PUBLISH non ancora consegnati, in ordine di accodamento (capacità riutilizzata)
+    struct Retained {
+        uint16_t packetId;     // 0 per QoS 0
+        uint64_t streamStart;  // Posizione del pacchetto nel flusso della connessione
+        uint64_t streamEnd;
+        size_t offset;         // In retainedBytes
+        size_t size;
+        bool done;
+    };
+    std::vector<Retained> retainedList;
+    std::vector<uint8_t> retainedBytes;
+    size_t retainedHead;
+
+    void markSent();
+    void markAcked(uint16_t packetId);
+    void compactRetained();
+    void clearRetained();
+
+    void queueHeader(uint8_t type, size_t remainingLength);
+    void queueString(const std::string& s);
+    void flush();
+    void readIncoming();
+    void closeSocket();
+    void startSocket();
+    static std::vector<Address> resolve(const std::string& host, int port);
+    void queueConnect();
+    void stepConnect();
+};
@@ -0,0 +1,79 @@
+#pragma once
+#include <string>
+#include <map>
+#include <vector>
+#include <cstdio>
+#include "DataSink.h"
+#include "MqttClient.h"
+
+/**
+ * @brief Pubblica i blocchi acquisiti su un broker MQTT (es. Mosquitto).
+ *
+ * I blocchi di ciascun sensore vengono accumulati e inviati in un unico PUBLISH
+ * sul topic <prefisso>/<sensore>. Payload (little endian), ripetuto per ogni blocco:
+ *   [float64 timestamp host][uint32 dimensione][dimensione byte grezzi]
+ *
+ * Se il broker non smaltisce i dati (buffer di uscita pieno, troppi QoS 1 in volo,
+ * connessione persa) i batch vengono accodati su un file di spool su disco e
+ * ripubblicati appena il broker torna disponibile. Alla caduta della connessione
+ * i messaggi non consegnati (in coda o QoS 1 senza PUBACK) passano in testa allo
+ * spool, prima dei batch più recenti; quelli forse già ricevuti tornano con DUP.
+ */
+class MqttSink : public DataSink {
+public:
+    MqttSink(const std::string& host, int port, const std::string& topicPrefix,
+             int qos, const std::string& spoolPath);
+    ~MqttSink();
+
+    // Prima connessione (bloccante, al più pochi secondi); i messaggi li scrive il chiamante
+    bool start();
+
+    const std::string& getClientId() const { return clientId; }
+
+    void onData(const std::string& sensorName, const uint8_t* data, int size, double timestamp) override;
+    // Pubblicato subito sul topic <prefisso>/<canale>, fuori dal batching
+    void onEvent(const std::string& channel, const uint8_t* data, int size, double timestamp) override;
+    void poll() override;
+    void close() override;
+
+    // Parametri di batching e backpressure
+    void setBatchLimits(size_t maxBytes, double maxDelaySec);
+
+    // Record dello spool: [uint16 lunghezza topic | 0x8000 se DUP][topic][uint32 lunghezza payload][payload]
+    static void writeSpoolRecord(FILE* f, const std::string& topic, const uint8_t* payload, size_t len, bool dup);
+    static bool readSpoolRecord(FILE* f, std::string& topic, std::vector<uint8_t>& payload, bool& dup);
+
+private:
+    struct Batch {
+        std::string topic;    // Composto una sola volta per sensore
+        std::vector<uint8_t> payload;
+        double firstTimestamp = 0.0;
+    };
+
+    std::string host;
+    int port;
+    std::string topicPrefix;
+    int qos;
+    std::string spoolPath;
+    std::string clientId;     // fastgo<host><pid>: unico anche con più schede sullo stesso broker
+
+    MqttClient client;
+    std::map<std::string, Batch> batches;
+
+    size_t batchMaxBytes;
+    double batchMaxDelay;
+    size_t maxPendingBytes;
+    int maxInflight;
+
+    FILE* spool;
+    long spoolReadPos;
+    long spoolWritePos;
+    double lastReconnect;
+    std::vector<uint8_t> spoolScratch;
+
+    bool brokerReady() const;
+    void publishBatch(const std::string& sensorName, Batch& batch);
+    void writeSpool(const std::string& topic, const std::vector<uint8_t>& payload);
+    void rescueUndelivered();
+    void drainSpool();
+};
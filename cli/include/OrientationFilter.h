@@ -0,0 +1,29 @@
+#pragma once
+
+/**
+ * @brief Filtro AHRS a quaternione (algoritmo di Madgwick).
+ * Stima l'assetto del dispositivo fondendo giroscopio, accelerometro e,
+ * se disponibile, magnetometro. Ogni aggiornamento ha costo fisso.
+ */
+class OrientationFilter {
+public:
+    explicit OrientationFilter(float beta = 0.1f);
+
+    // Aggiornamento completo 9 assi. gyro in rad/s, acc e mag in unità qualsiasi (vengono normalizzati)
+    void update(float gx, float gy, float gz,
+                float ax, float ay, float az,
+                float mx, float my, float mz, float dt);
+
+    // Aggiornamento 6 assi (senza magnetometro)
+    void updateImu(float gx, float gy, float gz,
+                   float ax, float ay, float az, float dt);
+
+    // Angoli di Eulero in gradi (convenzione aerospaziale ZYX)
+    void getEuler(float& roll, float& pitch, float& yaw) const;
+
+    void reset();
+
+private:
+    float beta;
+    float q0, q1, q2, q3;
+};
@@ -0,0 +1,51 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @brief Sketch di quantili a errore relativo (bin logaritmici, tipo DDSketch).
+ *
+ * Ogni valore finisce nel bin ceil(log_gamma(|v|)), con gamma = (1 + a) / (1 - a):
+ * il quantile restituito ha errore relativo al più a. Valori positivi e negativi
+ * hanno bin separati, quelli sotto MIN_VALUE contano come zero. Con più di maxBins
+ * bin per segno vengono fusi quelli di modulo più piccolo, quindi la memoria resta
+ * limitata qualunque sia il numero di campioni. Due sketch con la stessa accuratezza
+ * si fondono sommando i bin (riassunti calcolati a pezzi in parallelo).
+ */
+class QuantileSketch {
+public:
+    explicit QuantileSketch(double relativeAccuracy = 0.01, size_t maxBins = 2048);
+
+    void add(double value);
+    void merge(const QuantileSketch& other);
+    void clear();
+
+    // q in [0, 1]; 0 se lo sketch è vuoto
+    double quantile(double q) const;
+
+    uint64_t count() const { return positive.total + negative.total + zeros; }
+
+private:
+    static constexpr double MIN_VALUE = 1e-9;
+
+    // Bin contigui [offset, offset + bins.size())
+    struct Store {
+        std::vector<uint64_t> bins;
+        int offset = 0;
+        uint64_t total = 0;
+
+        void add(int key, uint64_t n, size_t maxBins);
+        void collapse(size_t maxBins);
+    };
+
+    double gamma;
+    double logGamma;
+    size_t maxBins;
+    Store positive;
+    Store negative;       // Moduli dei valori negativi
+    uint64_t zeros;
+
+    int keyOf(double magnitude) const;
+    double valueOf(int key) const;
+};
@@ -0,0 +1,97 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+/**
+ * @brief Blocco di campioni decodificati in formato SoA (Structure of Arrays).
+ * I flussi scalari (temperatura, pressione) usano solo x. I vettori vengono
+ * riutilizzati tra un blocco e il successivo.
+ */
+struct TriaxialBlock {
+    std::vector<double> t;
+    std::vector<float> x, y, z;
+    size_t count = 0;
+
+    void resize(size_t n) {
+        if (t.size() < n) {
+            t.resize(n); x.resize(n); y.resize(n); z.resize(n);
+        }
+        count = n;
+    }
+};
+
+/**
+ * @brief Layout dei campioni noti, descritti a tempo di compilazione.
+ * La scelta del layout avviene una volta per blocco; il ciclo sui campioni
+ * è specializzato per layout, senza diramazioni, e vettorizzabile.
+ */
+namespace PacketLayout {
+    template <size_t SampleSize, int TimestampOffset, typename Value, size_t ValueOffset, int Axes>
+    struct Layout {
+        static constexpr size_t sampleSize = SampleSize;
+        static constexpr int timestampOffset = TimestampOffset;   // -1: timestamp assegnato dall'host
+        using ValueType = Value;
+        static constexpr size_t valueOffset = ValueOffset;
+        static constexpr int axes = Axes;
+        static constexpr bool embeddedTimestamp = TimestampOffset >= 0;
+
+        static_assert(valueOffset + axes * sizeof(Value) <= sampleSize, "valori oltre la fine del campione");
+        static_assert(!embeddedTimestamp || timestampOffset + sizeof(double) <= sampleSize, "timestamp oltre la fine del campione");
+    };
+
+    // Temperatura / pressione
+    using ScalarFloatTsEnd = Layout<16, 8, float, 4, 1>;     // [4 byte][float valore][double ts]
+    using ScalarFloat      = Layout<12, 0, float, 8, 1>;     // [double ts][float valore]
+    using ScalarInt16      = Layout<10, 0, int16_t, 8, 1>;   // [double ts][int16 valore]
+
+    // Acc / Gyro / Mag
+    using TriaxInt16       = Layout<14, 0, int16_t, 8, 3>;   // [double ts][int16 x y z]
+    using TriaxFloat       = Layout<20, 0, float, 8, 3>;     // [double ts][float x y z]
+    using TriaxInt16Packed = Layout<6, -1, int16_t, 0, 3>;   // Formato B: dopo l'header di 4 byte, terne int16
+
+    const size_t PACKED_HEADER_SIZE = 4;
+}
+
+namespace SampleDecoder {
+    template <typename T>
+    inline T load(const uint8_t* p) {
+        T value;
+        std::memcpy(&value, p, sizeof(T));
+        return value;
+    }
+
+    // Un asse di un layout: passo e offset costanti, un solo tipo -> ciclo vettorizzabile
+    template <typename L, int Axis>
+    inline void decodeAxis(const uint8_t* __restrict data, size_t nSamples, float* __restrict out, float scale) {
+        using V = typename L::ValueType;
+        const uint8_t* base = data + L::valueOffset + Axis * sizeof(V);
+        for (size_t i = 0; i < nSamples; i++) {
+            out[i] = static_cast<float>(load<V>(base + i * L::sampleSize)) * scale;
+        }
+    }
+
+    /**
+     * @brief Decodifica nSamples campioni del layout L in out, moltiplicando i valori per scale.
+     * Per i layout senza timestamp nel campione: t[i] = t0 + i * dt.
+     * Un ciclo per campo (timestamp, x, y, z) invece di uno per campione: cicli separati
+     * senza dipendenze che il compilatore vettorizza (-O3).
+     */
+    template <typename L>
+    inline void decode(const uint8_t* data, size_t nSamples, TriaxialBlock& out,
+                       float scale = 1.0f, double t0 = 0.0, double dt = 0.0) {
+        out.resize(nSamples);
+        double* t = out.t.data();
+        if constexpr (L::embeddedTimestamp) {
+            for (size_t i = 0; i < nSamples; i++) t[i] = load<double>(data + i * L::sampleSize + L::timestampOffset);
+        } else {
+            for (size_t i = 0; i < nSamples; i++) t[i] = t0 + static_cast<double>(i) * dt;
+        }
+        decodeAxis<L, 0>(data, nSamples, out.x.data(), scale);
+        if constexpr (L::axes == 3) {
+            decodeAxis<L, 1>(data, nSamples, out.y.data(), scale);
+            decodeAxis<L, 2>(data, nSamples, out.z.data(), scale);
+        }
+    }
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <string>
+#include <ostream>
+#include <memory>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+/**
+ * @brief Chiusura dei segmenti di file su un thread in background.
+ * Il thread di acquisizione consegna il file ancora aperto; il finalizzatore
+ * chiude l'array JSON, chiude il file, lo comprime (opzionale, gzip in-process con zlib) e
+ * aggiorna manifest.json con l'elenco dei segmenti pronti per l'upload.
+ */
+class SegmentFinalizer {
+public:
+    struct SegmentInfo {
+        std::string sensor;
+        std::string path;
+        int index = 0;
+        double startTime = 0.0;
+        double endTime = 0.0;
+    };
+
+    SegmentFinalizer(const std::string& outputDir, bool compress);
+    ~SegmentFinalizer();
+
+    // jsonArray: il finalizzatore chiude l'array JSON prima di chiudere il file
+    void submit(std::unique_ptr<std::ostream> file, bool jsonArray, const SegmentInfo& info);
+
+    // Attende la finalizzazione di tutti i segmenti e ferma il thread
+    void stop();
+
+private:
+    struct Job {
+        SegmentInfo info;
+        std::unique_ptr<std::ostream> file;
+        bool jsonArray = false;
+    };
+
+    std::string baseDir;
+    bool compress;
+    std::deque<Job> jobs;
+    std::mutex mtx;
+    std::condition_variable cv;
+    bool stopping;
+    std::thread worker;
+
+    // Usato solo dal thread di finalizzazione
+    std::vector<std::string> manifestEntries;
+
+    void run();
+    void finalize(Job& job);
+    void writeManifest();
+};
@@ -2,6 +2,9 @@
 #include <string>
 #include <vector>
 #include "HS_DataLog.h"
+#include "MemoryPool.h"
+#include "BlockQueue.h"
+#include "DeviceStatus.h"
 
 /**
  * @brief Wrapper per la gestione del dispositivo ST SensorTile Box Pro.
@@ -21,7 +24,21 @@ public:
 
     // Recupera informazioni sul dispositivo
     std::string getDeviceAlias();
+
+    // Identità della scheda (board id e firmware id)
+    bool getIdentity(int& boardId, int& fwId);
+
+    // Stato completo del dispositivo. Riusa l'ultimo stato letto (es. da loadUCF) finché
+    // nessun comando di configurazione lo rende obsoleto
     std::string getDeviceStatusJSON();
+
+    // Campi dello stato usati dal programma (vedi DeviceStatus.h), estratti una volta
+    // dallo stato in cache: letto al più una volta per sessione salvo riconfigurazioni
+    const DeviceStatus& getDeviceStatus();
+
+    // Scarta lo stato in cache: la prossima richiesta lo rilegge dal dispositivo
+    // (chiamata da ogni comando che lo modifica: configurazione, UCF, tag, start/stop)
+    void invalidateStatus();
     
     // Carica configurazione da file JSON (buffer)
     bool setDeviceConfig(const std::string& jsonConfig);
@@ -33,15 +50,112 @@ public:
     bool startLog();
     bool stopLog();
 
+    // Classi di tag (componente tags_info): software (sw_tagN) o hardware (hw_tagN)
+    struct TagClass {
+        std::string component;
+        std::string label;
+        bool hardware = false;
+    };
+    std::vector<TagClass> getTagClasses();
+
+    // Rinomina una classe di tag software (es. sw_tag0 -> "pickup")
+    bool setSwTagLabel(const std::string& component, const std::string& label);
+
+    // Inizio/fine di un tag software (per etichetta), durante l'acquisizione
+    bool setSwTag(const std::string& label, bool on);
+
+    // Abilita una classe di tag hardware (ingressi del dispositivo)
+    bool enableHwTag(const std::string& component, bool enable);
+
+    // Informazioni dell'acquisizione, con l'elenco dei tag registrati dal dispositivo
+    std::string getAcquisitionInfoJSON();
+
     // Ottiene la lista dei nomi dei componenti attivi
     std::vector<std::string> getActiveSensors();
 
     // Wrapper per ottenere dati. Ritorna true se ci sono dati, riempie buffer
     bool getData(const std::string& sensorName, std::vector<uint8_t>& buffer, int& actualSize);
 
+    // Alloca un buffer per sensore (allineato alla linea di cache) dimensionato dallo stato del
+    // dispositivo: ODR, dimensione e tipo del campione, campioni per timestamp, dimensione pacchetto USB
+    void prepareBuffers(const std::vector<std::string>& sensors, const DeviceStatus& status);
+
+    // Come getData, ma nel buffer preallocato del sensore (indice nell'elenco di prepareBuffers)
+    bool getData(size_t sensorIndex, const uint8_t*& data, int& actualSize);
+
+    /**
+     * @brief Lettura a lotti di tutti i sensori per risveglio.
+     * Un passaggio di disponibilità su tutti i sensori, poi la lettura di ogni sensore
+     * pronto; i sensori che avevano dati vengono interrogati di nuovo (fino a maxRounds
+     * passaggi) per svuotare i blocchi arrivati a raffica. onBlock(indice, dati, dimensione)
+     * viene chiamata per ogni blocco, prima che il buffer del sensore venga riutilizzato.
+     * Ritorna true se all'ultimo passaggio c'erano ancora dati (conviene non dormire).
+     */
+    template <typename OnBlock>
+    bool readAll(OnBlock&& onBlock, int maxRounds = 4) {
+        for (auto& buf : buffers) buf.available = queryAvailable(buf);
+        for (int round = 0; round < maxRounds; round++) {
+            bool anyReady = false;
+            for (size_t i = 0; i < buffers.size(); i++) {
+                if (buffers[i].available <= 0) continue;
+                anyReady = true;
+                int actualSize = 0;
+                if (readBlock(buffers[i], buffers[i].available, actualSize) && actualSize > 0) {
+                    onBlock(i, static_cast<const uint8_t*>(buffers[i].data), actualSize);
+                }
+            }
+            if (!anyReady) return false;
+            // Nuovo passaggio solo sui sensori appena letti
+            bool more = false;
+            for (auto& buf : buffers) {
+                buf.available = (buf.available > 0) ? queryAvailable(buf) : 0;
+                if (buf.available > 0) more = true;
+            }
+            if (!more) return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Acquisizione a callback (alternativa a readAll).
+     * Registra un callback di dati pronti per ogni sensore di prepareBuffers: i blocchi
+     * vengono copiati nella coda dai thread interni della libreria, senza lock, e il
+     * consumatore li riceve con l'indice del sensore. Da chiamare prima di startLog.
+     */
+    bool enableCallbacks(BlockQueue& queue);
+
+    // Chiamate alla libreria per disponibilità e lettura dati (statistica)
+    uint64_t libraryCallCount() const { return libraryCalls; }
+
     int getDeviceId() const { return deviceID; }
 
 private:
     int deviceID;
     bool connected;
+
+    std::string statusCache;   // Ultimo stato letto, valido se statusValid
+    bool statusValid;
+    DeviceStatus statusFields; // Estratto da statusCache, valido se statusParsed
+    bool statusParsed;
+
+    void storeStatus(const char* json);
+
+    struct SensorBuffer {
+        std::string name;
+        uint8_t* data = nullptr;
+        size_t capacity = 0;
+        int regrowths = 0;
+        int available = 0;
+    };
+    Arena bufferArena;
+    std::vector<SensorBuffer> buffers;
+    uint64_t libraryCalls;
+
+    // Destinazione dei callback (la firma della libreria non prevede un puntatore utente)
+    static SensorDevice* callbackTarget;
+    BlockQueue* callbackQueue;
+    static int onDataReady(int dId, char* compName, uint8_t* data, int size);
+
+    int queryAvailable(SensorBuffer& buf);
+    bool readBlock(SensorBuffer& buf, int size, int& actualSize);
 };
\ No newline at end of file
@@ -0,0 +1,114 @@
+#pragma once
+#include <string>
+#include <map>
+#include <fstream>
+#include <vector>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include "OrientationFilter.h"
+#include "SpectralAnalyzer.h"
+#include "EventDetector.h"
+#include "TaskScheduler.h"
+#include "SampleDecoder.h"
+#include "UnitConverter.h"
+
+/**
+ * @brief Elaborazione online dei blocchi ricevuti dal dispositivo.
+ * Decodifica i flussi vettoriali (Formato B), applica le sensibilità lette
+ * dallo stato del dispositivo e alimenta gli stadi di analisi attivi.
+ */
+class SensorPipeline {
+public:
+    SensorPipeline(const std::string& outputDir);
+    ~SensorPipeline();
+
+    // Legge gli ODR dallo stato del dispositivo (stesso contenuto di acquisition_info.json);
+    // le sensibilità arrivano dalla tabella di conversione già letta dallo stesso stato
+    void configure(const DeviceStatus& status, const UnitConverter& units);
+
+    // Abilita la stima d'assetto con uscita su orientation.json alla frequenza indicata.
+    // Da chiamare dopo configure: false, senza abilitarla, se manca la sensibilità del giroscopio
+    // (Madgwick integrerebbe i conteggi grezzi come velocità angolare)
+    bool enableOrientation(double rateHz);
+
+    // Abilita l'analisi spettrale dell'accelerometro (vibration.json + events.json).
+    // False, senza abilitarla, se la finestra non è valida (vedi isValidSpectralWindow)
+    bool enableSpectral(size_t windowSize, double overlap = 0.5, double vibrationThreshold = 0.05);
+
+    // La FFT richiede una finestra potenza di due di almeno MIN_SPECTRAL_WINDOW punti
+    static constexpr size_t MIN_SPECTRAL_WINDOW = 16;
+    static bool isValidSpectralWindow(size_t windowSize);
+
+    /**
+     * @brief Elaborazione parallela su un pool di thread a furto di lavoro.
+     * Ogni blocco diventa un task sullo strand del proprio sensore (decodifica, spettro);
+     * la stima d'assetto, che combina i tre sensori, ha uno strand dedicato.
+     * Da chiamare dopo gli enable*, prima del primo blocco.
+     */
+    void enableParallel(int threads);
+
+    void processBlock(const std::string& sensorName, const uint8_t* data, int size);
+    void close();
+
+    // Blocchi scartati perché il pool non teneva il passo (solo in modalità parallela)
+    uint64_t droppedBlocks() const { return dropped; }
+
+private:
+    std::string baseDir;
+    UnitConverter units;
+    std::map<std::string, double> odr;
+    std::map<std::string, double> lastBlockEndTime;
+    std::map<std::string, TriaxialBlock> blocks;
+
+    // Stima d'assetto
+    bool orientationEnabled;
+    OrientationFilter orientation;
+    std::ofstream orientationFile;
+    bool firstOrientation;
+    double orientationPeriod;
+    double nextOrientationTs;
+    double lastGyroTs;
+    size_t accCursor, magCursor;
+
+    // Analisi spettrale (creata al primo blocco, quando l'ODR è noto)
+    bool spectralEnabled;
+    size_t spectralWindow;
+    double spectralOverlap;
+    std::unique_ptr<SpectralAnalyzer> spectral;
+    std::unique_ptr<EventDetector> events;
+    std::ofstream vibrationFile;
+    bool firstVibration;
+
+    // Modalità parallela: blocco copiato dal buffer di acquisizione, riciclato a fine elaborazione
+    enum SensorIndex { ACC = 0, GYRO = 1, MAG = 2, SENSOR_COUNT = 3 };
+    struct BlockTask : public TaskScheduler::Task {
+        SensorPipeline* owner = nullptr;
+        int sensor = 0;
+        bool forOrientation = false;
+        double hostTime = 0.0;
+        std::vector<uint8_t> raw;
+        TriaxialBlock decoded;
+        void run() override { owner->runTask(this); }
+    };
+
+    TaskScheduler::Strand sensorStrands[SENSOR_COUNT];
+    TaskScheduler::Strand orientationStrand;
+    std::mutex taskMutex;
+    std::vector<std::unique_ptr<BlockTask>> tasks;
+    std::vector<BlockTask*> freeTasks;
+    TriaxialBlock orientationAcc, orientationMag;
+    uint64_t dropped;
+    // Dichiarato per ultimo: i worker terminano prima che strand e task vengano distrutti
+    std::unique_ptr<TaskScheduler> scheduler;
+
+    void runTask(BlockTask* task);
+    void recycle(BlockTask* task);
+
+    double getCurrentTimeSec();
+
+    bool decodeTriaxial(const std::string& name, const uint8_t* data, int size, double now, TriaxialBlock& out);
+    void runOrientation(const TriaxialBlock& gyro, const TriaxialBlock& acc, const TriaxialBlock& mag);
+    void runSpectral(const TriaxialBlock& acc);
+    void writeSpectralFrame(const SpectralFrame& frame);
+};
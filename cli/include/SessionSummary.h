@@ -0,0 +1,98 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <cstdint>
+#include "QuantileSketch.h"
+#include "SparseIndex.h"
+#include "UnitConverter.h"
+
+/**
+ * @brief Riassunto dell'acquisizione per sensore (summary.json), calcolato a fine sessione.
+ *
+ * I file dei sensori vengono divisi in pezzi ai confini delle voci dell'indice sparso
+ * (<file>.idx) e riassunti in parallelo, su sensori e pezzi, dal pool TaskScheduler.
+ * I pezzi vengono elaborati a ondate di dimensione fissa e fusi in ordine nel riassunto
+ * del sensore: la memoria resta limitata qualunque sia la durata dell'acquisizione
+ * (quantili da QuantileSketch, elenchi di buchi e urti con un massimo di voci).
+ *
+ * Per sensore: campioni, inizio/fine, ODR nominale ed effettivo, min/max/media/percentili
+ * per canale (e del modulo per i flussi vettoriali), intervallo tra campioni, buchi
+ * (intervalli oltre GAP_FACTOR volte il periodo tipico) e, per gli accelerometri,
+ * i picchi di urto oltre la soglia in g. I valori sono convertiti in unità fisiche
+ * quando la sensibilità è nota; i .dat grezzi riportano solo i byte.
+ */
+class SessionSummary {
+public:
+    explicit SessionSummary(const std::string& outputDir);
+    ~SessionSummary();
+
+    // Stato del dispositivo (ODR nominali) e sensibilità; valuesScaled: JSON già in unità fisiche (-n)
+    void configure(const DeviceStatus& status, const UnitConverter& units, bool valuesScaled);
+
+    // Soglia degli urti sul modulo dell'accelerazione, in g (predefinita 2.5)
+    void setShockThreshold(double g) { shockThreshold = g; }
+
+    // Legge gli indici della cartella, riassume i file con threads thread e scrive summary.json
+    bool run(int threads);
+
+    static constexpr double GAP_FACTOR = 5.0;
+    static const size_t MAX_GAPS = 100;
+    static const size_t MAX_SHOCKS = 20;
+
+    struct Gap {
+        double start;
+        double duration;
+    };
+
+    struct Shock {
+        double start;
+        double end;
+        double peak;
+        double peakTime;
+    };
+
+    struct ChannelStats {
+        uint64_t count = 0;
+        double min = 0.0;
+        double max = 0.0;
+        double sum = 0.0;
+        QuantileSketch sketch;
+
+        void add(double v);
+        void merge(const ChannelStats& other);
+    };
+
+    // Riassunto di un pezzo di file (o dell'intero sensore, dopo la fusione)
+    struct Partial {
+        uint64_t samples = 0;
+        uint64_t bytes = 0;
+        double first = 0.0;
+        double last = 0.0;
+        int axes = 0;                  // 1 scalare, 3 vettoriale (0: nessun campione)
+        ChannelStats channels[4];      // value | x, y, z, modulo
+        ChannelStats interval;         // Intervallo tra campioni consecutivi
+        uint64_t gapCount = 0;
+        double gapTotal = 0.0;
+        std::vector<Gap> gaps;         // I più lunghi, al più MAX_GAPS
+        uint64_t shockCount = 0;
+        std::vector<Shock> shocks;     // In ordine di tempo; ridotti ai MAX_SHOCKS picchi a fine fusione
+
+        void clear();
+    };
+
+private:
+    struct SensorJob;
+    struct ChunkTask;
+
+    std::string baseDir;
+    std::map<std::string, double> nominalOdr;
+    UnitConverter units;
+    bool valuesScaled;
+    double shockThreshold;
+    double elapsedMs;
+
+    void merge(SensorJob& job, Partial& chunk);
+    bool writeJson(const std::vector<std::unique_ptr<SensorJob>>& jobs, int threads);
+};
@@ -0,0 +1,66 @@
+#pragma once
+#include <string>
+#include <map>
+#include <atomic>
+#include <cstdint>
+#include "DataSink.h"
+
+/**
+ * @brief Ring buffer in memoria condivisa POSIX (/dev/shm/<nome>), un solo
+ * scrittore e più lettori, senza lock. Ogni blocco ricevuto viene copiato così
+ * com'è, senza serializzazione, per i processi sullo stesso dispositivo
+ * (es. il motore di inferenza Python tramite mmap).
+ *
+ * Layout (little endian):
+ *   Header, 4096 byte
+ *     0x000 uint32 magic 0x52534746 ("FGSR")
+ *     0x004 uint32 versione (1)
+ *     0x008 uint64 capacità dell'area dati in byte (potenza di due)
+ *     0x010 uint64 offset dell'area dati (4096)
+ *     0x018 uint32 numero di sensori registrati
+ *     0x040 uint64 reserve: posizione logica fino a cui lo scrittore sta scrivendo
+ *     0x080 uint64 commit: posizione logica dei dati completi (publish con release)
+ *     0x0C0 uint64 sequenza: numero di record pubblicati
+ *     0x100 tabella sensori: 64 voci da 32 byte (nome terminato da NUL)
+ *   Area dati, capacità byte. Le posizioni logiche crescono sempre: offset = pos % capacità.
+ *     Record (allineato a 8 byte):
+ *       uint32 lunghezza totale del record (header incluso, con padding)
+ *       uint32 indice sensore (0xFFFFFFFF = padding fino a fine buffer)
+ *       uint64 numero di sequenza
+ *       float64 timestamp host (s)
+ *       uint32 dimensione del payload
+ *       uint32 riservato
+ *       payload
+ *
+ * Lettura: si legge commit (acquire), si copiano i record fino a commit e si
+ * rilegge reserve: se reserve - inizio_record > capacità il record è stato
+ * sovrascritto durante la copia e va scartato (lettore troppo lento).
+ */
+class ShmRingSink : public DataSink {
+public:
+    ShmRingSink(const std::string& name, size_t capacity = 8 * 1024 * 1024);
+    ~ShmRingSink();
+
+    bool open();
+
+    void onData(const std::string& sensorName, const uint8_t* data, int size, double timestamp) override;
+    void close() override;
+
+    // Pubblica un record arbitrario (es. frame di feature) su un canale con nome
+    void publish(const std::string& channel, const uint8_t* data, size_t size, double timestamp);
+
+private:
+    std::string name;
+    size_t capacity;
+    size_t mapSize;
+    uint8_t* base;
+    uint8_t* dataArea;
+    std::map<std::string, uint32_t> channelIndex;
+
+    std::atomic<uint64_t>* reservePos;
+    std::atomic<uint64_t>* commitPos;
+    std::atomic<uint64_t>* sequence;
+
+    uint32_t getChannel(const std::string& channel);
+    void copyIn(uint64_t pos, const void* src, size_t len);
+};
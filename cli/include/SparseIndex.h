@@ -0,0 +1,87 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @brief Indice sparso per file dei sensori (<file del segmento>.idx).
+ *
+ * Una voce ogni N campioni (per i .dat ogni RAW_INDEX_BYTES byte), sempre a un
+ * confine di blocco: offset in byte del blocco nel file, numero di campioni che
+ * lo precedono, timestamp host di scrittura e timestamp del primo campione
+ * (quello del campo "timestamp" dei JSON; host per .dat e .imz).
+ * Il tempo host è comune a tutti i sensori e permette di tagliare la stessa
+ * finestra su tutti i file; il tempo dei campioni serve a filtrare dentro i blocchi.
+ * File (little endian): Header da 64 byte, poi Entry da 32 byte in ordine di offset.
+ */
+namespace SparseIndex {
+
+    const char MAGIC[8] = { 'H', 'S', 'D', 'I', 'D', 'X', '1', '\0' };
+    const size_t RAW_INDEX_BYTES = 64 * 1024;
+
+    enum Kind : uint32_t {
+        KIND_JSON = 0,     // <sensore>.json, un oggetto per campione
+        KIND_RAW = 1,      // <sensore>.dat, blocchi grezzi
+        KIND_CODEC = 2     // <sensore>.imz, frame ImuCodec
+    };
+
+    // Forma dei valori nel file, fissata al primo blocco scritto
+    enum Layout : uint32_t {
+        LAYOUT_UNKNOWN = 0,    // Indici precedenti o nessun blocco
+        LAYOUT_COUNTS = 1,     // Conteggi int16 (Formato B, layout a 14 byte): in unità fisiche con la sensibilità
+        LAYOUT_VALUES = 2      // Valori già float dal dispositivo (layout a 20 byte, temperatura, pressione)
+    };
+
+    struct Header {
+        char magic[8];
+        uint32_t interval;     // Campioni tra due voci (byte per KIND_RAW)
+        uint32_t kind;
+        char sensor[44];       // Nome del sensore, terminato da zero
+        uint32_t layout;
+    };
+
+    struct Entry {
+        double hostTime;
+        double sampleTime;
+        uint64_t offset;
+        uint64_t sample;       // Campioni (byte per KIND_RAW) che precedono il blocco
+    };
+
+    static_assert(sizeof(Header) == 64, "Header dell'indice da 64 byte");
+    static_assert(sizeof(Entry) == 32, "Voce dell'indice da 32 byte");
+
+    Header makeHeader(const std::string& sensor, Kind kind, uint32_t interval);
+
+    // Legge l'intero indice (poche voci per MB di dati). False se il file non è un indice valido
+    bool load(const std::string& path, Header& header, std::vector<Entry>& entries);
+
+    // Indice di un file (segmento) dei sensori
+    struct Segment {
+        std::string dataPath;      // <file>.gz se il segmento è stato compresso (-z)
+        bool compressed = false;
+        Header header;
+        std::vector<Entry> entries;
+    };
+
+    // Tutti gli indici non vuoti di una cartella di acquisizione, per sensore, segmenti in ordine
+    // di tempo (solo Linux; vuoto altrove)
+    std::map<std::string, std::vector<Segment>> loadDirectory(const std::string& dir);
+
+    // Byte [begin, end) dei dati del segmento (end oltre la fine: fino alla fine del file). Gli offset
+    // dell'indice sono sui dati non compressi: un .gz viene decompresso dall'inizio fino a begin
+    bool readRange(const Segment& segment, uint64_t begin, uint64_t end, std::vector<char>& out);
+
+    // False se la build non ha zlib: i segmenti compressi non sono leggibili
+    bool canReadCompressed();
+
+    // Ultima voce con hostTime <= t (0 se t precede tutte le voci)
+    size_t lowerEntry(const std::vector<Entry>& entries, double t);
+
+    // Prima voce con hostTime > t (entries.size() se nessuna)
+    size_t upperEntry(const std::vector<Entry>& entries, double t);
+
+    // Tempo dei campioni corrispondente al tempo host t (interpolazione tra le voci vicine)
+    double hostToSampleTime(const std::vector<Entry>& entries, double t);
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <vector>
+#include <complex>
+#include <cstddef>
+
+/**
+ * @brief Risultato dell'analisi di una finestra.
+ * bandEnergy[i] è la potenza (unità²) nella banda [bandEdges[i], bandEdges[i+1]).
+ */
+struct SpectralFrame {
+    double timestamp = 0.0;       // Timestamp dell'ultimo campione della finestra
+    double dominantFreq = 0.0;    // Frequenza del picco spettrale (Hz), DC esclusa
+    double totalEnergy = 0.0;     // Potenza totale della finestra (unità²)
+    std::vector<double> bandEnergy;
+};
+
+/**
+ * @brief FFT reale a finestre (Hann) con sovrapposizione.
+ * Finestra, twiddle e tabella di bit-reversal sono precalcolati nel costruttore:
+ * l'elaborazione di una finestra non esegue allocazioni.
+ */
+class SpectralAnalyzer {
+public:
+    // windowSize deve essere una potenza di due; overlap in [0, 1)
+    SpectralAnalyzer(size_t windowSize, double overlap, double sampleRate,
+                     const std::vector<double>& bandEdges);
+
+    // Accoda un campione. Ritorna true quando è disponibile un nuovo frame
+    bool push(float sample, double timestamp);
+
+    // Analizza direttamente una finestra di windowSize campioni
+    void analyze(const float* samples, double timestamp);
+
+    const SpectralFrame& frame() const { return result; }
+    size_t getWindowSize() const { return windowSize; }
+    size_t getHopSize() const { return hopSize; }
+    double getSampleRate() const { return sampleRate; }
+
+private:
+    size_t windowSize;
+    size_t hopSize;
+    double sampleRate;
+    std::vector<double> bandEdges;
+
+    std::vector<float> window;
+    double windowPower;
+
+    // Buffer circolare di ingresso
+    std::vector<float> ring;
+    size_t ringPos;
+    size_t filled;
+    size_t sinceLast;
+
+    // Scratch precalcolati per la FFT complessa di N/2 punti
+    std::vector<float> frameData;
+    std::vector<std::complex<float>> fftBuffer;
+    std::vector<std::complex<float>> twiddles;
+    std::vector<size_t> bitReverse;
+    std::vector<size_t> bandOfBin;
+
+    SpectralFrame result;
+
+    void fftInPlace();
+};
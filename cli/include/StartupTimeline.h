@@ -0,0 +1,60 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <mutex>
+#include <chrono>
+
+/**
+ * @brief Cronologia dell'avvio, dal lancio del programma al primo campione.
+ *
+ * Ogni fase registra inizio e durata (ms dall'origine) e la corsia in cui è stata
+ * eseguita: "device" per i comandi al dispositivo (serializzati dalla libreria e
+ * dall'USB), "host" per il lavoro sul PC (file, cartella, parsing dello stato,
+ * apertura dei file, destinazioni live), per lo più in parallelo ai comandi, e
+ * "wait" per l'attesa di quel lavoro prima dell'avvio del logging. Thread-safe.
+ */
+class StartupTimeline {
+public:
+    StartupTimeline();
+
+    // Fase misurata dalla costruzione alla distruzione (o a end())
+    class Phase {
+    public:
+        Phase(StartupTimeline& timeline, const char* name, const char* lane);
+        ~Phase();
+        void end();
+
+    private:
+        StartupTimeline& timeline;
+        const char* name;
+        const char* lane;
+        double startMs;
+        bool open;
+    };
+
+    // Evento istantaneo (es. "first_sample")
+    void mark(const char* name);
+
+    double elapsedMs() const;
+
+    // Tabella delle fasi in ordine di inizio, con il tempo occupato per corsia
+    std::string summary() const;
+
+    // Scrive la cronologia in JSON (startup_timeline.json)
+    bool writeJson(const std::string& path) const;
+
+private:
+    struct Entry {
+        std::string name;
+        std::string lane;
+        double startMs;
+        double durationMs;
+    };
+
+    std::chrono::steady_clock::time_point origin;
+    mutable std::mutex mutex;
+    std::vector<Entry> entries;
+
+    void add(const char* name, const char* lane, double startMs, double durationMs);
+    std::vector<Entry> sorted() const;
+};
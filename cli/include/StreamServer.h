@@ -0,0 +1,113 @@
+#pragma once
+#include <string>
+#include <map>
+#include <set>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include "DataSink.h"
+#include "MemoryPool.h"
+
+/**
+ * @brief Server di streaming locale su socket Unix (epoll, non bloccante).
+ *
+ * Un client si connette e invia una riga di sottoscrizione:
+ *   SUBSCRIBE <sensore1,sensore2,...|*> [binary|ndjson]\n
+ * (oppure TAG <etichetta> [on|off]\n per annotare l'acquisizione, vedi setTagHandler)
+ * e riceve da quel momento i blocchi dei sensori scelti:
+ *   binary: [uint32 lunghezza][uint16 len nome][nome][float64 timestamp][byte grezzi]
+ *   ndjson: {"sensor": "...", "timestamp": ..., "data": "<base64 dei byte grezzi>"}\n
+ *
+ * Ogni blocco viene serializzato una sola volta per formato e condiviso tra
+ * tutti i client tramite buffer a conteggio di riferimenti, presi da pool per
+ * classe di dimensione (nessuna allocazione a regime). Un client che
+ * accumula più di maxQueuedBytes viene gestito secondo la SlowPolicy.
+ */
+class StreamServer : public DataSink {
+public:
+    enum class SlowPolicy {
+        Disconnect,   // Il client lento viene disconnesso
+        DropFrames    // I nuovi blocchi per il client lento vengono scartati
+    };
+
+    StreamServer(const std::string& socketPath, SlowPolicy policy = SlowPolicy::Disconnect,
+                 size_t maxQueuedBytes = 4 * 1024 * 1024);
+    ~StreamServer();
+
+    bool start();
+
+    // Comando TAG ricevuto da un client: stato 1 (on), 0 (off) o -1 (commuta)
+    using TagHandler = std::function<void(const std::string& label, int state)>;
+    void setTagHandler(TagHandler handler) { tagHandler = std::move(handler); }
+
+    void onData(const std::string& sensorName, const uint8_t* data, int size, double timestamp) override;
+    void poll() override;
+    void close() override;
+
+private:
+    // Intestazione del buffer di un frame; i dati seguono l'intestazione
+    struct FrameBuffer {
+        BlockPool* pool;      // nullptr: blocco fuori classe, allocato sull'heap
+        uint32_t refs;
+        uint32_t size;
+        uint8_t* data() { return reinterpret_cast<uint8_t*>(this + 1); }
+    };
+
+    // Riferimento a un frame (conteggio non atomico: il server è usato da un solo thread)
+    class Frame {
+    public:
+        Frame() : buf(nullptr) {}
+        explicit Frame(FrameBuffer* b) : buf(b) {}
+        Frame(const Frame& o) : buf(o.buf) { if (buf) buf->refs++; }
+        Frame(Frame&& o) noexcept : buf(o.buf) { o.buf = nullptr; }
+        Frame& operator=(Frame o) { std::swap(buf, o.buf); return *this; }
+        ~Frame();
+
+        explicit operator bool() const { return buf != nullptr; }
+        const uint8_t* data() const { return buf->data(); }
+        size_t size() const { return buf->size; }
+
+        // Solo durante la serializzazione, prima che il frame sia condiviso
+        uint8_t* writableData() { return buf->data(); }
+
+    private:
+        FrameBuffer* buf;
+    };
+
+    struct Client {
+        int fd = -1;
+        bool subscribed = false;
+        bool allSensors = false;
+        bool ndjson = false;
+        std::set<std::string> sensors;
+        std::string command;
+        RingQueue<Frame> queue;
+        size_t queuedBytes = 0;
+        size_t frontOffset = 0;
+        size_t droppedFrames = 0;
+        bool slow = false;
+    };
+
+    std::string socketPath;
+    SlowPolicy policy;
+    size_t maxQueuedBytes;
+    int listenFd;
+    int epollFd;
+    TagHandler tagHandler;
+
+    // Dichiarati prima dei client: i frame in coda tornano ai pool prima della loro distruzione
+    Arena arena;
+    std::vector<std::unique_ptr<BlockPool>> framePools;
+    std::map<int, Client> clients;
+
+    Frame allocateFrame(size_t size);
+
+    void acceptClients();
+    void readCommands(Client& client);
+    bool flushClient(Client& client);
+    void dropClient(int fd);
+
+    Frame makeBinaryFrame(const std::string& sensorName, const uint8_t* data, int size, double timestamp);
+    Frame makeJsonFrame(const std::string& sensorName, const uint8_t* data, int size, double timestamp);
+};
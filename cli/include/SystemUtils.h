@@ -1,5 +1,6 @@
 #pragma once
 #include <string>
+#include <vector>
 #include <atomic>
 
 // Flag  per la gestione sicura dell'interruzione (SIGINT/SIGTERM) tra thread
@@ -30,8 +31,53 @@ namespace SystemUtils {
      */
     bool createDirectory(const std::string& path);
 
+    /**
+     * @brief Rimuove una directory vuota (es. cartella dell'acquisizione mai avviata).
+     */
+    bool removeDirectory(const std::string& path);
+
     /**
      * @brief Sleep cross-platform in millisecondi.
      */
     void sleepMs(int milliseconds);
+
+    /**
+     * @brief Ruoli dei thread ai fini di affinità e priorità.
+     */
+    enum class ThreadRole {
+        Acquisition,   // Ciclo principale di lettura dal dispositivo
+        Writer,        // Scrittura su disco, sincronizzazione e finalizzazione dei segmenti
+        Dsp            // Elaborazione del segnale
+    };
+
+    /**
+     * @brief Interpreta un elenco di core (es. "2", "1,3", "0-3").
+     */
+    std::vector<int> parseCpuList(const std::string& list);
+
+    /**
+     * @brief Imposta i core assegnati a un ruolo (vuoto = nessun vincolo).
+     * Da chiamare prima che i thread del ruolo vengano creati e prima di applyThreadRole:
+     * la prima chiamata salva l'affinità del processo.
+     */
+    void setRoleCpus(ThreadRole role, const std::vector<int>& cpus);
+
+    /**
+     * @brief Applica al thread corrente l'affinità del suo ruolo; un ruolo senza core
+     * torna all'affinità del processo (altrimenti erediterebbe quella del thread creatore).
+     * I thread diversi da quello di acquisizione tornano a SCHED_OTHER (altrimenti
+     * erediterebbero SCHED_FIFO).
+     */
+    void applyThreadRole(ThreadRole role);
+
+    /**
+     * @brief Porta il thread corrente in SCHED_FIFO con la priorità indicata (1-99).
+     * @return false se non permesso (serve CAP_SYS_NICE o un limite RLIMIT_RTPRIO adeguato).
+     */
+    bool setRealtimePriority(int priority);
+
+    /**
+     * @brief Blocca in RAM la memoria attuale e futura del processo (mlockall).
+     */
+    bool lockMemory();
 }
\ No newline at end of file
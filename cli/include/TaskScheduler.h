@@ -0,0 +1,79 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include "MemoryPool.h"
+
+/**
+ * @brief Pool di thread a furto di lavoro (work stealing) per l'elaborazione dei blocchi.
+ *
+ * Il lavoro è organizzato in Strand (tipicamente uno per sensore): i task di uno
+ * strand vengono eseguiti nell'ordine di invio e mai in parallelo tra loro, mentre
+ * strand diversi girano in parallelo. Uno strand con task in attesa viene accodato al
+ * worker che lo ha eseguito per ultimo (cache calda); i worker senza lavoro lo rubano
+ * dalle code degli altri, così un sensore veloce non resta legato a un solo core.
+ */
+class TaskScheduler {
+public:
+    class Task {
+    public:
+        virtual ~Task() {}
+        // Può reinviare il task stesso (anche su un altro strand) o riciclarlo
+        virtual void run() = 0;
+
+    private:
+        friend class TaskScheduler;
+        Task* next = nullptr;
+    };
+
+    class Strand {
+    private:
+        friend class TaskScheduler;
+        std::mutex mutex;
+        Task* head = nullptr;
+        Task* tail = nullptr;
+        bool scheduled = false;   // In una coda dei worker o in esecuzione
+        int lastWorker = -1;
+    };
+
+    explicit TaskScheduler(int threads);
+    ~TaskScheduler();
+
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    void submit(Strand& strand, Task* task);
+
+    // Attende il completamento di tutti i task inviati (compresi quelli reinviati dai task)
+    void wait();
+
+    int threadCount() const { return static_cast<int>(workers.size()); }
+    uint64_t stolenCount() const { return steals.load(std::memory_order_relaxed); }
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        RingQueue<Strand*> queue;
+        std::thread thread;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::mutex idleMutex;
+    std::condition_variable idleCv;
+    std::condition_variable doneCv;
+    std::atomic<int> runnable;        // Strand nelle code dei worker
+    std::atomic<int> sleepers;
+    std::atomic<uint64_t> pending;    // Task inviati e non ancora completati
+    std::atomic<uint64_t> steals;
+    std::atomic<unsigned> nextWorker;
+    bool stopping;
+
+    void run(int index);
+    Strand* take(int index);
+    void execute(Strand* strand, int index);
+    void enqueue(Strand* strand, int worker);
+};
@@ -0,0 +1,35 @@
+#pragma once
+#include <string>
+#include <map>
+#include "DeviceStatus.h"
+
+/**
+ * @brief Fattori di conversione in unità fisiche dei flussi vettoriali.
+ * Sensibilità e fondo scala di acc/gyro/mag vengono letti una sola volta dallo
+ * stato del dispositivo (stesso contenuto di acquisition_info.json):
+ *   valore fisico = conteggio int16 * sensibilità   (g, dps, gauss)
+ */
+class UnitConverter {
+public:
+    struct SensorUnits {
+        double sensitivity = 1.0;  // Unità per LSB
+        double fullScale = 0.0;    // Fondo scala ("fs"), 0 se non presente
+        std::string unit;
+    };
+
+    void configure(const DeviceStatus& status);
+
+    // nullptr se il sensore non è convertibile (nome non vettoriale o sensibilità assente)
+    const SensorUnits* find(const std::string& sensorName) const;
+
+    // Fattore da applicare ai conteggi del sensore (defaultValue se non noto)
+    float scaleFor(const std::string& sensorName, float defaultValue = 1.0f) const;
+
+    // Tabella delle conversioni applicate (units.json nella cartella di acquisizione)
+    bool writeSummary(const std::string& path) const;
+
+    bool empty() const { return sensors.empty(); }
+
+private:
+    std::map<std::string, SensorUnits> sensors;
+};
@@ -0,0 +1,74 @@
+#include "AllocCounter.h"
+
+#ifdef HSD_COUNT_ALLOCATIONS
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <cstddef>
+
+namespace {
+    std::atomic<uint64_t> g_allocations(0);
+    std::atomic<uint64_t> g_bytes(0);
+
+    void* countedAlloc(std::size_t size, std::size_t alignment) {
+        g_allocations.fetch_add(1, std::memory_order_relaxed);
+        g_bytes.fetch_add(size, std::memory_order_relaxed);
+        if (size == 0) size = 1;
+        void* p = nullptr;
+        if (alignment <= alignof(std::max_align_t)) {
+            p = std::malloc(size);
+        } else if (posix_memalign(&p, alignment, size) != 0) {
+            p = nullptr;
+        }
+        return p;
+    }
+}
+
+bool AllocCounter::enabled() { return true; }
+uint64_t AllocCounter::allocations() { return g_allocations.load(std::memory_order_relaxed); }
+uint64_t AllocCounter::bytes() { return g_bytes.load(std::memory_order_relaxed); }
+
+void* operator new(std::size_t size) {
+    void* p = countedAlloc(size, alignof(std::max_align_t));
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void* operator new[](std::size_t size) {
+    void* p = countedAlloc(size, alignof(std::max_align_t));
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void* operator new(std::size_t size, std::align_val_t al) {
+    void* p = countedAlloc(size, static_cast<std::size_t>(al));
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void* operator new[](std::size_t size, std::align_val_t al) {
+    void* p = countedAlloc(size, static_cast<std::size_t>(al));
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return countedAlloc(size, alignof(std::max_align_t));
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return countedAlloc(size, alignof(std::max_align_t));
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
+#else
+
+bool AllocCounter::enabled() { return false; }
+uint64_t AllocCounter::allocations() { return 0; }
+uint64_t AllocCounter::bytes() { return 0; }
+
+#endif
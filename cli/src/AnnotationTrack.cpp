@@ -0,0 +1,132 @@
+#include "AnnotationTrack.h"
+#include <iostream>
+#include <cstdio>
+#include "json.hpp"
+
+AnnotationTrack::AnnotationTrack(const std::string& outputDir)
+    : baseDir(outputDir), deviceTags("[]") {}
+
+AnnotationTrack::~AnnotationTrack() {
+    if (log.is_open()) log.close();
+}
+
+bool AnnotationTrack::open() {
+    log.open(baseDir + "/annotations.jsonl", std::ios::out | std::ios::trunc);
+    if (!log) {
+        std::cerr << "[Tags] Cannot create annotations.jsonl\n";
+        return false;
+    }
+    return true;
+}
+
+bool AnnotationTrack::isActive(const std::string& label) const {
+    return openTags.count(label) > 0;
+}
+
+void AnnotationTrack::appendEscaped(std::string& out, const std::string& text) {
+    for (char c : text) {
+        if (c == '"' || c == '\\') out += '\\';
+        if (static_cast<unsigned char>(c) >= 0x20) out += c;
+    }
+}
+
+const std::string& AnnotationTrack::record(const std::string& label, bool on, const char* source, double timestamp,
+                                           const std::vector<DataWriter::StreamPosition>& positions) {
+    char buf[64];
+    line.assign("{ \"timestamp\": ");
+    std::snprintf(buf, sizeof(buf), "%.6f", timestamp);
+    line += buf;
+    line += ", \"label\": \"";
+    appendEscaped(line, label);
+    line += on ? "\", \"state\": \"on\"" : "\", \"state\": \"off\"";
+    line += ", \"source\": \"";
+    line += source;
+    line += "\", \"files\": {";
+    for (size_t i = 0; i < positions.size(); i++) {
+        line += (i == 0) ? " \"" : ", \"";
+        appendEscaped(line, positions[i].sensor);
+        line += "\": { \"path\": \"";
+        appendEscaped(line, positions[i].path);
+        std::snprintf(buf, sizeof(buf), "\", \"offset\": %llu }",
+                      static_cast<unsigned long long>(positions[i].offset));
+        line += buf;
+    }
+    line += " } }";
+
+    if (log.is_open()) {
+        log << line << '\n';
+        log.flush();
+    }
+
+    // Intervalli: un secondo "on" sullo stesso tag non riapre l'intervallo, un "off" senza "on" è ignorato
+    auto it = openTags.find(label);
+    if (on && it == openTags.end()) {
+        Interval& interval = openTags[label];
+        interval.label = label;
+        interval.source = source;
+        interval.start = timestamp;
+        interval.startPositions = positions;
+    } else if (!on && it != openTags.end()) {
+        it->second.end = timestamp;
+        it->second.endPositions = positions;
+        intervals.push_back(std::move(it->second));
+        openTags.erase(it);
+    }
+    return line;
+}
+
+std::vector<std::string> AnnotationTrack::activeLabels() const {
+    std::vector<std::string> labels;
+    for (const auto& pair : openTags) labels.push_back(pair.first);
+    return labels;
+}
+
+void AnnotationTrack::setDeviceTags(const std::string& acquisitionInfoJson) {
+    auto info = nlohmann::json::parse(acquisitionInfoJson, nullptr, false);
+    if (info.is_discarded()) return;
+    // Il dispositivo elenca i tag eseguiti in "tags" (eventualmente dentro "acquisition_info")
+    const nlohmann::json* node = &info;
+    if (node->contains("acquisition_info")) node = &(*node)["acquisition_info"];
+    if (node->contains("tags") && (*node)["tags"].is_array()) deviceTags = (*node)["tags"].dump();
+}
+
+bool AnnotationTrack::writeIndex() {
+    if (log.is_open()) log.close();
+
+    nlohmann::json index;
+    index["intervals"] = nlohmann::json::array();
+    for (const auto& interval : intervals) {
+        nlohmann::json entry;
+        entry["label"] = interval.label;
+        entry["source"] = interval.source;
+        entry["start"] = interval.start;
+        entry["end"] = interval.end;
+        entry["duration"] = interval.end - interval.start;
+
+        nlohmann::json files = nlohmann::json::object();
+        for (const auto& start : interval.startPositions) {
+            nlohmann::json file;
+            file["start_path"] = start.path;
+            file["start_offset"] = start.offset;
+            // Fine sullo stesso sensore (il file può essere stato ruotato nel frattempo)
+            for (const auto& end : interval.endPositions) {
+                if (end.sensor != start.sensor) continue;
+                file["end_path"] = end.path;
+                file["end_offset"] = end.offset;
+            }
+            files[start.sensor] = file;
+        }
+        entry["files"] = files;
+        index["intervals"].push_back(entry);
+    }
+    index["device_tags"] = nlohmann::json::parse(deviceTags, nullptr, false);
+    if (index["device_tags"].is_discarded()) index["device_tags"] = nlohmann::json::array();
+
+    std::ofstream out(baseDir + "/annotations_index.json");
+    if (!out) {
+        std::cerr << "[Tags] Cannot write annotations_index.json\n";
+        return false;
+    }
+    out << index.dump(4);
+    return true;
+}
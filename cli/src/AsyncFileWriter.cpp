@@ -0,0 +1,396 @@
+#include "AsyncFileWriter.h"
+#include "SystemUtils.h"
+#include <iostream>
+#include <cstring>
+#include <chrono>
+
+#ifdef __linux__
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <cerrno>
+#endif
+
+// --- AsyncFileWriter ---
+
+AsyncFileWriter::AsyncFileWriter(size_t bufferSize, size_t nBuffers)
+    : bufferSize(bufferSize), registeredBuffers(nBuffers), pendingTotal(0), syscalls(0), syncs(0), syncStopping(false) {
+    addBuffers(nBuffers);
+}
+
+AsyncFileWriter::~AsyncFileWriter() {
+    stopSyncThread();
+}
+
+void AsyncFileWriter::setDurability(const DurabilityPolicy& newPolicy) {
+    policy = newPolicy;
+#ifdef __linux__
+    if (policy.syncIntervalSec > 0.0 && !syncThread.joinable()) {
+        syncThread = std::thread(&AsyncFileWriter::syncRun, this);
+    }
+#endif
+}
+
+void AsyncFileWriter::stopSyncThread() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        syncStopping = true;
+    }
+    syncCv.notify_all();
+    if (syncThread.joinable()) syncThread.join();
+}
+
+void AsyncFileWriter::addBuffers(size_t count) {
+    // Un unico blocco allineato a 4 KB per gruppo di buffer
+    storage.emplace_back(new uint8_t[count * bufferSize + BUFFER_ALIGNMENT]);
+    uintptr_t raw = reinterpret_cast<uintptr_t>(storage.back().get());
+    uint8_t* base = reinterpret_cast<uint8_t*>((raw + BUFFER_ALIGNMENT - 1) & ~(uintptr_t)(BUFFER_ALIGNMENT - 1));
+
+    for (size_t i = 0; i < count; i++) {
+        Buffer b;
+        b.data = base + i * bufferSize;
+        b.capacity = bufferSize;
+        b.index = static_cast<int>(buffers.size());
+        buffers.push_back(b);
+        freeBuffers.push_back(&buffers.back());
+    }
+}
+
+std::unique_ptr<AsyncFileWriter> AsyncFileWriter::create(size_t bufferSize, size_t nBuffers, bool preferUring) {
+#ifdef __linux__
+    std::unique_ptr<AsyncFileWriter> writer;
+    if (preferUring) {
+        writer.reset(new UringFileWriter(bufferSize, nBuffers));
+        if (writer->init()) return writer;
+    }
+
+    writer.reset(new ThreadFileWriter(bufferSize, nBuffers));
+    if (writer->init()) return writer;
+#else
+    (void)bufferSize;
+    (void)nBuffers;
+    (void)preferUring;
+#endif
+    return nullptr;
+}
+
+#ifdef __linux__
+
+int AsyncFileWriter::openFile(const std::string& path) {
+    int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+    bool direct = policy.directIo;
+    int fd = ::open(path.c_str(), direct ? flags | O_DIRECT : flags, 0644);
+    if (fd < 0 && direct && errno == EINVAL) {
+        // File system senza supporto O_DIRECT (es. tmpfs)
+        direct = false;
+        fd = ::open(path.c_str(), flags, 0644);
+    }
+    if (fd < 0) return -1;
+
+    if (policy.preallocateBytes > 0) {
+        // KEEP_SIZE: la dimensione del file resta quella dei dati scritti anche se la sessione si interrompe
+        fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(policy.preallocateBytes));
+    }
+
+    std::lock_guard<std::mutex> lock(mtx);
+    FileState state;
+    state.fd = fd;
+    state.direct = direct;
+    return addFileLocked(state);
+}
+
+int AsyncFileWriter::addFileLocked(const FileState& state) {
+    // Con la rotazione (-r/-b) si apre un file per segmento: gli slot chiusi vengono riusati,
+    // così files (e la scansione del fdatasync periodico) resta grande quanto i file aperti
+    if (!freeFiles.empty()) {
+        int file = freeFiles.back();
+        freeFiles.pop_back();
+        files[file] = state;
+        return file;
+    }
+    files.push_back(state);
+    return static_cast<int>(files.size() - 1);
+}
+
+void AsyncFileWriter::closeFile(int file) {
+    std::unique_lock<std::mutex> lock(mtx);
+    if (file < 0 || file >= static_cast<int>(files.size()) || files[file].fd < 0) return;
+    while (files[file].pending > 0) submitLocked(true, lock);
+    while (files[file].syncing > 0) cv.wait(lock);
+    if (policy.syncIntervalSec > 0.0 && files[file].dirty) {
+        fdatasync(files[file].fd);
+        syncs++;
+    }
+    ::close(files[file].fd);
+    files[file].fd = -1;
+    freeFiles.push_back(file);
+}
+
+int AsyncFileWriter::watchFile(int fd) {
+    if (fd < 0 || policy.syncIntervalSec <= 0.0) return -1;
+    std::lock_guard<std::mutex> lock(mtx);
+    FileState state;
+    state.fd = fd;
+    state.external = true;
+    return addFileLocked(state);
+}
+
+void AsyncFileWriter::unwatchFile(int file) {
+    std::unique_lock<std::mutex> lock(mtx);
+    if (file < 0 || file >= static_cast<int>(files.size()) || !files[file].external || files[file].fd < 0) return;
+    while (files[file].syncing > 0) cv.wait(lock);
+    files[file].fd = -1;
+    freeFiles.push_back(file);
+}
+
+void AsyncFileWriter::syncRun() {
+    SystemUtils::applyThreadRole(SystemUtils::ThreadRole::Writer);
+    auto interval = std::chrono::duration<double>(policy.syncIntervalSec);
+    std::unique_lock<std::mutex> lock(mtx);
+    while (!syncStopping) {
+        syncCv.wait_for(lock, interval);
+        if (syncStopping) break;
+
+        std::vector<int> toSync;
+        for (size_t i = 0; i < files.size(); i++) {
+            if (files[i].fd >= 0 && (files[i].dirty || files[i].external)) {
+                files[i].dirty = false;
+                files[i].syncing++;
+                toSync.push_back(static_cast<int>(i));
+            }
+        }
+        if (toSync.empty()) continue;
+
+        // fdatasync fuori dal lock: acquisizione e invio delle scritture proseguono
+        std::vector<int> fds;
+        for (int i : toSync) fds.push_back(files[i].fd);
+        lock.unlock();
+        for (int fd : fds) fdatasync(fd);
+        lock.lock();
+
+        for (int i : toSync) files[i].syncing--;
+        syncs += toSync.size();
+        cv.notify_all();
+    }
+}
+
+#else
+
+int AsyncFileWriter::openFile(const std::string&) { return -1; }
+void AsyncFileWriter::closeFile(int) {}
+int AsyncFileWriter::watchFile(int) { return -1; }
+void AsyncFileWriter::unwatchFile(int) {}
+
+#endif
+
+AsyncFileWriter::Buffer* AsyncFileWriter::acquireBuffer() {
+    std::unique_lock<std::mutex> lock(mtx);
+    while (freeBuffers.empty()) {
+        // Pool esaurito: si attende un completamento; se nulla è in volo i buffer sono
+        // tutti trattenuti dagli stream aperti e il pool deve crescere
+        if (pendingTotal > 0) submitLocked(true, lock);
+        else addBuffers(4);
+    }
+    Buffer* b = freeBuffers.back();
+    freeBuffers.pop_back();
+    return b;
+}
+
+void AsyncFileWriter::releaseBuffer(Buffer* buffer) {
+    std::lock_guard<std::mutex> lock(mtx);
+    freeBuffers.push_back(buffer);
+}
+
+void AsyncFileWriter::submit(int file, Buffer* buffer, size_t len) {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (len == 0 || file < 0) {
+        freeBuffers.push_back(buffer);
+        return;
+    }
+    FileState& f = files[file];
+#ifdef __linux__
+    if (f.direct && ((f.offset | len) & (BUFFER_ALIGNMENT - 1)) != 0) {
+        // Coda non allineata (chiusura del file): il resto del file prosegue senza O_DIRECT
+        fcntl(f.fd, F_SETFL, fcntl(f.fd, F_GETFL) & ~O_DIRECT);
+        f.direct = false;
+    }
+#endif
+    uint64_t offset = f.offset;
+    f.offset += len;
+    f.pending++;
+    pendingTotal++;
+    enqueueLocked(file, buffer, len, offset);
+}
+
+void AsyncFileWriter::flush() {
+    std::unique_lock<std::mutex> lock(mtx);
+    submitLocked(false, lock);
+}
+
+void AsyncFileWriter::completeLocked(int file, Buffer* buffer) {
+    files[file].pending--;
+    files[file].dirty = true;
+    pendingTotal--;
+    freeBuffers.push_back(buffer);
+    cv.notify_all();
+}
+
+void AsyncFileWriter::drainLocked(std::unique_lock<std::mutex>& lock) {
+    while (pendingTotal > 0) submitLocked(true, lock);
+}
+
+// --- AsyncOutputStream ---
+
+AsyncOutputStream::AsyncOutputStream(AsyncFileWriter* writer, const std::string& path)
+    : std::ostream(nullptr) {
+    buf.writer = writer;
+    buf.file = writer->openFile(path);
+    rdbuf(&buf);
+    if (buf.file < 0) setstate(std::ios::failbit);
+}
+
+AsyncOutputStream::~AsyncOutputStream() {
+    close();
+}
+
+void AsyncOutputStream::close() {
+    if (buf.file < 0) return;
+    buf.submitCurrent();
+    buf.writer->closeFile(buf.file);
+    buf.file = -1;
+}
+
+void AsyncOutputStream::flushPending() {
+    if (buf.file >= 0) buf.submitAligned();
+}
+
+void AsyncOutputStream::AsyncStreamBuf::submitAligned() {
+    if (!current) return;
+    size_t len = static_cast<size_t>(pptr() - pbase());
+    size_t align = writer->writeAlignment();
+    size_t n = len - len % align;
+    if (n == 0) return;
+    if (n == len) {
+        submitCurrent();
+        return;
+    }
+
+    // Il resto non allineato passa in testa a un nuovo buffer
+    AsyncFileWriter::Buffer* next = writer->acquireBuffer();
+    std::memcpy(next->data, current->data + n, len - n);
+    writer->submit(file, current, n);
+    submitted += n;
+    current = next;
+    char* start = reinterpret_cast<char*>(current->data);
+    setp(start, start + current->capacity);
+    pbump(static_cast<int>(len - n));
+}
+
+void AsyncOutputStream::AsyncStreamBuf::submitCurrent() {
+    if (!current) return;
+    size_t len = static_cast<size_t>(pptr() - pbase());
+    writer->submit(file, current, len);
+    submitted += len;
+    current = nullptr;
+    setp(nullptr, nullptr);
+}
+
+AsyncOutputStream::AsyncStreamBuf::int_type AsyncOutputStream::AsyncStreamBuf::overflow(int_type c) {
+    if (file < 0) return traits_type::eof();
+    if (current && pptr() == epptr()) submitCurrent();
+    if (!current) {
+        current = writer->acquireBuffer();
+        char* start = reinterpret_cast<char*>(current->data);
+        setp(start, start + current->capacity);
+    }
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+    }
+    return traits_type::not_eof(c);
+}
+
+int AsyncOutputStream::AsyncStreamBuf::sync() {
+    submitCurrent();
+    return 0;
+}
+
+AsyncOutputStream::AsyncStreamBuf::pos_type AsyncOutputStream::AsyncStreamBuf::seekoff(
+        off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) {
+    // Solo la posizione corrente (tellp); lo stream è append-only
+    if (off != 0 || dir != std::ios_base::cur || !(which & std::ios_base::out)) return pos_type(off_type(-1));
+    return pos_type(static_cast<off_type>(submitted + (current ? pptr() - pbase() : 0)));
+}
+
+#ifdef __linux__
+
+// --- ThreadFileWriter ---
+
+ThreadFileWriter::ThreadFileWriter(size_t bufferSize, size_t nBuffers)
+    : AsyncFileWriter(bufferSize, nBuffers), stopping(false) {}
+
+ThreadFileWriter::~ThreadFileWriter() {
+    stopSyncThread();
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        if (worker.joinable()) drainLocked(lock);
+        stopping = true;
+    }
+    cv.notify_all();
+    if (worker.joinable()) worker.join();
+    for (auto& f : files) {
+        if (f.fd >= 0) ::close(f.fd);
+    }
+}
+
+bool ThreadFileWriter::init() {
+    worker = std::thread(&ThreadFileWriter::run, this);
+    return true;
+}
+
+void ThreadFileWriter::enqueueLocked(int file, Buffer* buffer, size_t len, uint64_t offset) {
+    Job job;
+    job.file = file;
+    job.buffer = buffer;
+    job.len = len;
+    job.offset = offset;
+    jobs.push_back(job);
+    cv.notify_all();
+}
+
+void ThreadFileWriter::submitLocked(bool wait, std::unique_lock<std::mutex>& lock) {
+    // Le richieste partono subito; l'attesa è su un qualsiasi completamento
+    if (wait) cv.wait(lock);
+}
+
+void ThreadFileWriter::run() {
+    SystemUtils::applyThreadRole(SystemUtils::ThreadRole::Writer);
+    std::unique_lock<std::mutex> lock(mtx);
+    while (true) {
+        cv.wait(lock, [this] { return stopping || !jobs.empty(); });
+        if (jobs.empty()) return;
+
+        Job job = jobs.front();
+        jobs.pop_front();
+        int fd = files[job.file].fd;
+        lock.unlock();
+
+        size_t done = 0;
+        uint64_t calls = 0;
+        while (done < job.len) {
+            ssize_t n = pwrite(fd, job.buffer->data + done, job.len - done, job.offset + done);
+            calls++;
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) {
+                std::cerr << "[Writer] pwrite failed: " << std::strerror(errno) << "\n";
+                break;
+            }
+            done += n;
+        }
+
+        lock.lock();
+        syscalls += calls;
+        completeLocked(job.file, job.buffer);
+    }
+}
+
+#endif
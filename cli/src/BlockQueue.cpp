@@ -0,0 +1,156 @@
+#include "BlockQueue.h"
+#include <chrono>
+#include <cstring>
+#include <new>
+
+#ifdef __linux__
+    #include <sys/eventfd.h>
+    #include <poll.h>
+    #include <unistd.h>
+#else
+    #include <thread>
+#endif
+
+BlockQueue::BlockQueue(size_t capacity, size_t slotPayload)
+    : capacity(capacity), mask(capacity - 1), slotPayload(slotPayload), tail(0), head(0), frontChunks(0),
+      sleeping(false), drops(0), eventFd(-1) {
+    slots = new Slot[capacity];
+    for (size_t i = 0; i < capacity; i++) slots[i].sequence.store(i, std::memory_order_relaxed);
+    payloads = static_cast<uint8_t*>(::operator new(capacity * slotPayload, std::align_val_t(64)));
+#ifdef __linux__
+    eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#endif
+}
+
+BlockQueue::~BlockQueue() {
+#ifdef __linux__
+    if (eventFd >= 0) ::close(eventFd);
+#endif
+    ::operator delete(payloads, std::align_val_t(64));
+    delete[] slots;
+}
+
+uint64_t BlockQueue::nowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+bool BlockQueue::push(uint32_t sensor, const uint8_t* data, size_t size) {
+    uint32_t chunks = static_cast<uint32_t>(size == 0 ? 1 : (size + slotPayload - 1) / slotPayload);
+    if (chunks > capacity) {
+        drops.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // Prenotazione di chunks slot consecutivi: il consumatore libera gli slot in ordine,
+    // quindi se l'ultimo è libero per questo giro lo sono anche i precedenti
+    uint64_t pos = tail.load(std::memory_order_relaxed);
+    while (true) {
+        uint64_t last = pos + chunks - 1;
+        uint64_t seqFirst = slots[pos & mask].sequence.load(std::memory_order_acquire);
+        uint64_t seqLast = slots[last & mask].sequence.load(std::memory_order_acquire);
+        if (seqFirst == pos && seqLast == last) {
+            if (tail.compare_exchange_weak(pos, pos + chunks, std::memory_order_relaxed)) break;
+        } else if (static_cast<int64_t>(seqLast - last) < 0) {
+            drops.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        } else {
+            pos = tail.load(std::memory_order_relaxed);
+        }
+    }
+
+    uint64_t ts = nowNs();
+    size_t offset = 0;
+    for (uint32_t c = 0; c < chunks; c++) {
+        Slot& slot = slots[(pos + c) & mask];
+        size_t n = std::min(slotPayload, size - offset);
+        std::memcpy(payloads + ((pos + c) & mask) * slotPayload, data + offset, n);
+        offset += n;
+        slot.sensor = sensor;
+        slot.size = static_cast<uint32_t>(n);
+        slot.chunks = (c == 0) ? chunks : 0;
+        slot.enqueueNs = ts;
+        slot.sequence.store(pos + c + 1, std::memory_order_release);
+    }
+
+    ringDoorbell();
+    return true;
+}
+
+void BlockQueue::ringDoorbell() {
+    // Dekker con il consumatore: o lui vede il nuovo blocco, o noi vediamo sleeping
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeping.load(std::memory_order_relaxed) && sleeping.exchange(false)) {
+#ifdef __linux__
+        uint64_t one = 1;
+        ssize_t r = write(eventFd, &one, sizeof(one));
+        (void)r;
+#endif
+    }
+}
+
+bool BlockQueue::ready(uint64_t pos) const {
+    return slots[pos & mask].sequence.load(std::memory_order_acquire) == pos + 1;
+}
+
+bool BlockQueue::front(Block& out) {
+    if (!ready(head)) return false;
+    const Slot& first = slots[head & mask];
+    uint32_t chunks = first.chunks;
+    for (uint32_t c = 1; c < chunks; c++) {
+        if (!ready(head + c)) return false;   // Blocco a più slot non ancora completo
+    }
+
+    out.sensor = first.sensor;
+    out.enqueueNs = first.enqueueNs;
+    if (chunks == 1) {
+        out.data = payloads + (head & mask) * slotPayload;
+        out.size = first.size;
+    } else {
+        // Ricomposizione (solo per i blocchi più grandi di uno slot)
+        reassembly.clear();
+        for (uint32_t c = 0; c < chunks; c++) {
+            const uint8_t* p = payloads + ((head + c) & mask) * slotPayload;
+            reassembly.insert(reassembly.end(), p, p + slots[(head + c) & mask].size);
+        }
+        out.data = reassembly.data();
+        out.size = reassembly.size();
+    }
+    frontChunks = chunks;
+    return true;
+}
+
+void BlockQueue::release() {
+    for (uint32_t c = 0; c < frontChunks; c++) {
+        slots[head & mask].sequence.store(head + capacity, std::memory_order_release);
+        head++;
+    }
+    frontChunks = 0;
+}
+
+bool BlockQueue::wait(int timeoutMs) {
+    if (ready(head)) return true;
+
+#ifdef __linux__
+    sleeping.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (ready(head)) {
+        sleeping.store(false, std::memory_order_relaxed);
+        return true;
+    }
+
+    pollfd pfd;
+    pfd.fd = eventFd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    if (::poll(&pfd, 1, timeoutMs) > 0) {
+        uint64_t value;
+        ssize_t r = read(eventFd, &value, sizeof(value));
+        (void)r;
+    }
+    sleeping.store(false, std::memory_order_relaxed);
+#else
+    std::this_thread::sleep_for(std::chrono::milliseconds(timeoutMs));
+#endif
+    return ready(head);
+}
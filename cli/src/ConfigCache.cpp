@@ -0,0 +1,109 @@
+#include "ConfigCache.h"
+#include <fstream>
+#include <cstdlib>
+#include <cstdio>
+#include <cinttypes>
+#include "json.hpp"
+
+namespace {
+    const uint64_t FNV_OFFSET = 14695981039346656037ULL;
+    const uint64_t FNV_PRIME = 1099511628211ULL;
+
+    uint64_t fnv(uint64_t h, const std::string& data) {
+        for (unsigned char c : data) {
+            h ^= c;
+            h *= FNV_PRIME;
+        }
+        return h;
+    }
+
+    std::string toHex(uint64_t value) {
+        char buf[17];
+        std::snprintf(buf, sizeof(buf), "%016" PRIx64, value);
+        return buf;
+    }
+
+    uint64_t fromHex(const nlohmann::json& obj, const char* key) {
+        auto it = obj.find(key);
+        if (it == obj.end() || !it->is_string()) return 0;
+        return std::strtoull(it->get<std::string>().c_str(), nullptr, 16);
+    }
+}
+
+ConfigCache::ConfigCache(const std::string& path) : path(path) {}
+
+std::string ConfigCache::defaultPath() {
+    #ifdef _WIN32
+        const char* home = std::getenv("USERPROFILE");
+    #else
+        const char* home = std::getenv("HOME");
+    #endif
+    std::string dir = (home && *home) ? home : ".";
+    return dir + "/.fastgo_device_cache.json";
+}
+
+std::string ConfigCache::identityKey(int boardId, int fwId) {
+    return "board_" + std::to_string(boardId) + "_fw_" + std::to_string(fwId);
+}
+
+uint64_t ConfigCache::hash(const std::string& data) {
+    if (data.empty()) return 0;
+    uint64_t h = fnv(FNV_OFFSET, data);
+    return h ? h : 1;
+}
+
+uint64_t ConfigCache::statusDigest(const DeviceStatus& status) {
+    // Calcolata durante il parsing SAX dello stato
+    return status.digest();
+}
+
+bool ConfigCache::load() {
+    entries.clear();
+    std::ifstream in(path);
+    if (!in) return false;
+    auto root = nlohmann::json::parse(in, nullptr, false);
+    if (root.is_discarded() || !root.is_object()) return false;
+    for (auto it = root.begin(); it != root.end(); ++it) {
+        if (!it->is_object()) continue;
+        Entry entry;
+        entry.config = fromHex(*it, "config");
+        entry.ucf = fromHex(*it, "ucf");
+        entry.status = fromHex(*it, "status");
+        entries[it.key()] = entry;
+    }
+    return true;
+}
+
+bool ConfigCache::save() const {
+    nlohmann::json root = nlohmann::json::object();
+    for (const auto& pair : entries) {
+        root[pair.first] = {
+            { "config", toHex(pair.second.config) },
+            { "ucf", toHex(pair.second.ucf) },
+            { "status", toHex(pair.second.status) }
+        };
+    }
+    // Scrittura su file temporaneo e rinomina: una sessione interrotta non lascia un file troncato
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::out | std::ios::trunc);
+        if (!out) return false;
+        out << root.dump(2) << "\n";
+        if (!out) return false;
+    }
+    #ifdef _WIN32
+        std::remove(path.c_str());   // rename non sovrascrive su Windows
+    #endif
+    return std::rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+bool ConfigCache::lookup(const std::string& identity, Entry& entry) const {
+    auto it = entries.find(identity);
+    if (it == entries.end()) return false;
+    entry = it->second;
+    return true;
+}
+
+void ConfigCache::store(const std::string& identity, const Entry& entry) {
+    entries[identity] = entry;
+}
@@ -1,10 +1,45 @@
 #include "DataWriter.h"
 #include <iostream>
 #include <cstring> 
+#include <cstdio>
 #include <cmath>
+#include <algorithm>
+#include <charconv>
 #include <chrono> 
+#include "ImuCodec.h"
+#include "MappedOutputStream.h"
 
-DataWriter::DataWriter(const std::string& outputDir) : baseDir(outputDir) {}
+namespace {
+    // Massimo testo di un campione: ",\n{ "timestamp": <fixed>, "x": <g>, "y": <g>, "z": <g> }"
+    const size_t MAX_JSON_SAMPLE = 160;
+
+    // Stesso testo di ostream con fixed/precision(6) e con il formato predefinito/precision(6)
+    inline char* appendFixed6(char* p, char* end, double value) {
+#if defined(__cpp_lib_to_chars)
+        return std::to_chars(p, end, value, std::chars_format::fixed, 6).ptr;
+#else
+        return p + std::snprintf(p, end - p, "%.6f", value);
+#endif
+    }
+
+    inline char* appendGeneral6(char* p, char* end, float value) {
+#if defined(__cpp_lib_to_chars)
+        return std::to_chars(p, end, static_cast<double>(value), std::chars_format::general, 6).ptr;
+#else
+        return p + std::snprintf(p, end - p, "%.6g", value);
+#endif
+    }
+
+    inline char* appendLiteral(char* p, const char* text, size_t len) {
+        std::memcpy(p, text, len);
+        return p + len;
+    }
+}
+
+DataWriter::DataWriter(const std::string& outputDir)
+    : baseDir(outputDir), rotateSeconds(0.0), rotateBytes(0), compressSegments(false),
+      syncInterval(0.0), lastPendingFlush(0.0), mappedOutput(false), codec(OutputCodec::Json),
+      indexInterval(1000) {}
 
 DataWriter::~DataWriter() {
     closeAll();
@@ -24,58 +59,342 @@ bool DataWriter::isJsonSensor(const std::string& name) {
             name.find("mag") != std::string::npos);
 }
 
+void DataWriter::setRotation(double maxSeconds, size_t maxBytes, bool compress) {
+    rotateSeconds = maxSeconds;
+    rotateBytes = maxBytes;
+    compressSegments = compress;
+    if (rotateSeconds > 0.0 || rotateBytes > 0) {
+        finalizer.reset(new SegmentFinalizer(baseDir, compressSegments));
+    }
+}
+
+bool DataWriter::isCodecSensor(const std::string& name) {
+    return codec == OutputCodec::DeltaVarint &&
+           (name.find("gyro") != std::string::npos ||
+            name.find("acc") != std::string::npos ||
+            name.find("mag") != std::string::npos) &&
+           codecFallback.count(name) == 0;
+}
+
+void DataWriter::leaveCodec(const std::string& name) {
+    std::cerr << "[Writer] " << name << ": packet layout not supported by the delta codec, writing JSON instead\n";
+    codecFallback.insert(name);
+
+    // Il segmento .imz viene chiuso (e rimosso con il suo indice se ancora vuoto); il sensore prosegue in JSON
+    const std::string path = segments[name].path;
+    bool empty = true;
+    auto binIt = binaryFiles.find(name);
+    if (binIt != binaryFiles.end()) {
+        empty = binIt->second->tellp() <= 0;
+        binaryFiles.erase(binIt);
+    }
+    indexFiles.erase(name);
+    if (empty) {
+        std::remove(path.c_str());
+        std::remove((path + ".idx").c_str());
+    }
+    openSegment(name);
+}
+
+void DataWriter::setCodec(OutputCodec outputCodec) {
+    codec = outputCodec;
+}
+
+void DataWriter::setIndexInterval(uint32_t samples) {
+    indexInterval = samples;
+}
+
+void DataWriter::openIndex(const std::string& name, const std::string& path, SparseIndex::Kind kind) {
+    if (indexInterval == 0) return;
+    std::unique_ptr<IndexState> index(new IndexState());
+    index->interval = (kind == SparseIndex::KIND_RAW) ? static_cast<uint32_t>(SparseIndex::RAW_INDEX_BYTES) : indexInterval;
+    index->file.open(path + ".idx", std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!index->file) {
+        std::cerr << "[Writer] Cannot open " << path << ".idx\n";
+        return;
+    }
+    // I JSON iniziano con "[\n"
+    index->bytes = (kind == SparseIndex::KIND_JSON) ? 2 : 0;
+    SparseIndex::Header header = SparseIndex::makeHeader(name, kind, index->interval);
+    index->file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    indexFiles[name] = std::move(index);
+}
+
+void DataWriter::indexBlock(const std::string& name, size_t blockBytes, double sampleTime, uint64_t nSamples,
+                            SparseIndex::Layout layout) {
+    auto it = indexFiles.find(name);
+    if (it == indexFiles.end()) return;
+    IndexState& index = *it->second;
+    if (layout != SparseIndex::LAYOUT_UNKNOWN && layout != index.layout) {
+        // Header già scritto all'apertura: si aggiorna solo il campo layout
+        index.layout = layout;
+        std::streampos end = index.file.tellp();
+        index.file.seekp(offsetof(SparseIndex::Header, layout));
+        index.file.write(reinterpret_cast<const char*>(&layout), sizeof(layout));
+        index.file.seekp(end);
+    }
+    uint64_t offset = index.bytes;
+    index.bytes += blockBytes;
+    if (index.samples >= index.nextEntry) {
+        SparseIndex::Entry entry;
+        entry.hostTime = getCurrentTimeSec();
+        entry.sampleTime = sampleTime;
+        entry.offset = offset;
+        entry.sample = index.samples;
+        index.file.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+        index.nextEntry = index.samples + index.interval;
+    }
+    index.samples += nSamples;
+}
+
 void DataWriter::initSensorFiles(const std::vector<std::string>& sensorNames) {
     for (const auto& name : sensorNames) {
-        std::string path = baseDir + "/" + name;
-        
-        if (isJsonSensor(name)) {
-            jsonFiles[name].open(path + ".json");
-            jsonFiles[name] << "[\n";
-            firstSampleMap[name] = true;
-            lastBlockEndTime[name] = getCurrentTimeSec();
+        if (isJsonSensor(name)) lastBlockEndTime[name] = getCurrentTimeSec();
+        openSegment(name);
+    }
+}
+
+bool DataWriter::enableAsyncIo() {
+    asyncWriter = AsyncFileWriter::create();
+    if (!asyncWriter) return false;
+    std::cout << "[Writer] Async I/O backend: " << asyncWriter->backendName() << "\n";
+    return true;
+}
+
+void DataWriter::enableUnitConversion(const UnitConverter& unitTable) {
+    units = unitTable;
+    if (units.empty()) {
+        std::cerr << "[Writer] No sensitivities in device status, values stay in raw counts\n";
+        return;
+    }
+    units.writeSummary(baseDir + "/units.json");
+}
+
+bool DataWriter::enableMlcEvents(const std::vector<std::string>& sensorNames, const DeviceStatus& status,
+                                 const std::string& labelsPath) {
+    for (const auto& name : sensorNames) {
+        if (name.find("_mlc") == std::string::npos) continue;
+        std::unique_ptr<MlcStream> stream(new MlcStream());
+        stream->decoder.configure(name, status);
+        if (!labelsPath.empty() && !stream->decoder.loadLabels(labelsPath)) {
+            std::cerr << "[Writer] Cannot read MLC labels from " << labelsPath << "\n";
+        }
+        stream->channel = name + "_events";
+        mlcStreams[name] = std::move(stream);
+    }
+    if (mlcStreams.empty()) return false;
+
+    mlcLog.open(baseDir + "/mlc_events.jsonl");
+    return mlcLog.is_open();
+}
+
+bool DataWriter::enableMappedOutput() {
+#ifdef __linux__
+    mappedOutput = true;
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool DataWriter::setDurability(const DurabilityPolicy& policy) {
+    // I descrittori appartengono al backend asincrono: la politica richiede quel percorso di scrittura
+    if (!asyncWriter && !enableAsyncIo()) return false;
+    asyncWriter->setDurability(policy);
+    syncInterval = policy.syncIntervalSec;
+    return true;
+}
+
+std::unique_ptr<std::ostream> DataWriter::openStream(const std::string& path, bool binary) {
+    std::unique_ptr<std::ostream> stream;
+    if (asyncWriter) {
+        stream.reset(new AsyncOutputStream(asyncWriter.get(), path));
+    } else {
+        stream.reset(new std::ofstream(path, binary ? std::ios::out | std::ios::binary : std::ios::out));
+    }
+    if (!*stream) {
+        std::cerr << "[Writer] Cannot open " << path << "\n";
+        return nullptr;
+    }
+    return stream;
+}
+
+void DataWriter::openSegment(const std::string& name) {
+    SegmentState& seg = segments[name];
+    std::string path = baseDir + "/" + name;
+
+    // Con la rotazione attiva i segmenti sono numerati: <sensore>_0001.json
+    if (finalizer) {
+        char suffix[16];
+        snprintf(suffix, sizeof(suffix), "_%04d", seg.index + 1);
+        path += suffix;
+    }
+
+    if (isCodecSensor(name)) {
+        path += ".imz";
+        auto f = openStream(path, true);
+        if (f) binaryFiles[name] = std::move(f);
+        openIndex(name, path, SparseIndex::KIND_CODEC);
+    } else if (isJsonSensor(name)) {
+        path += ".json";
+        auto f = openStream(path, false);
+        if (f) {
+            *f << "[\n";
+            jsonFiles[name] = std::move(f);
+        }
+        firstSampleMap[name] = true;
+        openIndex(name, path, SparseIndex::KIND_JSON);
+    } else {
+        path += ".dat";
+        std::unique_ptr<std::ostream> f;
+        if (mappedOutput) {
+            // Con -y il descrittore entra nel fdatasync periodico del backend asincrono
+            AsyncFileWriter* syncWriter = (syncInterval > 0.0) ? asyncWriter.get() : nullptr;
+            f.reset(new MappedOutputStream(path, 16 * 1024 * 1024, syncWriter));
+            if (!*f) f.reset();
         } else {
-            FILE* f = fopen((path + ".dat").c_str(), "wb+");
-            if (f) binaryFiles[name] = f;
+            f = openStream(path, true);
+        }
+        if (f) binaryFiles[name] = std::move(f);
+        openIndex(name, path, SparseIndex::KIND_RAW);
+    }
+
+    seg.path = path;
+    seg.startTime = getCurrentTimeSec();
+    seg.bytes = 0;
+}
+
+void DataWriter::rotateIfNeeded(const std::string& name, size_t incomingBytes) {
+    SegmentState& seg = segments[name];
+    auto jsonIt = jsonFiles.find(name);
+    if (jsonIt != jsonFiles.end()) {
+        // Per i JSON conta la dimensione testuale già scritta, non i byte grezzi ricevuti
+        std::streampos pos = jsonIt->second->tellp();
+        if (pos > 0) seg.bytes = static_cast<size_t>(pos);
+    } else {
+        seg.bytes += incomingBytes;
+    }
+
+    bool sizeExceeded = rotateBytes > 0 && seg.bytes >= rotateBytes;
+    bool timeExceeded = false;
+    double now = 0.0;
+    if (rotateSeconds > 0.0 || sizeExceeded) {
+        now = getCurrentTimeSec();
+        timeExceeded = rotateSeconds > 0.0 && (now - seg.startTime) >= rotateSeconds;
+    }
+    if (!sizeExceeded && !timeExceeded) return;
+
+    // Il file ancora aperto passa al finalizzatore: nessuna close/compressione nel thread di acquisizione
+    SegmentFinalizer::SegmentInfo info;
+    info.sensor = name;
+    info.path = seg.path;
+    info.index = seg.index + 1;
+    info.startTime = seg.startTime;
+    info.endTime = now;
+
+    if (jsonIt != jsonFiles.end()) {
+        finalizer->submit(std::move(jsonIt->second), true, info);
+        jsonFiles.erase(jsonIt);
+    }
+    auto binIt = binaryFiles.find(name);
+    if (binIt != binaryFiles.end()) {
+        finalizer->submit(std::move(binIt->second), false, info);
+        binaryFiles.erase(binIt);
+    }
+
+    indexFiles.erase(name);
+    seg.index++;
+    openSegment(name);
+}
+
+void DataWriter::getStreamPositions(std::vector<StreamPosition>& out) {
+    out.clear();
+    for (const auto& pair : segments) {
+        std::ostream* stream = nullptr;
+        auto jsonIt = jsonFiles.find(pair.first);
+        if (jsonIt != jsonFiles.end()) stream = jsonIt->second.get();
+        auto binIt = binaryFiles.find(pair.first);
+        if (!stream && binIt != binaryFiles.end()) stream = binIt->second.get();
+        if (!stream) continue;
+
+        StreamPosition pos;
+        pos.sensor = pair.first;
+        pos.path = pair.second.path.substr(std::min(pair.second.path.size(), baseDir.size() + 1));
+        std::streampos p = stream->tellp();
+        pos.offset = (p > 0) ? static_cast<uint64_t>(p) : 0;
+        out.push_back(pos);
+    }
+}
+
+void DataWriter::publishEvent(const std::string& channel, const std::string& line, double timestamp) {
+    for (auto* sink : sinks) {
+        sink->onEvent(channel, reinterpret_cast<const uint8_t*>(line.data()), static_cast<int>(line.size()), timestamp);
+    }
+}
+
+void DataWriter::addSink(DataSink* sink) {
+    if (sink) sinks.push_back(sink);
+}
+
+void DataWriter::poll() {
+    if (syncInterval > 0.0) {
+        // I buffer parziali vanno al kernel a ogni intervallo, altrimenti fdatasync non li coprirebbe
+        double now = getCurrentTimeSec();
+        if (now - lastPendingFlush >= syncInterval) {
+            lastPendingFlush = now;
+            for (auto& pair : jsonFiles) {
+                if (auto* s = dynamic_cast<AsyncOutputStream*>(pair.second.get())) s->flushPending();
+            }
+            // I file mappati non passano dal backend asincrono
+            for (auto& pair : binaryFiles) {
+                if (auto* s = dynamic_cast<AsyncOutputStream*>(pair.second.get())) s->flushPending();
+            }
         }
     }
+    if (asyncWriter) asyncWriter->flush();
+    for (auto* sink : sinks) sink->poll();
 }
 
 void DataWriter::writeData(const std::string& name, const uint8_t* data, int size) {
+    if (!sinks.empty()) {
+        double now = getCurrentTimeSec();
+        for (auto* sink : sinks) sink->onData(name, data, size, now);
+    }
+
+    // La rotazione avviene ai confini di blocco, i campioni di un blocco restano nello stesso segmento
+    if (finalizer) rotateIfNeeded(name, size);
+
+    if (isCodecSensor(name)) {
+        if (writeCodecBlock(name, data, size)) return;
+        leaveCodec(name);
+    }
+
     if (isJsonSensor(name)) {
-        
-        
-        if (name.find("temp") != std::string::npos || name.find("press") != std::string::npos) {
-            
-            int sampleSize = 0;
-            bool isInt16 = false;       
-            bool isTimestampAtEnd = false;
+        auto fileIt = jsonFiles.find(name);
+        if (fileIt == jsonFiles.end()) return;
+        std::ostream& file = *fileIt->second;
+        bool& isFirst = firstSampleMap[name];
+        size_t nSamples = 0;
+        size_t written = 0;
+        double firstTime = 0.0;
+        SparseIndex::Layout layout = SparseIndex::LAYOUT_VALUES;
 
+        // Layout scelto una volta per blocco; il ciclo sui campioni è specializzato per layout
+        if (name.find("temp") != std::string::npos || name.find("press") != std::string::npos) {
             if (size % 16 == 0) {
-                sampleSize = 16;
-                isInt16 = false;        // Temp/Press formato 16 byte = FLOAT
-                isTimestampAtEnd = true;
+                nSamples = size / 16;
+                written = writeJsonBlock<PacketLayout::ScalarFloatTsEnd>(file, data, nSamples, isFirst, firstTime);   // Temp/Press formato 16 byte = FLOAT
             } else if (size % 12 == 0) {
-                sampleSize = 12; 
-                isInt16 = false;
+                nSamples = size / 12;
+                written = writeJsonBlock<PacketLayout::ScalarFloat>(file, data, nSamples, isFirst, firstTime);
             } else {
-                sampleSize = 10; 
-                isInt16 = true;
+                nSamples = size / 10;
+                written = writeJsonBlock<PacketLayout::ScalarInt16>(file, data, nSamples, isFirst, firstTime);
             }
-
-            if (sampleSize == 0) return;
-
-            int nSamples = size / sampleSize;
-            for (int i = 0; i < nSamples; i++) {
-                writeJsonSample(jsonFiles[name], name, data + (i * sampleSize), firstSampleMap[name], isInt16, isTimestampAtEnd, 0.0);
-            }
-            return; 
-        } 
-
-        
-        if ((size >= 10) && ((size - 4) % 6 == 0)) {
-            const int headerSize = 4;
-            const int sampleSize = 6;
-            int nSamples = (size - headerSize) / sampleSize;
+        } else if ((size >= 10) && ((size - 4) % 6 == 0)) {
+            const int headerSize = PacketLayout::PACKED_HEADER_SIZE;
+            const int sampleSize = PacketLayout::TriaxInt16Packed::sampleSize;
+            nSamples = (size - headerSize) / sampleSize;
 
             double now = getCurrentTimeSec();
             double prev = lastBlockEndTime[name];
@@ -86,108 +405,151 @@ void DataWriter::writeData(const std::string& name, const uint8_t* data, int siz
 
             lastBlockEndTime[name] = now;
 
-            const uint8_t* payload = data + headerSize; 
-            for (int i = 0; i < nSamples; i++) {
-                double ts = prev + (i * timeStep);
-                writeJsonSample(jsonFiles[name], name, payload + (i * sampleSize), firstSampleMap[name], true, false, ts);
-            }
-            return; 
-        }
-        
-        
-        int sampleSize = 0;
-        bool isInt16 = false;
-        
-        if (size % 14 == 0) { sampleSize = 14; isInt16 = true; }
-        else if (size % 20 == 0) { sampleSize = 20; isInt16 = false; }
-        
-        if (sampleSize > 0) {
-            int nSamples = size / sampleSize;
-            for (int i = 0; i < nSamples; i++) {
-                writeJsonSample(jsonFiles[name], name, data + (i * sampleSize), firstSampleMap[name], isInt16, false, 0.0);
-            }
+            written = writeJsonBlock<PacketLayout::TriaxInt16Packed>(file, data + headerSize, nSamples, isFirst, firstTime,
+                                                                     units.scaleFor(name), prev, timeStep);
+            layout = SparseIndex::LAYOUT_COUNTS;
+        } else if (size % 14 == 0) {
+            nSamples = size / 14;
+            written = writeJsonBlock<PacketLayout::TriaxInt16>(file, data, nSamples, isFirst, firstTime, units.scaleFor(name));
+            layout = SparseIndex::LAYOUT_COUNTS;
+        } else if (size % 20 == 0) {
+            nSamples = size / 20;
+            written = writeJsonBlock<PacketLayout::TriaxFloat>(file, data, nSamples, isFirst, firstTime);
         }
 
+        // Voce dell'indice con il timestamp del primo campione scritto (quelli con timestamp non valido sono saltati)
+        if (written > 0) indexBlock(name, written, firstTime, nSamples, layout);
+
     } else {
-        if (binaryFiles.count(name)) {
-            fwrite(data, 1, size, binaryFiles[name]);
+        auto fileIt = binaryFiles.find(name);
+        if (fileIt != binaryFiles.end()) {
+            fileIt->second->write(reinterpret_cast<const char*>(data), size);
+            if (!indexFiles.empty()) indexBlock(name, size, getCurrentTimeSec(), size);
+        }
+        if (!mlcStreams.empty()) {
+            auto mlcIt = mlcStreams.find(name);
+            if (mlcIt != mlcStreams.end()) writeMlcEvents(*mlcIt->second, data, size);
         }
     }
 }
 
-void DataWriter::writeJsonSample(std::ofstream& file, const std::string& name, const uint8_t* sample, bool& isFirst, bool isInt16, bool isTimestampAtEnd, double forcedTimestamp) {
-    double timestamp;
+void DataWriter::writeMlcEvents(MlcStream& stream, const uint8_t* data, int size) {
+    double now = getCurrentTimeSec();
+    const auto& events = stream.decoder.process(data, size, now);
+    if (events.empty()) return;
 
-    if (forcedTimestamp > 0.0) {
-        timestamp = forcedTimestamp;
-    } else {
-        if (isTimestampAtEnd) {
-            std::memcpy(&timestamp, sample + 8, sizeof(double));
-        } else {
-            std::memcpy(&timestamp, sample, sizeof(double));
+    for (const auto& event : events) {
+        const std::string& line = stream.decoder.formatEvent(event);
+        mlcLog.write(line.data(), static_cast<std::streamsize>(line.size()));
+        mlcLog.put('\n');
+        for (auto* sink : sinks) {
+            sink->onEvent(stream.channel, reinterpret_cast<const uint8_t*>(line.data()), static_cast<int>(line.size()), now);
         }
     }
-    
-    if (forcedTimestamp == 0.0 && (std::isnan(timestamp) || timestamp < 0 || timestamp > 4e9)) return; 
-    
-    if (!isFirst) file << ",\n";
-    else isFirst = false;
-
-    file.setf(std::ios::fixed, std::ios::floatfield);
-    file.precision(6);
-    file << "{ \"timestamp\": " << timestamp;
-    file.unsetf(std::ios::floatfield);
-    file.precision(6);
-    
-    if (name.find("temp") != std::string::npos || name.find("press") != std::string::npos) {
-        float value = 0.0f;
-        
-        if (isTimestampAtEnd) {
-            std::memcpy(&value, sample + 4, sizeof(float)); 
-        } 
-        else if (isInt16) {
-            int16_t raw;
-            std::memcpy(&raw, sample + 8, sizeof(int16_t));
-            value = static_cast<float>(raw);
-        } else {
-            std::memcpy(&value, sample + 8, sizeof(float));
-        }
-        file << ", \"value\": " << value << " }";
-    } 
-    else {
-        // Acc / Gyro / Mag
-        if (isInt16) {
-            int16_t x, y, z;
-            int offset = (forcedTimestamp > 0.0) ? 0 : 8; 
-            
-            std::memcpy(&x, sample + offset, sizeof(int16_t));
-            std::memcpy(&y, sample + offset + 2, sizeof(int16_t));
-            std::memcpy(&z, sample + offset + 4, sizeof(int16_t));
-            
-            file << ", \"x\": " << x << ", \"y\": " << y << ", \"z\": " << z << " }";
+    // Eventi rari: subito su disco, senza attendere il riempimento del buffer
+    mlcLog.flush();
+}
+
+bool DataWriter::writeCodecBlock(const std::string& name, const uint8_t* data, int size) {
+    // Solo Formato B (header + terne int16): i layout a 14/20 byte con timestamp per campione
+    // non hanno una forma equivalente nel frame e restano al chiamante
+    const int headerSize = 4;
+    const int sampleSize = 6;
+    if (size < 10 || (size - headerSize) % sampleSize != 0) return false;
+
+    auto fileIt = binaryFiles.find(name);
+    if (fileIt == binaryFiles.end()) return true;
+    uint32_t nSamples = (size - headerSize) / sampleSize;
+
+    double now = getCurrentTimeSec();
+    double prev = lastBlockEndTime[name];
+    if (prev == 0.0) prev = now - 0.05;
+    lastBlockEndTime[name] = now;
+
+    uint32_t header;
+    std::memcpy(&header, data, sizeof(header));
+    if (codecSamples.size() < nSamples * 3) codecSamples.resize(nSamples * 3);
+    std::memcpy(codecSamples.data(), data + headerSize, nSamples * sampleSize);
+
+    codecBuffer.clear();
+    ImuCodec::encodeFrame(codecSamples.data(), nSamples, 3, header, prev, now, codecBuffer, codecScratch);
+    fileIt->second->write(reinterpret_cast<const char*>(codecBuffer.data()), codecBuffer.size());
+    indexBlock(name, codecBuffer.size(), prev, nSamples);
+    return true;
+}
+
+template <typename Layout>
+size_t DataWriter::writeJsonBlock(std::ostream& file, const uint8_t* data, size_t nSamples, bool& isFirst,
+                                double& firstTime, float scale, double t0, double dt) {
+    // Conversione in unità fisiche nello stesso passaggio della decodifica (scale = 1: conteggi grezzi)
+    SampleDecoder::decode<Layout>(data, nSamples, decoded, scale, t0, dt);
+
+    // Testo accumulato per blocco e scritto con una sola chiamata
+    if (jsonBuffer.size() < nSamples * MAX_JSON_SAMPLE) jsonBuffer.resize(nSamples * MAX_JSON_SAMPLE);
+    char* begin = jsonBuffer.data();
+    char* p = begin;
+    for (size_t i = 0; i < nSamples; i++) {
+        double ts = decoded.t[i];
+        if (Layout::embeddedTimestamp && (std::isnan(ts) || ts < 0 || ts > 4e9)) continue;
+        if (p == begin) firstTime = ts;
+
+        char* end = p + MAX_JSON_SAMPLE;
+        if (!isFirst) p = appendLiteral(p, ",\n", 2);
+        isFirst = false;
+        p = appendLiteral(p, "{ \"timestamp\": ", 15);
+        p = appendFixed6(p, end, ts);
+        if constexpr (Layout::axes == 1) {
+            p = appendLiteral(p, ", \"value\": ", 11);
+            p = appendGeneral6(p, end, decoded.x[i]);
         } else {
-            float x, y, z;
-            std::memcpy(&x, sample + 8, sizeof(float));
-            std::memcpy(&y, sample + 12, sizeof(float));
-            std::memcpy(&z, sample + 16, sizeof(float));
-            file << ", \"x\": " << x << ", \"y\": " << y << ", \"z\": " << z << " }";
+            p = appendLiteral(p, ", \"x\": ", 7);
+            p = appendGeneral6(p, end, decoded.x[i]);
+            p = appendLiteral(p, ", \"y\": ", 7);
+            p = appendGeneral6(p, end, decoded.y[i]);
+            p = appendLiteral(p, ", \"z\": ", 7);
+            p = appendGeneral6(p, end, decoded.z[i]);
         }
+        p = appendLiteral(p, " }", 2);
     }
+    if (p > begin) file.write(begin, p - begin);
+    return static_cast<size_t>(p - begin);
 }
 
 void DataWriter::closeAll() {
-    for (auto& pair : jsonFiles) {
-        if (pair.second.is_open()) {
-            pair.second << "\n]";
-            pair.second.close();
+    if (finalizer) {
+        // Ultimi segmenti aperti: finalizzati come gli altri, poi si attende il thread
+        double now = getCurrentTimeSec();
+        for (auto& pair : segments) {
+            SegmentFinalizer::SegmentInfo info;
+            info.sensor = pair.first;
+            info.path = pair.second.path;
+            info.index = pair.second.index + 1;
+            info.startTime = pair.second.startTime;
+            info.endTime = now;
+
+            auto jsonIt = jsonFiles.find(pair.first);
+            if (jsonIt != jsonFiles.end()) finalizer->submit(std::move(jsonIt->second), true, info);
+            auto binIt = binaryFiles.find(pair.first);
+            if (binIt != binaryFiles.end()) finalizer->submit(std::move(binIt->second), false, info);
         }
+        jsonFiles.clear();
+        binaryFiles.clear();
+        indexFiles.clear();
+        segments.clear();
+        finalizer->stop();
     }
-    jsonFiles.clear();
 
-    for (auto& pair : binaryFiles) {
-        if (pair.second) {
-            fclose(pair.second);
-        }
+    // La distruzione dello stream chiude il file (per gli stream asincroni attende le scritture in volo)
+    for (auto& pair : jsonFiles) {
+        *pair.second << "\n]";
     }
+    jsonFiles.clear();
     binaryFiles.clear();
+    indexFiles.clear();
+    asyncWriter.reset();
+
+    if (mlcLog.is_open()) mlcLog.close();
+
+    for (auto* sink : sinks) sink->close();
+    sinks.clear();
 }
\ No newline at end of file
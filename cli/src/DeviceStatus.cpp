@@ -0,0 +1,236 @@
+#include "DeviceStatus.h"
+#include <cstring>
+#include "json.hpp"
+
+const char* const DeviceStatus::FIELDS[] = {
+    "alias", "enable", "odr", "measodr", "fs", "sensitivity", "aop", "dim",
+    "samples_per_ts", "usb_dps", "data_type", "ucf_status", nullptr
+};
+
+const char* const DeviceStatus::VOLATILE_KEYS[] = {
+    "measodr", "initial_offset", "ioffset", "log_status", "sd_mounted", "status", "tags",
+    "start_time", "end_time", "level", "voltage", "acquisition_info", "log_controller", nullptr
+};
+
+namespace {
+    const uint64_t FNV_OFFSET = 14695981039346656037ULL;
+    const uint64_t FNV_PRIME = 1099511628211ULL;
+
+    bool inList(const char* const* list, const std::string& key) {
+        for (const char* const* f = list; *f; f++) {
+            if (key == *f) return true;
+        }
+        return false;
+    }
+
+    bool isField(const std::string& key) {
+        return inList(DeviceStatus::FIELDS, key);
+    }
+
+    // FNV-1a con separatore finale: "ab"+"c" e "a"+"bc" danno impronte diverse
+    uint64_t mix(uint64_t h, const void* data, size_t size) {
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; i++) {
+            h ^= p[i];
+            h *= FNV_PRIME;
+        }
+        h ^= 0xFF;
+        h *= FNV_PRIME;
+        return h;
+    }
+
+    /**
+     * Consumatore SAX: tiene una pila dei contenitori aperti con il loro ruolo e
+     * registra solo gli scalari di FIELDS dentro un oggetto componente. Nello stesso
+     * passaggio accumula l'impronta di tutti gli scalari, con le chiavi che li contengono,
+     * tranne quelli sotto VOLATILE_KEYS.
+     */
+    class Extractor : public nlohmann::json_sax<nlohmann::json> {
+    public:
+        Extractor(std::vector<DeviceStatus::Component>& out) : out(out), digest(FNV_OFFSET), any(false) {}
+
+        uint64_t result() const { return any ? (digest ? digest : 1) : 0; }
+
+        bool null() override {
+            hashScalar('n', nullptr, 0);
+            return true;
+        }
+        bool boolean(bool val) override {
+            hashScalar('b', &val, sizeof(val));
+            DeviceStatus::Value* v = slot();
+            if (v) { v->type = DeviceStatus::Value::Boolean; v->boolean = val; }
+            return true;
+        }
+        bool number_integer(number_integer_t val) override {
+            hashScalar('i', &val, sizeof(val));
+            DeviceStatus::Value* v = slot();
+            if (v) { v->type = DeviceStatus::Value::Integer; v->integer = val; }
+            return true;
+        }
+        bool number_unsigned(number_unsigned_t val) override {
+            // Stesso valore con o senza segno: stessa impronta
+            int64_t asSigned = static_cast<int64_t>(val);
+            hashScalar(val <= static_cast<number_unsigned_t>(INT64_MAX) ? 'i' : 'u', &asSigned, sizeof(asSigned));
+            DeviceStatus::Value* v = slot();
+            if (v) { v->type = DeviceStatus::Value::Unsigned; v->uinteger = val; }
+            return true;
+        }
+        bool number_float(number_float_t val, const string_t&) override {
+            hashScalar('f', &val, sizeof(val));
+            DeviceStatus::Value* v = slot();
+            if (v) { v->type = DeviceStatus::Value::Float; v->number = val; }
+            return true;
+        }
+        bool string(string_t& val) override {
+            hashScalar('s', val.data(), val.size());
+            DeviceStatus::Value* v = slot();
+            if (v) { v->type = DeviceStatus::Value::String; v->text = std::move(val); }
+            return true;
+        }
+
+        bool start_object(std::size_t) override {
+            bool skip = enterContainer('{');
+            Role role = Role::Other;
+            if (stack.empty()) {
+                role = Role::Root;
+            } else if (!stack.back().array && (stack.back().role == Role::Root || stack.back().role == Role::Holder)) {
+                // devices[].components[].<nome> o <nome> alla radice
+                role = Role::Component;
+                out.emplace_back();
+                out.back().name = pendingKey;
+            } else if (stack.back().role == Role::ComponentList) {
+                role = Role::Holder;
+            }
+            stack.push_back({ role, false, skip });
+            return true;
+        }
+        bool end_object() override {
+            stack.pop_back();
+            digest = mix(digest, "}", 1);
+            return true;
+        }
+
+        bool start_array(std::size_t) override {
+            bool skip = enterContainer('[');
+            bool components = !stack.empty() && !stack.back().array && pendingKey == "components";
+            stack.push_back({ components ? Role::ComponentList : Role::Other, true, skip });
+            return true;
+        }
+        bool end_array() override {
+            stack.pop_back();
+            digest = mix(digest, "]", 1);
+            return true;
+        }
+
+        bool key(string_t& val) override {
+            pendingKey = std::move(val);
+            return true;
+        }
+
+        bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception&) override {
+            return false;
+        }
+
+    private:
+        enum class Role { Root, ComponentList, Holder, Component, Other };
+        struct Frame {
+            Role role;
+            bool array;
+            bool skip;     // Dentro una chiave volatile: escluso dall'impronta
+        };
+
+        std::vector<DeviceStatus::Component>& out;
+        std::vector<Frame> stack;
+        std::string pendingKey;
+        uint64_t digest;
+        bool any;
+
+        // Valore corrente escluso dall'impronta (sotto una chiave volatile o chiave volatile esso stesso)
+        bool excluded() const {
+            if (stack.empty()) return false;
+            if (stack.back().skip) return true;
+            return !stack.back().array && inList(DeviceStatus::VOLATILE_KEYS, pendingKey);
+        }
+
+        bool enterContainer(char open) {
+            bool skip = excluded();
+            if (skip) return true;
+            if (!stack.empty() && !stack.back().array) digest = mix(digest, pendingKey.data(), pendingKey.size());
+            digest = mix(digest, &open, 1);
+            return false;
+        }
+
+        void hashScalar(char type, const void* data, size_t size) {
+            if (excluded()) return;
+            if (!stack.empty() && !stack.back().array) digest = mix(digest, pendingKey.data(), pendingKey.size());
+            digest = mix(digest, &type, 1);
+            digest = mix(digest, data, size);
+            any = true;
+        }
+
+        // Destinazione dello scalare corrente (nullptr se da scartare)
+        DeviceStatus::Value* slot() {
+            if (stack.empty() || stack.back().role != Role::Component || !isField(pendingKey)) return nullptr;
+            return &out.back().fields[pendingKey];
+        }
+    };
+}
+
+double DeviceStatus::Value::asNumber() const {
+    switch (type) {
+        case Integer: return static_cast<double>(integer);
+        case Unsigned: return static_cast<double>(uinteger);
+        case Float: return number;
+        default: return 0.0;
+    }
+}
+
+std::string DeviceStatus::Value::dump() const {
+    switch (type) {
+        case Boolean: return boolean ? "true" : "false";
+        case Integer: return std::to_string(integer);
+        case Unsigned: return std::to_string(uinteger);
+        case Float: return nlohmann::json(number).dump();
+        case String: return nlohmann::json(text).dump();
+        default: return "null";
+    }
+}
+
+const DeviceStatus::Value* DeviceStatus::Component::find(const std::string& key) const {
+    auto it = fields.find(key);
+    return (it != fields.end()) ? &it->second : nullptr;
+}
+
+double DeviceStatus::Component::number(const std::string& key, double defaultValue) const {
+    const Value* v = find(key);
+    return (v && v->isNumber()) ? v->asNumber() : defaultValue;
+}
+
+std::string DeviceStatus::Component::text(const std::string& key, const std::string& defaultValue) const {
+    const Value* v = find(key);
+    return (v && v->type == Value::String) ? v->text : defaultValue;
+}
+
+bool DeviceStatus::parse(const std::string& json) {
+    list.clear();
+    byName.clear();
+    stateDigest = 0;
+    Extractor extractor(list);
+    if (!nlohmann::json::sax_parse(json, &extractor)) {
+        list.clear();
+        return false;
+    }
+    stateDigest = extractor.result();
+    for (size_t i = 0; i < list.size(); i++) byName[list[i].name] = i;
+    return true;
+}
+
+const DeviceStatus::Component* DeviceStatus::find(const std::string& name) const {
+    auto it = byName.find(name);
+    return (it != byName.end()) ? &list[it->second] : nullptr;
+}
+
+std::string DeviceStatus::alias() const {
+    const Component* info = find("firmware_info");
+    return info ? info->text("alias") : std::string();
+}
@@ -0,0 +1,55 @@
+#include "EventDetector.h"
+
+EventDetector::EventDetector(const std::string& outputDir, double vibrationThreshold)
+    : firstEvent(true), vibrationThreshold(vibrationThreshold), inVibration(false),
+      vibrationStart(0.0), vibrationPeak(0.0), vibrationPeakFreq(0.0), lastFrameTs(0.0) {
+    file.open(outputDir + "/events.json");
+    file << "[\n";
+    file.setf(std::ios::fixed, std::ios::floatfield);
+    file.precision(6);
+}
+
+EventDetector::~EventDetector() {
+    close();
+}
+
+void EventDetector::onSpectralFrame(const SpectralFrame& frame) {
+    lastFrameTs = frame.timestamp;
+    if (frame.totalEnergy >= vibrationThreshold) {
+        if (!inVibration) {
+            inVibration = true;
+            vibrationStart = frame.timestamp;
+            vibrationPeak = 0.0;
+        }
+        if (frame.totalEnergy > vibrationPeak) {
+            vibrationPeak = frame.totalEnergy;
+            vibrationPeakFreq = frame.dominantFreq;
+        }
+    } else if (inVibration) {
+        // Isteresi al 50% per evitare eventi spezzati sul bordo della soglia
+        if (frame.totalEnergy < 0.5 * vibrationThreshold) {
+            writeVibrationEvent(frame.timestamp);
+            inVibration = false;
+        }
+    }
+}
+
+void EventDetector::writeVibrationEvent(double endTs) {
+    if (!file.is_open()) return;
+    if (!firstEvent) file << ",\n";
+    else firstEvent = false;
+    file << "{ \"type\": \"vibration\", \"start\": " << vibrationStart
+         << ", \"end\": " << endTs
+         << ", \"peak_energy\": " << vibrationPeak
+         << ", \"peak_freq\": " << vibrationPeakFreq << " }";
+}
+
+void EventDetector::close() {
+    if (!file.is_open()) return;
+    if (inVibration) {
+        writeVibrationEvent(lastFrameTs);
+        inVibration = false;
+    }
+    file << "\n]";
+    file.close();
+}
@@ -0,0 +1,124 @@
+#include "ImuCodec.h"
+#include <cstring>
+
+namespace {
+    uint32_t fnv1a(const uint8_t* data, size_t len) {
+        uint32_t h = 2166136261u;
+        for (size_t i = 0; i < len; i++) {
+            h ^= data[i];
+            h *= 16777619u;
+        }
+        return h;
+    }
+
+    template <typename T>
+    inline void put(uint8_t* p, T v) { std::memcpy(p, &v, sizeof(T)); }
+
+    template <typename T>
+    inline T get(const uint8_t* p) { T v; std::memcpy(&v, p, sizeof(T)); return v; }
+}
+
+void ImuCodec::encodeFrame(const int16_t* samples, uint32_t nSamples, uint32_t channels,
+                           uint32_t deviceHeader, double tStart, double tEnd,
+                           std::vector<uint8_t>& out, std::vector<uint16_t>& scratch) {
+    size_t count = static_cast<size_t>(nSamples) * channels;
+    if (scratch.size() < count) scratch.resize(count);
+    uint16_t* zz = scratch.data();
+
+    // Passo 1 (vettorizzabile): delta per asse e zigzag su 16 bit, senza diramazioni
+    for (size_t i = 0; i < channels && i < count; i++) {
+        int16_t d = samples[i];
+        zz[i] = static_cast<uint16_t>((static_cast<uint16_t>(d) << 1) ^ static_cast<uint16_t>(d >> 15));
+    }
+    for (size_t i = channels; i < count; i++) {
+        int16_t d = static_cast<int16_t>(static_cast<uint16_t>(samples[i]) - static_cast<uint16_t>(samples[i - channels]));
+        zz[i] = static_cast<uint16_t>((static_cast<uint16_t>(d) << 1) ^ static_cast<uint16_t>(d >> 15));
+    }
+
+    // Passo 2: varint (al massimo 3 byte per valore a 16 bit)
+    size_t start = out.size();
+    out.resize(start + FRAME_HEADER_SIZE + count * 3);
+    uint8_t* p = out.data() + start + FRAME_HEADER_SIZE;
+    uint8_t* payload = p;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t v = zz[i];
+        if (v < 0x80) {
+            *p++ = static_cast<uint8_t>(v);
+        } else if (v < 0x4000) {
+            *p++ = static_cast<uint8_t>(v | 0x80);
+            *p++ = static_cast<uint8_t>(v >> 7);
+        } else {
+            *p++ = static_cast<uint8_t>(v | 0x80);
+            *p++ = static_cast<uint8_t>((v >> 7) | 0x80);
+            *p++ = static_cast<uint8_t>(v >> 14);
+        }
+    }
+    uint32_t payloadLen = static_cast<uint32_t>(p - payload);
+
+    uint8_t* h = out.data() + start;
+    put<uint32_t>(h, FRAME_MAGIC);
+    put<uint32_t>(h + 4, payloadLen);
+    put<uint16_t>(h + 12, static_cast<uint16_t>(channels));
+    put<uint16_t>(h + 14, 0);
+    put<uint32_t>(h + 16, nSamples);
+    put<uint32_t>(h + 20, deviceHeader);
+    put<double>(h + 24, tStart);
+    put<double>(h + 32, tEnd);
+    put<uint32_t>(h + 8, fnv1a(h + 12, FRAME_HEADER_SIZE - 12 + payloadLen));
+
+    out.resize(start + FRAME_HEADER_SIZE + payloadLen);
+}
+
+size_t ImuCodec::decodeFrame(const uint8_t* data, size_t size, FrameInfo& info, std::vector<int16_t>& samples) {
+    if (size < FRAME_HEADER_SIZE || get<uint32_t>(data) != FRAME_MAGIC) return 0;
+    uint32_t payloadLen = get<uint32_t>(data + 4);
+    if (size - FRAME_HEADER_SIZE < payloadLen) return 0;
+    if (get<uint32_t>(data + 8) != fnv1a(data + 12, FRAME_HEADER_SIZE - 12 + payloadLen)) return 0;
+
+    info.channels = get<uint16_t>(data + 12);
+    info.nSamples = get<uint32_t>(data + 16);
+    info.deviceHeader = get<uint32_t>(data + 20);
+    info.tStart = get<double>(data + 24);
+    info.tEnd = get<double>(data + 32);
+    if (info.channels == 0) return 0;
+
+    size_t count = static_cast<size_t>(info.nSamples) * info.channels;
+    if (samples.size() < count) samples.resize(count);
+    uint16_t* out = reinterpret_cast<uint16_t*>(samples.data());
+
+    // Passo 1: varint -> zigzag
+    const uint8_t* p = data + FRAME_HEADER_SIZE;
+    const uint8_t* end = p + payloadLen;
+    for (size_t i = 0; i < count; i++) {
+        if (p >= end) return 0;
+        uint32_t v = *p++;
+        if (v & 0x80) {
+            if (p >= end) return 0;
+            v = (v & 0x7F) | (static_cast<uint32_t>(*p & 0x7F) << 7);
+            if (*p++ & 0x80) {
+                if (p >= end) return 0;
+                v |= static_cast<uint32_t>(*p++) << 14;
+            }
+        }
+        out[i] = static_cast<uint16_t>(v);
+    }
+
+    // Passo 2 (vettorizzabile): zigzag inverso, poi somma prefissa per asse
+    for (size_t i = 0; i < count; i++) {
+        uint16_t z = out[i];
+        out[i] = static_cast<uint16_t>((z >> 1) ^ static_cast<uint16_t>(-(z & 1)));
+    }
+    for (size_t i = info.channels; i < count; i++) {
+        out[i] = static_cast<uint16_t>(out[i] + out[i - info.channels]);
+    }
+    return FRAME_HEADER_SIZE + payloadLen;
+}
+
+size_t ImuCodec::findNextFrame(const uint8_t* data, size_t size, size_t offset) {
+    FrameInfo info;
+    std::vector<int16_t> tmp;
+    for (size_t i = offset; i + FRAME_HEADER_SIZE <= size; i++) {
+        if (get<uint32_t>(data + i) == FRAME_MAGIC && decodeFrame(data + i, size - i, info, tmp) > 0) return i;
+    }
+    return size;
+}
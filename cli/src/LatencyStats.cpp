@@ -0,0 +1,42 @@
+#include "LatencyStats.h"
+#include <sstream>
+#include <iomanip>
+
+const double LatencyStats::BUCKET_LIMITS[LatencyStats::BUCKETS] = {
+    5, 10, 20, 50, 100, 200, 300, 500, 750, 1000,
+    1500, 2000, 3000, 5000, 7500, 10000, 20000, 50000, 100000, 1000000
+};
+
+LatencyStats::LatencyStats() : samples(0), sum(0.0), maxValue(0.0) {
+    for (auto& h : histogram) h = 0;
+}
+
+void LatencyStats::record(double latencyUs) {
+    if (latencyUs < 0.0) latencyUs = 0.0;
+    int b = 0;
+    while (b < BUCKETS && latencyUs > BUCKET_LIMITS[b]) b++;
+    histogram[b]++;
+    samples++;
+    sum += latencyUs;
+    if (latencyUs > maxValue) maxValue = latencyUs;
+}
+
+double LatencyStats::percentile(double p) const {
+    if (samples == 0) return 0.0;
+    uint64_t target = static_cast<uint64_t>(p / 100.0 * samples);
+    if (target >= samples) target = samples - 1;
+    uint64_t seen = 0;
+    for (int b = 0; b <= BUCKETS; b++) {
+        seen += histogram[b];
+        if (seen > target) return (b < BUCKETS && BUCKET_LIMITS[b] < maxValue) ? BUCKET_LIMITS[b] : maxValue;
+    }
+    return maxValue;
+}
+
+std::string LatencyStats::summary() const {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(0)
+        << "n=" << samples << " mean=" << mean() << "us p50<=" << percentile(50.0)
+        << "us p99<=" << percentile(99.0) << "us p99.9<=" << percentile(99.9) << "us max=" << maxValue << "us";
+    return out.str();
+}
@@ -0,0 +1,149 @@
+#include "MappedOutputStream.h"
+#include "AsyncFileWriter.h"
+#include <iostream>
+#include <cstring>
+
+#ifdef __linux__
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <cerrno>
+#endif
+
+#ifdef __linux__
+
+MappedOutputStream::MappedOutputStream(const std::string& path, size_t extentSize, AsyncFileWriter* syncWriter)
+    : std::ostream(nullptr) {
+    rdbuf(&buf);
+    buf.extentSize = extentSize;
+    buf.fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (buf.fd < 0 || !buf.grow(extentSize)) {
+        close();
+        setstate(std::ios::failbit);
+        return;
+    }
+    if (syncWriter) {
+        buf.syncWriter = syncWriter;
+        buf.syncId = syncWriter->watchFile(buf.fd);
+    }
+}
+
+MappedOutputStream::~MappedOutputStream() {
+    close();
+}
+
+void MappedOutputStream::close() {
+    // Fuori dal fdatasync periodico prima di toccare mappatura e descrittore
+    bool synced = buf.syncId >= 0;
+    if (synced) {
+        buf.syncWriter->unwatchFile(buf.syncId);
+        buf.syncId = -1;
+    }
+    if (buf.base) {
+        buf.footer->flags |= 1;
+        munmap(buf.base, buf.mapSize);
+        buf.base = nullptr;
+        buf.footer = nullptr;
+    }
+    if (buf.fd >= 0) {
+        // Via il footer e l'estensione non usata: resta solo il flusso grezzo
+        if (ftruncate(buf.fd, static_cast<off_t>(buf.committed)) != 0) {
+            std::cerr << "[Writer] ftruncate failed: " << std::strerror(errno) << "\n";
+        }
+        if (synced) fdatasync(buf.fd);
+        ::close(buf.fd);
+        buf.fd = -1;
+    }
+}
+
+bool MappedOutputStream::MappedBuf::grow(size_t minCapacity) {
+    size_t newCapacity = capacity;
+    while (newCapacity < minCapacity) newCapacity += extentSize;
+    size_t newMapSize = newCapacity + FOOTER_SIZE;
+
+    // Il vecchio footer viene invalidato prima di estendere il file: un lettore che
+    // trova magic == 0 rilegge st_size
+    if (footer) footer->magic = 0;
+
+    if (ftruncate(fd, static_cast<off_t>(newMapSize)) != 0) {
+        if (footer) footer->magic = FOOTER_MAGIC;
+        return false;
+    }
+    // Blocchi riservati subito: una scrittura nella mappatura con disco pieno darebbe SIGBUS
+    int err = posix_fallocate(fd, static_cast<off_t>(capacity), static_cast<off_t>(newMapSize - capacity));
+    if (err != 0 && err != EOPNOTSUPP && err != EINVAL) {
+        std::cerr << "[Writer] Cannot reserve file extent: " << std::strerror(err) << "\n";
+        // Si torna all'estensione mappata, con il footer ancora al suo posto
+        if (footer && ftruncate(fd, static_cast<off_t>(mapSize)) == 0) footer->magic = FOOTER_MAGIC;
+        return false;
+    }
+
+    void* p = base ? mremap(base, mapSize, newMapSize, MREMAP_MAYMOVE)
+                   : mmap(nullptr, newMapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+        // mremap fallita: la vecchia mappatura resta valida e viene rilasciata qui,
+        // dopo aver riportato il footer (close tronca comunque il file a committed)
+        std::cerr << "[Writer] mmap failed: " << std::strerror(errno) << "\n";
+        if (base) {
+            footer->magic = FOOTER_MAGIC;
+            munmap(base, mapSize);
+            base = nullptr;
+            footer = nullptr;
+        }
+        return false;
+    }
+    base = static_cast<uint8_t*>(p);
+    mapSize = newMapSize;
+    capacity = newCapacity;
+
+    footer = reinterpret_cast<Footer*>(base + capacity);
+    footer->version = 1;
+    footer->capacity = capacity;
+    footer->flags = 0;
+    footer->committed.store(committed, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    footer->magic = FOOTER_MAGIC;
+    return true;
+}
+
+std::streamsize MappedOutputStream::MappedBuf::xsputn(const char* s, std::streamsize n) {
+    if (!base || n <= 0) return 0;
+    size_t len = static_cast<size_t>(n);
+    if (committed + len > capacity && !grow(committed + len)) return 0;   // short write: badbit sullo stream
+
+    std::memcpy(base + committed, s, len);
+    committed += len;
+    footer->committed.store(committed, std::memory_order_release);
+    return n;
+}
+
+MappedOutputStream::MappedBuf::int_type MappedOutputStream::MappedBuf::overflow(int_type c) {
+    if (traits_type::eq_int_type(c, traits_type::eof())) return traits_type::not_eof(c);
+    char ch = traits_type::to_char_type(c);
+    return xsputn(&ch, 1) == 1 ? c : traits_type::eof();
+}
+
+MappedOutputStream::MappedBuf::pos_type MappedOutputStream::MappedBuf::seekoff(
+        off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) {
+    // Solo tellp: il file è append-only
+    if (off != 0 || dir != std::ios_base::cur || !(which & std::ios_base::out)) return pos_type(off_type(-1));
+    return pos_type(static_cast<off_type>(committed));
+}
+
+#else
+
+MappedOutputStream::MappedOutputStream(const std::string&, size_t, AsyncFileWriter*) : std::ostream(nullptr) {
+    rdbuf(&buf);
+    std::cerr << "[Writer] Memory-mapped output not supported on this platform\n";
+    setstate(std::ios::failbit);
+}
+MappedOutputStream::~MappedOutputStream() {}
+void MappedOutputStream::close() {}
+bool MappedOutputStream::MappedBuf::grow(size_t) { return false; }
+std::streamsize MappedOutputStream::MappedBuf::xsputn(const char*, std::streamsize) { return 0; }
+MappedOutputStream::MappedBuf::int_type MappedOutputStream::MappedBuf::overflow(int_type) { return traits_type::eof(); }
+MappedOutputStream::MappedBuf::pos_type MappedOutputStream::MappedBuf::seekoff(off_type, std::ios_base::seekdir, std::ios_base::openmode) {
+    return pos_type(off_type(-1));
+}
+
+#endif
@@ -0,0 +1,45 @@
+#include "MemoryPool.h"
+
+// --- Arena ---
+
+Arena::Arena(size_t chunkSize)
+    : chunkSize(chunkSize), cursor(nullptr), limit(nullptr), reserved(0) {}
+
+void* Arena::allocate(size_t size, size_t alignment) {
+    uintptr_t p = (reinterpret_cast<uintptr_t>(cursor) + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    if (!cursor || p + size > reinterpret_cast<uintptr_t>(limit)) {
+        // Nuovo chunk; le richieste più grandi del chunk ne ottengono uno dedicato
+        size_t bytes = (size + alignment > chunkSize) ? size + alignment : chunkSize;
+        chunks.emplace_back(new uint8_t[bytes]);
+        cursor = chunks.back().get();
+        limit = cursor + bytes;
+        reserved += bytes;
+        p = (reinterpret_cast<uintptr_t>(cursor) + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    }
+    cursor = reinterpret_cast<uint8_t*>(p + size);
+    return reinterpret_cast<void*>(p);
+}
+
+// --- BlockPool ---
+
+BlockPool::BlockPool(Arena& arena, size_t blockSize, size_t blocksPerSlab)
+    : arena(arena), size(blockSize < sizeof(FreeNode) ? sizeof(FreeNode) : blockSize),
+      blocksPerSlab(blocksPerSlab), freeList(nullptr) {
+    size = (size + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+}
+
+void* BlockPool::acquire() {
+    if (!freeList) {
+        uint8_t* slab = arena.allocateArray<uint8_t>(size * blocksPerSlab, alignof(std::max_align_t));
+        for (size_t i = 0; i < blocksPerSlab; i++) release(slab + i * size);
+    }
+    FreeNode* node = freeList;
+    freeList = node->next;
+    return node;
+}
+
+void BlockPool::release(void* block) {
+    FreeNode* node = static_cast<FreeNode*>(block);
+    node->next = freeList;
+    freeList = node;
+}
@@ -0,0 +1,140 @@
+#include "MlcDecoder.h"
+#include <fstream>
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include "json.hpp"
+
+namespace {
+    const size_t DEFAULT_OUTPUTS = 8;   // MLC0_SRC ... MLC7_SRC (ISM330DHCX)
+}
+
+MlcDecoder::MlcDecoder() : outputs(DEFAULT_OUTPUTS), samplesPerTs(1), haveState(false) {
+    buildLabelTable();
+    resetCarry();
+}
+
+void MlcDecoder::configure(const std::string& sensorName, const DeviceStatus& status) {
+    // Componente: { "<nome_componente>": { "dim": ..., "samples_per_ts": ... } }
+    if (const DeviceStatus::Component* comp = status.find(sensorName)) {
+        int dim = static_cast<int>(comp->number("dim", 0.0));
+        if (dim > 0 && dim <= 32) outputs = static_cast<size_t>(dim);
+        const DeviceStatus::Value* value = comp->find("samples_per_ts");
+        if (value && value->isNumber()) {
+            int spts = static_cast<int>(value->asNumber());
+            samplesPerTs = (spts > 0) ? static_cast<size_t>(spts) : 0;
+        }
+    }
+    haveState = false;
+    buildLabelTable();
+    resetCarry();
+}
+
+size_t MlcDecoder::unitSize() const {
+    // Con timestamp: gruppi di samplesPerTs campioni seguiti da un double; altrimenti solo registri
+    return samplesPerTs > 0 ? outputs * samplesPerTs + sizeof(double) : outputs;
+}
+
+void MlcDecoder::resetCarry() {
+    carry.clear();
+    carry.reserve(unitSize());
+}
+
+void MlcDecoder::decodeUnit(const uint8_t* unit, double hostTime) {
+    if (samplesPerTs == 0) {
+        decodeSample(unit, hostTime);
+        return;
+    }
+    double ts;
+    std::memcpy(&ts, unit + outputs * samplesPerTs, sizeof(ts));
+    for (size_t s = 0; s < samplesPerTs; s++) decodeSample(unit + s * outputs, ts);
+}
+
+bool MlcDecoder::loadLabels(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) return false;
+    auto json = nlohmann::json::parse(file, nullptr, false);
+    if (json.is_discarded() || !json.is_object()) return false;
+
+    labels.clear();
+    for (auto tree = json.begin(); tree != json.end(); ++tree) {
+        if (!tree->is_object()) continue;
+        int treeIndex = std::atoi(tree.key().c_str());
+        for (auto value = tree->begin(); value != tree->end(); ++value) {
+            if (value->is_string()) labels[treeIndex][std::atoi(value.key().c_str())] = value->get<std::string>();
+        }
+    }
+    buildLabelTable();
+    return true;
+}
+
+void MlcDecoder::buildLabelTable() {
+    labelTable.assign(outputs * 256, nullptr);
+    for (const auto& tree : labels) {
+        if (tree.first < 0 || static_cast<size_t>(tree.first) >= outputs) continue;
+        for (const auto& value : tree.second) {
+            if (value.first >= 0 && value.first < 256) labelTable[tree.first * 256 + value.first] = &value.second;
+        }
+    }
+    state.assign(outputs, 0);
+}
+
+void MlcDecoder::decodeSample(const uint8_t* sample, double timestamp) {
+    for (size_t t = 0; t < outputs; t++) {
+        if (haveState && sample[t] == state[t]) continue;
+        Event event;
+        event.timestamp = timestamp;
+        event.tree = static_cast<uint8_t>(t);
+        event.value = sample[t];
+        event.previous = state[t];
+        event.initial = !haveState;
+        event.label = labelTable[t * 256 + sample[t]];
+        events.push_back(event);
+        state[t] = sample[t];
+    }
+    haveState = true;
+}
+
+const std::vector<MlcDecoder::Event>& MlcDecoder::process(const uint8_t* data, int size, double hostTime) {
+    events.clear();
+    if (size <= 0) return events;
+
+    // I blocchi USB non sono allineati ai gruppi: la parte incompleta passa al blocco successivo
+    const size_t unit = unitSize();
+    size_t offset = 0;
+    const size_t total = static_cast<size_t>(size);
+    if (!carry.empty()) {
+        size_t take = std::min(unit - carry.size(), total);
+        carry.insert(carry.end(), data, data + take);
+        offset = take;
+        if (carry.size() < unit) return events;
+        decodeUnit(carry.data(), hostTime);
+        carry.clear();
+    }
+    for (; offset + unit <= total; offset += unit) decodeUnit(data + offset, hostTime);
+    carry.insert(carry.end(), data + offset, data + total);
+    return events;
+}
+
+const std::string& MlcDecoder::formatEvent(const Event& event) {
+    char buf[96];
+    std::snprintf(buf, sizeof(buf), "{ \"timestamp\": %.6f, \"tree\": %u, \"value\": %u",
+                  event.timestamp, static_cast<unsigned>(event.tree), static_cast<unsigned>(event.value));
+    line.assign(buf);
+    if (!event.initial) {
+        std::snprintf(buf, sizeof(buf), ", \"previous\": %u", static_cast<unsigned>(event.previous));
+        line += buf;
+    }
+    if (event.label) {
+        // Etichette dal file dell'utente: escape minimo per restare JSON valido
+        line += ", \"label\": \"";
+        for (char c : *event.label) {
+            if (c == '"' || c == '\\') line += '\\';
+            if (static_cast<unsigned char>(c) >= 0x20) line += c;
+        }
+        line += '"';
+    }
+    line += " }";
+    return line;
+}
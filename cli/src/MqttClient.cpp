@@ -0,0 +1,431 @@
+#include "MqttClient.h"
+#include "SystemUtils.h"
+#include <iostream>
+#include <cstring>
+#include <chrono>
+
+#ifdef __linux__
+    #include <sys/socket.h>
+    #include <netdb.h>
+    #include <netinet/tcp.h>
+    #include <poll.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <cerrno>
+#endif
+
+namespace {
+    // Tipi di pacchetto MQTT 3.1.1 (nibble alto dell'header fisso)
+    const uint8_t MQTT_CONNECT = 0x10;
+    const uint8_t MQTT_CONNACK = 0x20;
+    const uint8_t MQTT_PUBLISH = 0x30;
+    const uint8_t MQTT_PUBACK = 0x40;
+    const uint8_t MQTT_PINGREQ = 0xC0;
+    const uint8_t MQTT_PINGRESP = 0xD0;
+    const uint8_t MQTT_DISCONNECT = 0xE0;
+
+    double monotonicSec() {
+        auto now = std::chrono::steady_clock::now().time_since_epoch();
+        return std::chrono::duration_cast<std::chrono::duration<double>>(now).count();
+    }
+
+    const double CONNECT_TIMEOUT_SEC = 3.0;   // Connect TCP + CONNACK
+}
+
+MqttClient::MqttClient()
+    : state(State::Idle), sock(-1), port(0), nextAddress(0), stateDeadline(0.0), keepAlive(30), nextPacketId(1), inflightCount(0), lastSendTime(0.0),
+      lastReceiveTime(0.0), pingPending(false), outOffset(0), sentBase(0), retainedHead(0) {}
+
+MqttClient::~MqttClient() {
+    disconnect();
+}
+
+void MqttClient::queueHeader(uint8_t type, size_t remainingLength) {
+    outBuffer.push_back(type);
+    // Remaining Length: codifica a lunghezza variabile (7 bit per byte)
+    do {
+        uint8_t byte = remainingLength % 128;
+        remainingLength /= 128;
+        if (remainingLength > 0) byte |= 0x80;
+        outBuffer.push_back(byte);
+    } while (remainingLength > 0);
+}
+
+void MqttClient::queueString(const std::string& s) {
+    outBuffer.push_back(static_cast<uint8_t>(s.size() >> 8));
+    outBuffer.push_back(static_cast<uint8_t>(s.size() & 0xFF));
+    outBuffer.insert(outBuffer.end(), s.begin(), s.end());
+}
+
+#ifdef __linux__
+
+std::vector<MqttClient::Address> MqttClient::resolve(const std::string& host, int port) {
+    std::vector<Address> out;
+    addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* res = nullptr;
+    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &res) != 0) return out;
+    for (addrinfo* ai = res; ai != nullptr; ai = ai->ai_next) {
+        if (ai->ai_addrlen > sizeof(sockaddr_storage)) continue;
+        Address a;
+        std::memcpy(&a.addr, ai->ai_addr, ai->ai_addrlen);
+        a.len = ai->ai_addrlen;
+        a.family = ai->ai_family;
+        out.push_back(a);
+    }
+    freeaddrinfo(res);
+    return out;
+}
+
+bool MqttClient::connect(const std::string& host, int port, const std::string& clientId, int keepAliveSec,
+                         int timeoutMs) {
+    beginConnect(host, port, clientId, keepAliveSec);
+    double deadline = monotonicSec() + timeoutMs / 1000.0;
+    while (isConnecting() && monotonicSec() < deadline) {
+        service();
+        if (isConnecting()) ::poll(nullptr, 0, 5);
+    }
+    // Ancora in corso allo scadere: prosegue con le chiamate a service()
+    return isConnected();
+}
+
+void MqttClient::beginConnect(const std::string& host, int port, const std::string& clientId, int keepAliveSec) {
+    disconnect();
+    if (host != this->host || port != this->port) {
+        addresses.clear();
+        nextAddress = 0;
+    }
+    this->host = host;
+    this->port = port;
+    this->clientId = clientId;
+    keepAlive = keepAliveSec;
+
+    // Risoluzione precedente ancora in corso: se ne attende l'esito
+    if (resolving.valid()) {
+        state = State::Resolving;
+        return;
+    }
+    if (addresses.empty() || nextAddress >= addresses.size()) {
+        // getaddrinfo può bloccare per secondi (DNS irraggiungibile): in un thread a parte
+        addresses.clear();
+        nextAddress = 0;
+        // Lanciato dal thread di acquisizione: il resolver non ne eredita priorità real-time e core
+        resolving = std::async(std::launch::async, [host, port]() {
+            SystemUtils::applyThreadRole(SystemUtils::ThreadRole::Writer);
+            return resolve(host, port);
+        });
+        state = State::Resolving;
+        return;
+    }
+    startSocket();
+}
+
+void MqttClient::startSocket() {
+    while (nextAddress < addresses.size()) {
+        const Address& a = addresses[nextAddress++];
+        sock = socket(a.family, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        if (sock < 0) continue;
+        int one = 1;
+        setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        if (::connect(sock, reinterpret_cast<const sockaddr*>(&a.addr), a.len) == 0 || errno == EINPROGRESS) {
+            queueConnect();
+            state = State::Connecting;
+            stateDeadline = monotonicSec() + CONNECT_TIMEOUT_SEC;
+            return;
+        }
+        ::close(sock);
+        sock = -1;
+    }
+    std::cerr << "[MQTT] Cannot connect to " << host << ":" << port << "\n";
+    state = State::Idle;
+}
+
+void MqttClient::queueConnect() {
+    // CONNECT: protocollo "MQTT" livello 4, clean session
+    outBuffer.clear();
+    outOffset = 0;
+    sentBase = 0;
+    inBuffer.clear();
+    clearRetained();
+    queueHeader(MQTT_CONNECT, 10 + 2 + clientId.size());
+    queueString("MQTT");
+    outBuffer.push_back(0x04);
+    outBuffer.push_back(0x02);
+    outBuffer.push_back(static_cast<uint8_t>(keepAlive >> 8));
+    outBuffer.push_back(static_cast<uint8_t>(keepAlive & 0xFF));
+    queueString(clientId);
+}
+
+void MqttClient::stepConnect() {
+    if (state == State::Resolving) {
+        if (resolving.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return;
+        addresses = resolving.get();
+        nextAddress = 0;
+        if (addresses.empty()) {
+            std::cerr << "[MQTT] Cannot resolve " << host << "\n";
+            state = State::Idle;
+            return;
+        }
+        startSocket();
+        return;
+    }
+
+    if (monotonicSec() > stateDeadline) {
+        std::cerr << "[MQTT] Connection to " << host << ":" << port << " timed out\n";
+        closeSocket();
+        startSocket();
+        return;
+    }
+
+    if (state == State::Connecting) {
+        // Connect TCP completato quando il socket diventa scrivibile
+        pollfd pfd = { sock, POLLOUT, 0 };
+        if (::poll(&pfd, 1, 0) <= 0) return;
+        int err = 0;
+        socklen_t len = sizeof(err);
+        if (getsockopt(sock, SOL_SOCKET, SO_ERROR, &err, &len) != 0 || err != 0) {
+            closeSocket();
+            startSocket();
+            return;
+        }
+        state = State::AwaitConnack;
+    }
+
+    // Invio del CONNECT e lettura del CONNACK (gestito da readIncoming)
+    flush();
+    readIncoming();
+}
+
+void MqttClient::disconnect() {
+    if (state == State::Connected) {
+        uint8_t pkt[2] = { MQTT_DISCONNECT, 0 };
+        flush();
+        if (sock >= 0) send(sock, pkt, sizeof(pkt), MSG_NOSIGNAL);
+    }
+    closeSocket();
+}
+
+void MqttClient::closeSocket() {
+    if (sock >= 0) ::close(sock);
+    sock = -1;
+    state = State::Idle;
+    // I PUBLISH non consegnati restano in retainedList; sentBase ricorda quanto era uscito
+    sentBase += outOffset;
+    outBuffer.clear();
+    outOffset = 0;
+    inBuffer.clear();
+    inflightCount = 0;
+}
+
+void MqttClient::flush() {
+    while (sock >= 0 && outOffset < outBuffer.size()) {
+        ssize_t n = send(sock, outBuffer.data() + outOffset, outBuffer.size() - outOffset, MSG_NOSIGNAL);
+        if (n > 0) {
+            outOffset += n;
+            lastSendTime = monotonicSec();
+            markSent();
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return;
+        } else {
+            std::cerr << "[MQTT] Connection lost\n";
+            closeSocket();
+            return;
+        }
+    }
+    sentBase += outBuffer.size();
+    outBuffer.clear();
+    outOffset = 0;
+}
+
+void MqttClient::readIncoming() {
+    uint8_t buf[256];
+    bool closed = false;
+    while (sock >= 0) {
+        ssize_t n = recv(sock, buf, sizeof(buf), 0);
+        if (n > 0) {
+            inBuffer.insert(inBuffer.end(), buf, buf + n);
+            lastReceiveTime = monotonicSec();
+            pingPending = false;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else {
+            // Chiusura: prima si elaborano i PUBACK già ricevuti, altrimenti tornerebbero come DUP
+            closed = true;
+            break;
+        }
+    }
+
+    // Il broker invia solo pacchetti corti (CONNACK, PUBACK, PINGRESP): lunghezza su un byte
+    size_t pos = 0;
+    while (sock >= 0 && inBuffer.size() - pos >= 2) {
+        size_t len = 2 + inBuffer[pos + 1];
+        if (inBuffer.size() - pos < len) break;
+        uint8_t type = inBuffer[pos] & 0xF0;
+        if (type == MQTT_CONNACK && state == State::AwaitConnack) {
+            if (len < 4 || inBuffer[pos + 3] != 0) {
+                std::cerr << "[MQTT] Connection refused by broker\n";
+                closeSocket();
+                return;
+            }
+            state = State::Connected;
+            nextAddress = 0;
+            inflightCount = 0;
+            lastSendTime = lastReceiveTime = monotonicSec();
+            pingPending = false;
+        } else if (type == MQTT_PUBACK && len >= 4) {
+            markAcked(static_cast<uint16_t>((inBuffer[pos + 2] << 8) | inBuffer[pos + 3]));
+        }
+        pos += len;
+    }
+    if (closed && sock >= 0) {
+        std::cerr << "[MQTT] Connection closed by broker\n";
+        closeSocket();
+        return;
+    }
+    if (sock >= 0) inBuffer.erase(inBuffer.begin(), inBuffer.begin() + pos);
+}
+
+void MqttClient::service() {
+    if (state == State::Idle) return;
+    if (state != State::Connected) {
+        stepConnect();
+        return;
+    }
+    flush();
+    readIncoming();
+
+    if (sock < 0 || keepAlive <= 0) return;
+    double now = monotonicSec();
+
+    // Connessione mezza aperta (broker o rete spariti senza FIN): il socket resterebbe "connesso"
+    // fino al timeout TCP del kernel, con i dati accumulati in memoria invece che nello spool
+    if (now - lastReceiveTime > 1.5 * keepAlive) {
+        std::cerr << "[MQTT] No response from broker for " << static_cast<int>(now - lastReceiveTime)
+                  << " s, closing the connection\n";
+        closeSocket();
+        return;
+    }
+
+    // Keep-alive: PINGREQ dopo metà intervallo senza trasmettere o senza ricevere (con soli
+    // PUBLISH QoS 0 il broker non risponderebbe mai); il PINGRESP aggiorna lastReceiveTime
+    if (!pingPending && (now - lastSendTime > keepAlive / 2.0 || now - lastReceiveTime > keepAlive / 2.0)) {
+        outBuffer.push_back(MQTT_PINGREQ);
+        outBuffer.push_back(0);
+        pingPending = true;
+        flush();
+    }
+}
+
+#else
+
+std::vector<MqttClient::Address> MqttClient::resolve(const std::string&, int) { return {}; }
+bool MqttClient::connect(const std::string&, int, const std::string&, int, int) {
+    std::cerr << "[MQTT] Not supported on this platform\n";
+    return false;
+}
+void MqttClient::beginConnect(const std::string&, int, const std::string&, int) {}
+void MqttClient::startSocket() {}
+void MqttClient::queueConnect() {}
+void MqttClient::stepConnect() {}
+void MqttClient::disconnect() {}
+void MqttClient::closeSocket() {}
+void MqttClient::flush() {}
+void MqttClient::readIncoming() {}
+void MqttClient::service() {}
+
+#endif
+
+bool MqttClient::publish(const std::string& topic, const uint8_t* payload, size_t len, int qos, bool dup) {
+    if (state != State::Connected) return false;
+
+    size_t start = outBuffer.size();
+    size_t remaining = 2 + topic.size() + len + (qos > 0 ? 2 : 0);
+    uint8_t flags = (qos > 0) ? (dup ? 0x0A : 0x02) : 0x00;
+    queueHeader(static_cast<uint8_t>(MQTT_PUBLISH | flags), remaining);
+    queueString(topic);
+    uint16_t packetId = 0;
+    if (qos > 0) {
+        if (nextPacketId == 0) nextPacketId = 1;
+        packetId = nextPacketId++;
+        outBuffer.push_back(static_cast<uint8_t>(packetId >> 8));
+        outBuffer.push_back(static_cast<uint8_t>(packetId & 0xFF));
+        inflightCount++;
+    }
+    outBuffer.insert(outBuffer.end(), payload, payload + len);
+
+    // Copia conservata fino alla consegna
+    Retained r;
+    r.packetId = packetId;
+    r.streamStart = sentBase + start;
+    r.streamEnd = sentBase + outBuffer.size();
+    r.offset = retainedBytes.size();
+    r.size = outBuffer.size() - start;
+    r.done = false;
+    retainedBytes.insert(retainedBytes.end(), outBuffer.begin() + start, outBuffer.end());
+    retainedList.push_back(r);
+
+    flush();
+    return true;
+}
+
+void MqttClient::markSent() {
+    // QoS 0 consegnati quando il pacchetto è uscito per intero
+    uint64_t sent = sentBase + outOffset;
+    for (size_t i = retainedHead; i < retainedList.size() && retainedList[i].streamEnd <= sent; i++) {
+        if (retainedList[i].packetId == 0) retainedList[i].done = true;
+    }
+    compactRetained();
+}
+
+void MqttClient::markAcked(uint16_t packetId) {
+    for (size_t i = retainedHead; i < retainedList.size(); i++) {
+        Retained& r = retainedList[i];
+        if (r.done || r.packetId != packetId) continue;
+        r.done = true;
+        if (inflightCount > 0) inflightCount--;
+        break;
+    }
+    compactRetained();
+}
+
+void MqttClient::compactRetained() {
+    while (retainedHead < retainedList.size() && retainedList[retainedHead].done) retainedHead++;
+    if (retainedHead == retainedList.size()) {
+        clearRetained();
+    } else if (retainedHead > 32 && retainedHead * 2 > retainedList.size()) {
+        // Prefisso consegnato ma trattenuto da un QoS 1 lento: si libera lo spazio
+        size_t shift = retainedList[retainedHead].offset;
+        retainedBytes.erase(retainedBytes.begin(), retainedBytes.begin() + static_cast<std::ptrdiff_t>(shift));
+        retainedList.erase(retainedList.begin(), retainedList.begin() + static_cast<std::ptrdiff_t>(retainedHead));
+        for (auto& r : retainedList) r.offset -= shift;
+        retainedHead = 0;
+    }
+}
+
+void MqttClient::clearRetained() {
+    retainedList.clear();
+    retainedBytes.clear();
+    retainedHead = 0;
+}
+
+void MqttClient::takeUndelivered(const UndeliveredFn& onMessage) {
+    uint64_t sent = sentBase + outOffset;
+    for (size_t i = retainedHead; i < retainedList.size(); i++) {
+        const Retained& r = retainedList[i];
+        if (r.done) continue;
+        // PUBLISH: header fisso, Remaining Length variabile, topic, packet id (QoS 1), payload
+        const uint8_t* p = retainedBytes.data() + r.offset;
+        const uint8_t* end = p + r.size;
+        int qos = (p[0] >> 1) & 0x03;
+        const uint8_t* q = p + 1;
+        while (q < end && (*q & 0x80)) q++;
+        q++;
+        size_t topicLen = (static_cast<size_t>(q[0]) << 8) | q[1];
+        std::string topic(reinterpret_cast<const char*>(q + 2), topicLen);
+        q += 2 + topicLen + (qos > 0 ? 2 : 0);
+        onMessage(topic, q, static_cast<size_t>(end - q), qos, qos > 0 && r.streamStart < sent);
+    }
+    clearRetained();
+}
@@ -0,0 +1,252 @@
+#include "MqttSink.h"
+#include <iostream>
+#include <cstring>
+#include <chrono>
+#include <algorithm>
+#include <thread>
+#include <cctype>
+#ifdef __linux__
+    #include <unistd.h>
+#endif
+
+namespace {
+    double monotonicSec() {
+        auto now = std::chrono::steady_clock::now().time_since_epoch();
+        return std::chrono::duration_cast<std::chrono::duration<double>>(now).count();
+    }
+
+    void appendBytes(std::vector<uint8_t>& out, const void* src, size_t len) {
+        const uint8_t* p = static_cast<const uint8_t*>(src);
+        out.insert(out.end(), p, p + len);
+    }
+
+    // Client id unico per processo: due istanze sullo stesso broker con lo stesso id si
+    // scollegherebbero a vicenda. Solo alfanumerici e al più 23 caratteri (garantiti da MQTT 3.1.1)
+    std::string defaultClientId() {
+        std::string host;
+#ifdef __linux__
+        char name[256] = {0};
+        if (gethostname(name, sizeof(name) - 1) == 0) {
+            for (const char* c = name; *c && host.size() < 10; c++) {
+                if (std::isalnum(static_cast<unsigned char>(*c))) host += *c;
+            }
+        }
+        return "fastgo" + host + std::to_string(getpid());
+#else
+        return "fastgo";
+#endif
+    }
+
+    const double RECONNECT_INTERVAL_SEC = 5.0;
+    const uint16_t SPOOL_DUP_FLAG = 0x8000;   // Bit alto della lunghezza del topic
+}
+
+MqttSink::MqttSink(const std::string& host, int port, const std::string& topicPrefix,
+                   int qos, const std::string& spoolPath)
+    : host(host), port(port), topicPrefix(topicPrefix), qos(qos > 0 ? 1 : 0), spoolPath(spoolPath),
+      clientId(defaultClientId()),
+      batchMaxBytes(16 * 1024), batchMaxDelay(0.2), maxPendingBytes(256 * 1024), maxInflight(16),
+      spool(nullptr), spoolReadPos(0), spoolWritePos(0), lastReconnect(0.0) {}
+
+MqttSink::~MqttSink() {
+    close();
+}
+
+void MqttSink::setBatchLimits(size_t maxBytes, double maxDelaySec) {
+    batchMaxBytes = maxBytes;
+    batchMaxDelay = maxDelaySec;
+}
+
+bool MqttSink::start() {
+    lastReconnect = monotonicSec();
+    return client.connect(host, port, clientId);
+}
+
+bool MqttSink::brokerReady() const {
+    return client.isConnected() &&
+           client.pendingBytes() < maxPendingBytes &&
+           client.inflight() < maxInflight;
+}
+
+void MqttSink::onData(const std::string& sensorName, const uint8_t* data, int size, double timestamp) {
+    Batch& batch = batches[sensorName];
+    if (batch.payload.empty()) {
+        batch.payload.reserve(batchMaxBytes + size + 12);
+        batch.firstTimestamp = timestamp;
+    }
+
+    uint32_t len = static_cast<uint32_t>(size);
+    appendBytes(batch.payload, &timestamp, sizeof(timestamp));
+    appendBytes(batch.payload, &len, sizeof(len));
+    appendBytes(batch.payload, data, size);
+
+    if (batch.payload.size() >= batchMaxBytes) publishBatch(sensorName, batch);
+}
+
+void MqttSink::onEvent(const std::string& channel, const uint8_t* data, int size, double timestamp) {
+    // Stesso formato di payload dei blocchi, ma un evento per PUBLISH
+    Batch& batch = batches[channel];
+    onData(channel, data, size, timestamp);
+    if (!batch.payload.empty()) publishBatch(channel, batch);
+}
+
+void MqttSink::publishBatch(const std::string& sensorName, Batch& batch) {
+    if (batch.payload.empty()) return;
+    if (batch.topic.empty()) batch.topic = topicPrefix + "/" + sensorName;
+    const std::string& topic = batch.topic;
+
+    // Backpressure: se il broker è lento o ci sono dati in spool si mantiene l'ordine passando dal disco
+    if (spoolWritePos > spoolReadPos || !brokerReady()) {
+        writeSpool(topic, batch.payload);
+    } else {
+        client.publish(topic, batch.payload.data(), batch.payload.size(), qos);
+    }
+    batch.payload.clear();
+}
+
+void MqttSink::writeSpoolRecord(FILE* f, const std::string& topic, const uint8_t* payload, size_t len, bool dup) {
+    uint16_t topicLen = static_cast<uint16_t>(topic.size() & 0x7FFF);
+    if (dup) topicLen |= SPOOL_DUP_FLAG;
+    uint32_t payloadLen = static_cast<uint32_t>(len);
+    fwrite(&topicLen, sizeof(topicLen), 1, f);
+    fwrite(topic.data(), 1, topic.size() & 0x7FFF, f);
+    fwrite(&payloadLen, sizeof(payloadLen), 1, f);
+    fwrite(payload, 1, len, f);
+}
+
+bool MqttSink::readSpoolRecord(FILE* f, std::string& topic, std::vector<uint8_t>& payload, bool& dup) {
+    uint16_t topicLen = 0;
+    uint32_t payloadLen = 0;
+    if (fread(&topicLen, sizeof(topicLen), 1, f) != 1) return false;
+    dup = (topicLen & SPOOL_DUP_FLAG) != 0;
+    topicLen &= static_cast<uint16_t>(~SPOOL_DUP_FLAG);
+    topic.assign(topicLen, '\0');
+    if (topicLen > 0 && fread(&topic[0], 1, topicLen, f) != topicLen) return false;
+    if (fread(&payloadLen, sizeof(payloadLen), 1, f) != 1) return false;
+    payload.resize(payloadLen);
+    return payloadLen == 0 || fread(payload.data(), 1, payloadLen, f) == payloadLen;
+}
+
+void MqttSink::writeSpool(const std::string& topic, const std::vector<uint8_t>& payload) {
+    if (!spool) {
+        spool = fopen(spoolPath.c_str(), "wb+");
+        if (!spool) return;
+        spoolReadPos = spoolWritePos = 0;
+    }
+    fseek(spool, spoolWritePos, SEEK_SET);
+    writeSpoolRecord(spool, topic, payload.data(), payload.size(), false);
+    spoolWritePos = ftell(spool);
+}
+
+void MqttSink::rescueUndelivered() {
+    // Messaggi più vecchi di tutto lo spool (che si riempie solo a connessione non pronta):
+    // nuovo file con questi in testa, poi la parte non ancora letta dello spool esistente
+    std::string tmpPath = spoolPath + ".tmp";
+    FILE* out = fopen(tmpPath.c_str(), "wb+");
+    size_t count = 0;
+    client.takeUndelivered([&](const std::string& topic, const uint8_t* payload, size_t len, int, bool dup) {
+        if (out) writeSpoolRecord(out, topic, payload, len, dup);
+        count++;
+    });
+    if (!out) {
+        std::cerr << "\n[MQTT] Cannot create " << tmpPath << ", " << count << " undelivered messages lost\n";
+        return;
+    }
+    if (spool) {
+        fflush(spool);
+        fseek(spool, spoolReadPos, SEEK_SET);
+        long remaining = spoolWritePos - spoolReadPos;
+        spoolScratch.resize(64 * 1024);
+        while (remaining > 0) {
+            size_t chunk = static_cast<size_t>(std::min<long>(remaining, static_cast<long>(spoolScratch.size())));
+            size_t got = fread(spoolScratch.data(), 1, chunk, spool);
+            if (got == 0) break;
+            fwrite(spoolScratch.data(), 1, got, out);
+            remaining -= static_cast<long>(got);
+        }
+        fclose(spool);
+    }
+    fflush(out);
+    spool = out;
+    spoolReadPos = 0;
+    spoolWritePos = ftell(out);
+    std::rename(tmpPath.c_str(), spoolPath.c_str());
+    std::cerr << "\n[MQTT] " << count << " undelivered messages moved to " << spoolPath << "\n";
+}
+
+void MqttSink::drainSpool() {
+    if (!spool) return;
+    fflush(spool);
+
+    while (spoolReadPos < spoolWritePos && brokerReady()) {
+        std::string topic;
+        bool dup = false;
+        fseek(spool, spoolReadPos, SEEK_SET);
+        if (!readSpoolRecord(spool, topic, spoolScratch, dup)) break;
+
+        client.publish(topic, spoolScratch.data(), spoolScratch.size(), qos, dup);
+        spoolReadPos = ftell(spool);
+    }
+
+    // Spool completamente smaltito: si riparte da un file vuoto
+    if (spoolReadPos >= spoolWritePos) {
+        fclose(spool);
+        spool = nullptr;
+        std::remove(spoolPath.c_str());
+        spoolReadPos = spoolWritePos = 0;
+    }
+}
+
+void MqttSink::poll() {
+    double now = monotonicSec();
+
+    // Connessione caduta: i messaggi non consegnati passano in testa allo spool
+    if (!client.isConnected() && client.hasUndelivered()) rescueUndelivered();
+
+    // Riconnessione non bloccante: avviata qui, portata avanti da service() a ogni giro
+    if (!client.isConnected() && !client.isConnecting()) {
+        if (now - lastReconnect >= RECONNECT_INTERVAL_SEC) {
+            lastReconnect = now;
+            client.beginConnect(host, port, clientId);
+        }
+    } else {
+        client.service();
+    }
+
+    if (client.isConnected()) drainSpool();
+
+    // Invio dei batch più vecchi del ritardo massimo (timestamp host in secondi)
+    auto wall = std::chrono::system_clock::now().time_since_epoch();
+    double wallSec = std::chrono::duration_cast<std::chrono::duration<double>>(wall).count();
+    for (auto& pair : batches) {
+        if (!pair.second.payload.empty() && wallSec - pair.second.firstTimestamp >= batchMaxDelay) {
+            publishBatch(pair.first, pair.second);
+        }
+    }
+}
+
+void MqttSink::close() {
+    for (auto& pair : batches) publishBatch(pair.first, pair.second);
+    if (client.isConnected()) {
+        // Attesa limitata per svuotare il buffer di uscita e raccogliere i PUBACK prima del DISCONNECT
+        double deadline = monotonicSec() + 2.0;
+        do {
+            drainSpool();
+            client.service();
+            if (client.hasUndelivered()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        } while (client.isConnected() &&
+                 (client.hasUndelivered() || spoolReadPos < spoolWritePos) &&
+                 monotonicSec() < deadline);
+        client.disconnect();
+    }
+    // QoS 1 ancora senza PUBACK (o connessione già caduta): restano su disco
+    if (client.hasUndelivered()) rescueUndelivered();
+    if (spool) {
+        // Dati non consegnati: lo spool resta su disco
+        if (spoolReadPos < spoolWritePos) {
+            std::cerr << "[MQTT] " << (spoolWritePos - spoolReadPos) << " bytes left in " << spoolPath << "\n";
+        }
+        fclose(spool);
+        spool = nullptr;
+    }
+}
@@ -0,0 +1,151 @@
+#include "OrientationFilter.h"
+#include <cmath>
+
+namespace {
+    const float RAD_TO_DEG = 57.29577951308232f;
+
+    inline float invSqrt(float x) {
+        return 1.0f / std::sqrt(x);
+    }
+}
+
+OrientationFilter::OrientationFilter(float beta) : beta(beta) {
+    reset();
+}
+
+void OrientationFilter::reset() {
+    q0 = 1.0f;
+    q1 = q2 = q3 = 0.0f;
+}
+
+void OrientationFilter::update(float gx, float gy, float gz,
+                               float ax, float ay, float az,
+                               float mx, float my, float mz, float dt) {
+    // Magnetometro non valido: si ricade sull'aggiornamento 6 assi
+    if (mx == 0.0f && my == 0.0f && mz == 0.0f) {
+        updateImu(gx, gy, gz, ax, ay, az, dt);
+        return;
+    }
+
+    // Derivata del quaternione dovuta al giroscopio
+    float qDot1 = 0.5f * (-q1 * gx - q2 * gy - q3 * gz);
+    float qDot2 = 0.5f * (q0 * gx + q2 * gz - q3 * gy);
+    float qDot3 = 0.5f * (q0 * gy - q1 * gz + q3 * gx);
+    float qDot4 = 0.5f * (q0 * gz + q1 * gy - q2 * gx);
+
+    if (!(ax == 0.0f && ay == 0.0f && az == 0.0f)) {
+        float recipNorm = invSqrt(ax * ax + ay * ay + az * az);
+        ax *= recipNorm; ay *= recipNorm; az *= recipNorm;
+
+        recipNorm = invSqrt(mx * mx + my * my + mz * mz);
+        mx *= recipNorm; my *= recipNorm; mz *= recipNorm;
+
+        float _2q0mx = 2.0f * q0 * mx;
+        float _2q0my = 2.0f * q0 * my;
+        float _2q0mz = 2.0f * q0 * mz;
+        float _2q1mx = 2.0f * q1 * mx;
+        float _2q0 = 2.0f * q0;
+        float _2q1 = 2.0f * q1;
+        float _2q2 = 2.0f * q2;
+        float _2q3 = 2.0f * q3;
+        float _2q0q2 = 2.0f * q0 * q2;
+        float _2q2q3 = 2.0f * q2 * q3;
+        float q0q0 = q0 * q0;
+        float q0q1 = q0 * q1;
+        float q0q2 = q0 * q2;
+        float q0q3 = q0 * q3;
+        float q1q1 = q1 * q1;
+        float q1q2 = q1 * q2;
+        float q1q3 = q1 * q3;
+        float q2q2 = q2 * q2;
+        float q2q3 = q2 * q3;
+        float q3q3 = q3 * q3;
+
+        // Direzione di riferimento del campo magnetico terrestre
+        float hx = mx * q0q0 - _2q0my * q3 + _2q0mz * q2 + mx * q1q1 + _2q1 * my * q2 + _2q1 * mz * q3 - mx * q2q2 - mx * q3q3;
+        float hy = _2q0mx * q3 + my * q0q0 - _2q0mz * q1 + _2q1mx * q2 - my * q1q1 + my * q2q2 + _2q2 * mz * q3 - my * q3q3;
+        float _2bx = std::sqrt(hx * hx + hy * hy);
+        float _2bz = -_2q0mx * q2 + _2q0my * q1 + mz * q0q0 + _2q1mx * q3 - mz * q1q1 + _2q2 * my * q3 - mz * q2q2 + mz * q3q3;
+        float _4bx = 2.0f * _2bx;
+        float _4bz = 2.0f * _2bz;
+
+        // Passo di discesa del gradiente
+        float s0 = -_2q2 * (2.0f * q1q3 - _2q0q2 - ax) + _2q1 * (2.0f * q0q1 + _2q2q3 - ay) - _2bz * q2 * (_2bx * (0.5f - q2q2 - q3q3) + _2bz * (q1q3 - q0q2) - mx) + (-_2bx * q3 + _2bz * q1) * (_2bx * (q1q2 - q0q3) + _2bz * (q0q1 + q2q3) - my) + _2bx * q2 * (_2bx * (q0q2 + q1q3) + _2bz * (0.5f - q1q1 - q2q2) - mz);
+        float s1 = _2q3 * (2.0f * q1q3 - _2q0q2 - ax) + _2q0 * (2.0f * q0q1 + _2q2q3 - ay) - 4.0f * q1 * (1 - 2.0f * q1q1 - 2.0f * q2q2 - az) + _2bz * q3 * (_2bx * (0.5f - q2q2 - q3q3) + _2bz * (q1q3 - q0q2) - mx) + (_2bx * q2 + _2bz * q0) * (_2bx * (q1q2 - q0q3) + _2bz * (q0q1 + q2q3) - my) + (_2bx * q3 - _4bz * q1) * (_2bx * (q0q2 + q1q3) + _2bz * (0.5f - q1q1 - q2q2) - mz);
+        float s2 = -_2q0 * (2.0f * q1q3 - _2q0q2 - ax) + _2q3 * (2.0f * q0q1 + _2q2q3 - ay) - 4.0f * q2 * (1 - 2.0f * q1q1 - 2.0f * q2q2 - az) + (-_4bx * q2 - _2bz * q0) * (_2bx * (0.5f - q2q2 - q3q3) + _2bz * (q1q3 - q0q2) - mx) + (_2bx * q1 + _2bz * q3) * (_2bx * (q1q2 - q0q3) + _2bz * (q0q1 + q2q3) - my) + (_2bx * q0 - _4bz * q2) * (_2bx * (q0q2 + q1q3) + _2bz * (0.5f - q1q1 - q2q2) - mz);
+        float s3 = _2q1 * (2.0f * q1q3 - _2q0q2 - ax) + _2q2 * (2.0f * q0q1 + _2q2q3 - ay) + (-_4bx * q3 + _2bz * q1) * (_2bx * (0.5f - q2q2 - q3q3) + _2bz * (q1q3 - q0q2) - mx) + (-_2bx * q0 + _2bz * q2) * (_2bx * (q1q2 - q0q3) + _2bz * (q0q1 + q2q3) - my) + _2bx * q1 * (_2bx * (q0q2 + q1q3) + _2bz * (0.5f - q1q1 - q2q2) - mz);
+        float sNorm = s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3;
+        if (sNorm > 0.0f) {
+            recipNorm = invSqrt(sNorm);
+            qDot1 -= beta * s0 * recipNorm;
+            qDot2 -= beta * s1 * recipNorm;
+            qDot3 -= beta * s2 * recipNorm;
+            qDot4 -= beta * s3 * recipNorm;
+        }
+    }
+
+    q0 += qDot1 * dt;
+    q1 += qDot2 * dt;
+    q2 += qDot3 * dt;
+    q3 += qDot4 * dt;
+
+    float recipNorm = invSqrt(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+    q0 *= recipNorm; q1 *= recipNorm; q2 *= recipNorm; q3 *= recipNorm;
+}
+
+void OrientationFilter::updateImu(float gx, float gy, float gz,
+                                  float ax, float ay, float az, float dt) {
+    float qDot1 = 0.5f * (-q1 * gx - q2 * gy - q3 * gz);
+    float qDot2 = 0.5f * (q0 * gx + q2 * gz - q3 * gy);
+    float qDot3 = 0.5f * (q0 * gy - q1 * gz + q3 * gx);
+    float qDot4 = 0.5f * (q0 * gz + q1 * gy - q2 * gx);
+
+    if (!(ax == 0.0f && ay == 0.0f && az == 0.0f)) {
+        float recipNorm = invSqrt(ax * ax + ay * ay + az * az);
+        ax *= recipNorm; ay *= recipNorm; az *= recipNorm;
+
+        float _2q0 = 2.0f * q0;
+        float _2q1 = 2.0f * q1;
+        float _2q2 = 2.0f * q2;
+        float _2q3 = 2.0f * q3;
+        float _4q0 = 4.0f * q0;
+        float _4q1 = 4.0f * q1;
+        float _4q2 = 4.0f * q2;
+        float _8q1 = 8.0f * q1;
+        float _8q2 = 8.0f * q2;
+        float q0q0 = q0 * q0;
+        float q1q1 = q1 * q1;
+        float q2q2 = q2 * q2;
+        float q3q3 = q3 * q3;
+
+        float s0 = _4q0 * q2q2 + _2q2 * ax + _4q0 * q1q1 - _2q1 * ay;
+        float s1 = _4q1 * q3q3 - _2q3 * ax + 4.0f * q0q0 * q1 - _2q0 * ay - _4q1 + _8q1 * q1q1 + _8q1 * q2q2 + _4q1 * az;
+        float s2 = 4.0f * q0q0 * q2 + _2q0 * ax + _4q2 * q3q3 - _2q3 * ay - _4q2 + _8q2 * q1q1 + _8q2 * q2q2 + _4q2 * az;
+        float s3 = 4.0f * q1q1 * q3 - _2q1 * ax + 4.0f * q2q2 * q3 - _2q2 * ay;
+        float sNorm = s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3;
+        if (sNorm > 0.0f) {
+            recipNorm = invSqrt(sNorm);
+            qDot1 -= beta * s0 * recipNorm;
+            qDot2 -= beta * s1 * recipNorm;
+            qDot3 -= beta * s2 * recipNorm;
+            qDot4 -= beta * s3 * recipNorm;
+        }
+    }
+
+    q0 += qDot1 * dt;
+    q1 += qDot2 * dt;
+    q2 += qDot3 * dt;
+    q3 += qDot4 * dt;
+
+    float recipNorm = invSqrt(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+    q0 *= recipNorm; q1 *= recipNorm; q2 *= recipNorm; q3 *= recipNorm;
+}
+
+void OrientationFilter::getEuler(float& roll, float& pitch, float& yaw) const {
+    roll = std::atan2(q0 * q1 + q2 * q3, 0.5f - q1 * q1 - q2 * q2) * RAD_TO_DEG;
+    float sinp = -2.0f * (q1 * q3 - q0 * q2);
+    if (sinp > 1.0f) sinp = 1.0f;
+    if (sinp < -1.0f) sinp = -1.0f;
+    pitch = std::asin(sinp) * RAD_TO_DEG;
+    yaw = std::atan2(q1 * q2 + q0 * q3, 0.5f - q2 * q2 - q3 * q3) * RAD_TO_DEG;
+}
@@ -0,0 +1,104 @@
+#include "QuantileSketch.h"
+#include <cmath>
+#include <algorithm>
+
+QuantileSketch::QuantileSketch(double relativeAccuracy, size_t bins)
+    : gamma((1.0 + relativeAccuracy) / (1.0 - relativeAccuracy)),
+      logGamma(std::log((1.0 + relativeAccuracy) / (1.0 - relativeAccuracy))),
+      maxBins(std::max<size_t>(bins, 16)), zeros(0) {}
+
+int QuantileSketch::keyOf(double magnitude) const {
+    return static_cast<int>(std::ceil(std::log(magnitude) / logGamma));
+}
+
+double QuantileSketch::valueOf(int key) const {
+    // Centro del bin (gamma^(k-1), gamma^k] con errore relativo simmetrico
+    return 2.0 * std::pow(gamma, key) / (gamma + 1.0);
+}
+
+void QuantileSketch::Store::add(int key, uint64_t n, size_t maxBins) {
+    if (bins.empty()) {
+        bins.assign(1, 0);
+        offset = key;
+    }
+    if (key < offset) {
+        // Sotto il primo bin: si estende verso il basso solo entro il limite, altrimenti nel primo bin
+        size_t grow = static_cast<size_t>(offset - key);
+        if (bins.size() + grow > maxBins) {
+            grow = (maxBins > bins.size()) ? maxBins - bins.size() : 0;
+            if (grow == 0) {
+                bins[0] += n;
+                total += n;
+                return;
+            }
+            key = offset - static_cast<int>(grow);
+        }
+        bins.insert(bins.begin(), grow, 0);
+        offset -= static_cast<int>(grow);
+    } else if (key >= offset + static_cast<int>(bins.size())) {
+        bins.resize(static_cast<size_t>(key - offset) + 1, 0);
+        collapse(maxBins);
+        if (key < offset) key = offset;
+    }
+    bins[static_cast<size_t>(key - offset)] += n;
+    total += n;
+}
+
+void QuantileSketch::Store::collapse(size_t maxBins) {
+    if (bins.size() <= maxBins) return;
+    // I moduli più piccoli (meno significativi) confluiscono nel primo bin mantenuto
+    size_t excess = bins.size() - maxBins;
+    uint64_t folded = 0;
+    for (size_t i = 0; i <= excess; i++) folded += bins[i];
+    bins.erase(bins.begin(), bins.begin() + static_cast<std::ptrdiff_t>(excess));
+    bins[0] = folded;
+    offset += static_cast<int>(excess);
+}
+
+void QuantileSketch::add(double value) {
+    if (std::isnan(value)) return;
+    if (value > MIN_VALUE) {
+        positive.add(keyOf(value), 1, maxBins);
+    } else if (value < -MIN_VALUE) {
+        negative.add(keyOf(-value), 1, maxBins);
+    } else {
+        zeros++;
+    }
+}
+
+void QuantileSketch::merge(const QuantileSketch& other) {
+    for (size_t i = 0; i < other.positive.bins.size(); i++) {
+        if (other.positive.bins[i]) positive.add(other.positive.offset + static_cast<int>(i), other.positive.bins[i], maxBins);
+    }
+    for (size_t i = 0; i < other.negative.bins.size(); i++) {
+        if (other.negative.bins[i]) negative.add(other.negative.offset + static_cast<int>(i), other.negative.bins[i], maxBins);
+    }
+    zeros += other.zeros;
+}
+
+void QuantileSketch::clear() {
+    positive = Store();
+    negative = Store();
+    zeros = 0;
+}
+
+double QuantileSketch::quantile(double q) const {
+    uint64_t n = count();
+    if (n == 0) return 0.0;
+    q = std::min(1.0, std::max(0.0, q));
+    uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(n - 1));
+
+    // Ordine crescente: negativi dal modulo più grande, zeri, positivi dal più piccolo
+    uint64_t seen = 0;
+    for (size_t i = negative.bins.size(); i-- > 0;) {
+        seen += negative.bins[i];
+        if (seen > rank) return -valueOf(negative.offset + static_cast<int>(i));
+    }
+    seen += zeros;
+    if (seen > rank) return 0.0;
+    for (size_t i = 0; i < positive.bins.size(); i++) {
+        seen += positive.bins[i];
+        if (seen > rank) return valueOf(positive.offset + static_cast<int>(i));
+    }
+    return positive.bins.empty() ? 0.0 : valueOf(positive.offset + static_cast<int>(positive.bins.size()) - 1);
+}
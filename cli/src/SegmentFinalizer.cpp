@@ -0,0 +1,141 @@
+#include "SegmentFinalizer.h"
+#include "SystemUtils.h"
+#include <iostream>
+#include <sstream>
+#include <fstream>
+#include <cstdio>
+#include <vector>
+#include <sys/stat.h>
+#ifdef HSD_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace {
+#ifdef HSD_HAVE_ZLIB
+    // Compressione gzip in-process (nessuna shell, nessun processo esterno) su file
+    // temporaneo: il .gz compare solo completo, l'originale è rimosso solo dopo il rename
+    bool gzipFile(const std::string& path) {
+        std::string gzPath = path + ".gz";
+        std::string tmpPath = gzPath + ".tmp";
+        FILE* in = std::fopen(path.c_str(), "rb");
+        if (!in) return false;
+        gzFile out = gzopen(tmpPath.c_str(), "wb6");
+        if (!out) {
+            std::fclose(in);
+            return false;
+        }
+        gzbuffer(out, 128 * 1024);
+
+        std::vector<char> buf(256 * 1024);
+        bool ok = true;
+        size_t n;
+        while (ok && (n = std::fread(buf.data(), 1, buf.size(), in)) > 0) {
+            ok = gzwrite(out, buf.data(), static_cast<unsigned>(n)) == static_cast<int>(n);
+        }
+        ok = ok && !std::ferror(in);
+        std::fclose(in);
+        ok = (gzclose(out) == Z_OK) && ok;
+
+        if (!ok || std::rename(tmpPath.c_str(), gzPath.c_str()) != 0) {
+            std::remove(tmpPath.c_str());
+            return false;
+        }
+        std::remove(path.c_str());
+        return true;
+    }
+#else
+    bool gzipFile(const std::string&) {
+        return false;
+    }
+#endif
+}
+
+SegmentFinalizer::SegmentFinalizer(const std::string& outputDir, bool compress)
+    : baseDir(outputDir), compress(compress), stopping(false) {
+#ifndef HSD_HAVE_ZLIB
+    if (compress) {
+        std::cerr << "[Writer] Built without zlib, segments will not be compressed\n";
+        this->compress = false;
+    }
+#endif
+    worker = std::thread(&SegmentFinalizer::run, this);
+}
+
+SegmentFinalizer::~SegmentFinalizer() {
+    stop();
+}
+
+void SegmentFinalizer::submit(std::unique_ptr<std::ostream> file, bool jsonArray, const SegmentInfo& info) {
+    std::lock_guard<std::mutex> lock(mtx);
+    jobs.emplace_back();
+    jobs.back().info = info;
+    jobs.back().file = std::move(file);
+    jobs.back().jsonArray = jsonArray;
+    cv.notify_one();
+}
+
+void SegmentFinalizer::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (stopping && !worker.joinable()) return;
+        stopping = true;
+    }
+    cv.notify_one();
+    if (worker.joinable()) worker.join();
+}
+
+void SegmentFinalizer::run() {
+    SystemUtils::applyThreadRole(SystemUtils::ThreadRole::Writer);
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            cv.wait(lock, [this] { return stopping || !jobs.empty(); });
+            if (jobs.empty()) return;
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+        finalize(job);
+    }
+}
+
+void SegmentFinalizer::finalize(Job& job) {
+    if (job.file && job.jsonArray) *job.file << "\n]";
+    job.file.reset();
+
+    std::string path = job.info.path;
+    if (compress) {
+        if (gzipFile(path)) path += ".gz";
+        else std::cerr << "[Writer] Compression failed for " << path << "\n";
+    }
+
+    struct stat st;
+    long long bytes = (stat(path.c_str(), &st) == 0) ? static_cast<long long>(st.st_size) : 0;
+
+    // Nel manifest il percorso è relativo alla cartella della sessione
+    std::string file = path.substr(path.find_last_of('/') + 1);
+
+    std::ostringstream entry;
+    entry.setf(std::ios::fixed, std::ios::floatfield);
+    entry.precision(6);
+    entry << "  { \"sensor\": \"" << job.info.sensor << "\", \"segment\": " << job.info.index
+          << ", \"file\": \"" << file << "\", \"start\": " << job.info.startTime
+          << ", \"end\": " << job.info.endTime << ", \"bytes\": " << bytes
+          << ", \"compressed\": " << (path != job.info.path ? "true" : "false") << " }";
+    manifestEntries.push_back(entry.str());
+    writeManifest();
+}
+
+void SegmentFinalizer::writeManifest() {
+    // Scrittura su file temporaneo + rename: l'uploader non legge mai un manifest parziale
+    std::string tmpPath = baseDir + "/manifest.json.tmp";
+    {
+        std::ofstream out(tmpPath);
+        out << "[\n";
+        for (size_t i = 0; i < manifestEntries.size(); i++) {
+            out << manifestEntries[i] << (i + 1 < manifestEntries.size() ? ",\n" : "\n");
+        }
+        out << "]";
+    }
+    std::rename(tmpPath.c_str(), (baseDir + "/manifest.json").c_str());
+}
@@ -1,9 +1,47 @@
 #include "SensorDevice.h"
 #include <iostream>
 #include <cstring>
+#include <algorithm>
+#include <map>
 #include "json.hpp"
 
-SensorDevice::SensorDevice() : deviceID(0), connected(false) {}
+namespace {
+    const size_t CACHE_LINE = 64;
+    const size_t MIN_BUFFER_BYTES = 4096;
+    const size_t DEFAULT_BUFFER_BYTES = 64 * 1024;   // Componenti senza ODR nello stato (es. MLC)
+    const double MAX_POLL_GAP_SEC = 0.25;            // Dati accumulabili tra due letture dello stesso sensore
+
+    size_t sampleTypeSize(const DeviceStatus::Component& comp) {
+        std::string type = comp.text("data_type");
+        if (type.empty()) return 2;
+        if (type == "int8" || type == "uint8") return 1;
+        if (type == "int32" || type == "uint32" || type == "float") return 4;
+        if (type == "double") return 8;
+        return 2;
+    }
+
+    // Dimensione massima prevista di un blocco letto in un ciclo
+    size_t estimateBlockBytes(const DeviceStatus::Component& comp) {
+        double odr = comp.number("measodr", 0.0);
+        if (odr <= 0.0) odr = comp.number("odr", 0.0);
+        size_t usbPacket = static_cast<size_t>(comp.number("usb_dps", 0.0));
+        if (odr <= 0.0) return std::max(DEFAULT_BUFFER_BYTES, 2 * usbPacket);
+
+        double dim = comp.number("dim", 3.0);
+        double samplesPerTs = comp.number("samples_per_ts", 0.0);
+        double bytesPerSec = odr * dim * sampleTypeSize(comp);
+        if (samplesPerTs > 0.0) bytesPerSec += odr / samplesPerTs * sizeof(double);
+
+        size_t bytes = static_cast<size_t>(bytesPerSec * MAX_POLL_GAP_SEC);
+        bytes = std::max(bytes, std::max(MIN_BUFFER_BYTES, 2 * usbPacket));
+        if (usbPacket > 0) bytes = (bytes + usbPacket - 1) / usbPacket * usbPacket;
+        return bytes;
+    }
+}
+
+SensorDevice::SensorDevice() : deviceID(0), connected(false), statusValid(false), statusParsed(false), bufferArena(256 * 1024), libraryCalls(0), callbackQueue(nullptr) {}
+
+SensorDevice* SensorDevice::callbackTarget = nullptr;
 
 SensorDevice::~SensorDevice() {
     disconnect();
@@ -29,6 +67,7 @@ bool SensorDevice::connect() {
 }
 
 void SensorDevice::disconnect() {
+    if (callbackTarget == this) callbackTarget = nullptr;
     if (connected) {
         hs_datalog_close();
         connected = false;
@@ -36,22 +75,54 @@ void SensorDevice::disconnect() {
 }
 
 std::string SensorDevice::getDeviceAlias() {
+    // Stato già in cache: nessuna richiesta al dispositivo
+    if (statusValid) {
+        std::string alias = getDeviceStatus().alias();
+        if (!alias.empty()) return alias;
+    }
     char* fwInfo = nullptr;
-    if (hs_datalog_get_component_status(deviceID, &fwInfo, (char*)"firmware_info") != ST_HS_DATALOG_OK) {
+    if (hs_datalog_get_component_status(deviceID, &fwInfo, (char*)"firmware_info") != ST_HS_DATALOG_OK || !fwInfo) {
         return "Unknown Device";
     }
-    auto json = nlohmann::json::parse(fwInfo);
-    std::string alias = json["firmware_info"]["alias"];
+    DeviceStatus info;
+    info.parse(fwInfo);
     hs_datalog_free(fwInfo);
-    return alias;
+    std::string alias = info.alias();
+    return alias.empty() ? "Unknown Device" : alias;
+}
+
+bool SensorDevice::getIdentity(int& boardId, int& fwId) {
+    return hs_datalog_get_identity(deviceID, &boardId, &fwId) == ST_HS_DATALOG_OK;
 }
 
 std::string SensorDevice::getDeviceStatusJSON() {
+    if (statusValid) return statusCache;
     char* status = nullptr;
-    if (hs_datalog_get_device_status(deviceID, &status) != ST_HS_DATALOG_OK) return "{}";
-    std::string res(status);
+    if (hs_datalog_get_device_status(deviceID, &status) != ST_HS_DATALOG_OK || !status) return "{}";
+    storeStatus(status);
     hs_datalog_free(status);
-    return res;
+    return statusCache;
+}
+
+const DeviceStatus& SensorDevice::getDeviceStatus() {
+    if (!statusValid) getDeviceStatusJSON();
+    if (!statusParsed) {
+        statusFields.parse(statusValid ? statusCache : std::string("{}"));
+        // Lettura fallita: nuovo tentativo alla prossima richiesta
+        statusParsed = statusValid;
+    }
+    return statusFields;
+}
+
+void SensorDevice::storeStatus(const char* json) {
+    statusCache = json;
+    statusValid = true;
+    statusParsed = false;
+}
+
+void SensorDevice::invalidateStatus() {
+    statusValid = false;
+    statusParsed = false;
 }
 
 bool SensorDevice::setDeviceConfig(const std::string& jsonConfig) {
@@ -60,6 +131,7 @@ bool SensorDevice::setDeviceConfig(const std::string& jsonConfig) {
     
     int res = hs_datalog_set_device_status(deviceID, configStr);
     delete[] configStr;
+    invalidateStatus();
     
     return res == ST_HS_DATALOG_OK;
 }
@@ -78,16 +150,20 @@ bool SensorDevice::loadUCF(const std::string& ucfContent) {
     hs_datalog_set_boolean_property(deviceID, true, (char*)"ism330dhcx_mlc", (char*)"enable", nullptr, &resp2);
     if (resp2) hs_datalog_free(resp2);
 
-    // Aggiorna mappa componenti interna
-    char* devStatus;
-    hs_datalog_get_device_status(deviceID, &devStatus);
-    hs_datalog_update_components_map(deviceID, devStatus);
-    hs_datalog_free(devStatus);
+    // Aggiorna mappa componenti interna; lo stato letto resta in cache per il chiamante
+    invalidateStatus();
+    char* devStatus = nullptr;
+    if (hs_datalog_get_device_status(deviceID, &devStatus) == ST_HS_DATALOG_OK && devStatus) {
+        hs_datalog_update_components_map(deviceID, devStatus);
+        storeStatus(devStatus);
+        hs_datalog_free(devStatus);
+    }
 
     return res == ST_HS_DATALOG_OK;
 }
 
 bool SensorDevice::startLog() {
+    invalidateStatus();
     char* response = nullptr;
     hs_datalog_set_rtc_time(deviceID, &response); // Sincronizzazione ora
     if(response) hs_datalog_free(response);
@@ -98,12 +174,76 @@ bool SensorDevice::startLog() {
 }
 
 bool SensorDevice::stopLog() {
+    invalidateStatus();
     char* response = nullptr;
     hs_datalog_stop_log(deviceID, &response);
     if(response) hs_datalog_free(response);
     return true;
 }
 
+namespace {
+    // Struttura non fissa tra le versioni del firmware: si cercano gli oggetti sw_tagN / hw_tagN con "label"
+    void collectTagClasses(const nlohmann::json& node, std::vector<SensorDevice::TagClass>& out) {
+        if (!node.is_object()) return;
+        for (auto it = node.begin(); it != node.end(); ++it) {
+            if (!it->is_object()) continue;
+            const std::string& key = it.key();
+            bool sw = key.compare(0, 6, "sw_tag") == 0;
+            bool hw = key.compare(0, 6, "hw_tag") == 0;
+            auto label = it->find("label");
+            if ((sw || hw) && label != it->end() && label->is_string()) {
+                SensorDevice::TagClass tag;
+                tag.component = key;
+                tag.label = label->get<std::string>();
+                tag.hardware = hw;
+                out.push_back(tag);
+            } else {
+                collectTagClasses(*it, out);
+            }
+        }
+    }
+}
+
+std::vector<SensorDevice::TagClass> SensorDevice::getTagClasses() {
+    std::vector<TagClass> tags;
+    char* json = nullptr;
+    if (hs_datalog_get_available_tags(deviceID, &json) != ST_HS_DATALOG_OK || !json) return tags;
+    auto parsed = nlohmann::json::parse(json, nullptr, false);
+    hs_datalog_free(json);
+    if (!parsed.is_discarded()) collectTagClasses(parsed, tags);
+    // Ordine numerico (sw_tag2 prima di sw_tag10)
+    std::sort(tags.begin(), tags.end(), [](const TagClass& a, const TagClass& b) {
+        if (a.hardware != b.hardware) return !a.hardware;
+        if (a.component.size() != b.component.size()) return a.component.size() < b.component.size();
+        return a.component < b.component;
+    });
+    return tags;
+}
+
+bool SensorDevice::setSwTagLabel(const std::string& component, const std::string& label) {
+    invalidateStatus();
+    return hs_datalog_set_sw_tag_label(deviceID, const_cast<char*>(component.c_str()),
+                                       const_cast<char*>(label.c_str())) == ST_HS_DATALOG_OK;
+}
+
+bool SensorDevice::setSwTag(const std::string& label, bool on) {
+    invalidateStatus();
+    return hs_datalog_set_on_off_sw_tag(deviceID, const_cast<char*>(label.c_str()), on) == ST_HS_DATALOG_OK;
+}
+
+bool SensorDevice::enableHwTag(const std::string& component, bool enable) {
+    invalidateStatus();
+    return hs_datalog_enable_hw_tag(deviceID, const_cast<char*>(component.c_str()), enable) == ST_HS_DATALOG_OK;
+}
+
+std::string SensorDevice::getAcquisitionInfoJSON() {
+    char* info = nullptr;
+    if (hs_datalog_get_acquisition_info(deviceID, &info) != ST_HS_DATALOG_OK || !info) return "{}";
+    std::string res(info);
+    hs_datalog_free(info);
+    return res;
+}
+
 std::vector<std::string> SensorDevice::getActiveSensors() {
     int nSensors = 0;
     hs_datalog_get_sensor_components_number(deviceID, &nSensors, true);
@@ -126,4 +266,85 @@ bool SensorDevice::getData(const std::string& sensorName, std::vector<uint8_t>&
     
     hs_datalog_get_data(deviceID, const_cast<char*>(sensorName.c_str()), buffer.data(), size, &actualSize);
     return true;
-}
\ No newline at end of file
+}
+
+void SensorDevice::prepareBuffers(const std::vector<std::string>& sensors, const DeviceStatus& status) {
+    // Componenti: { "<nome_componente>": { "odr": ..., "dim": ..., ... } }
+    std::map<std::string, size_t> estimates;
+    for (const auto& comp : status.components()) estimates[comp.name] = estimateBlockBytes(comp);
+
+    buffers.clear();
+    size_t total = 0;
+    for (const auto& name : sensors) {
+        SensorBuffer buf;
+        buf.name = name;
+        auto it = estimates.find(name);
+        buf.capacity = (it != estimates.end()) ? it->second : DEFAULT_BUFFER_BYTES;
+        // Capacità multipla della linea di cache: nessun buffer condivide una linea con un altro
+        buf.capacity = (buf.capacity + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+        buf.data = bufferArena.allocateArray<uint8_t>(buf.capacity, CACHE_LINE);
+        total += buf.capacity;
+        buffers.push_back(buf);
+    }
+    std::cout << "[Device] Preallocated " << total / 1024 << " KB of acquisition buffers for "
+              << buffers.size() << " sensors\n";
+}
+
+bool SensorDevice::getData(size_t sensorIndex, const uint8_t*& data, int& actualSize) {
+    if (sensorIndex >= buffers.size()) return false;
+    SensorBuffer& buf = buffers[sensorIndex];
+    int size = queryAvailable(buf);
+    if (size <= 0 || !readBlock(buf, size, actualSize)) return false;
+    data = buf.data;
+    return true;
+}
+
+int SensorDevice::queryAvailable(SensorBuffer& buf) {
+    int size = 0;
+    hs_datalog_get_available_data_size(deviceID, const_cast<char*>(buf.name.c_str()), &size);
+    libraryCalls++;
+    return size;
+}
+
+bool SensorDevice::readBlock(SensorBuffer& buf, int size, int& actualSize) {
+    if (static_cast<size_t>(size) > buf.capacity) {
+        // Stima superata (ciclo rallentato): nuovo buffer più grande dall'arena, senza perdere dati
+        if (buf.regrowths++ == 0) {
+            std::cerr << "\n[Device] Block of " << size << " bytes exceeds the " << buf.capacity
+                      << " bytes buffer of " << buf.name << "\n";
+        }
+        buf.capacity = (static_cast<size_t>(size) * 2 + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+        buf.data = bufferArena.allocateArray<uint8_t>(buf.capacity, CACHE_LINE);
+    }
+
+    actualSize = 0;
+    int res = hs_datalog_get_data(deviceID, const_cast<char*>(buf.name.c_str()), buf.data, size, &actualSize);
+    libraryCalls++;
+    return res == ST_HS_DATALOG_OK;
+}
+
+bool SensorDevice::enableCallbacks(BlockQueue& queue) {
+    callbackQueue = &queue;
+    callbackTarget = this;
+    bool ok = true;
+    for (auto& buf : buffers) {
+        if (hs_datalog_set_data_ready_callback(deviceID, const_cast<char*>(buf.name.c_str()), &SensorDevice::onDataReady) != ST_HS_DATALOG_OK) {
+            std::cerr << "[Device] Data ready callback not available for " << buf.name << "\n";
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+int SensorDevice::onDataReady(int dId, char* compName, uint8_t* data, int size) {
+    // Thread di acquisizione della libreria: nessun lock, nessuna allocazione
+    SensorDevice* self = callbackTarget;
+    if (!self || dId != self->deviceID || size <= 0) return 0;
+    for (size_t i = 0; i < self->buffers.size(); i++) {
+        if (std::strcmp(self->buffers[i].name.c_str(), compName) == 0) {
+            self->callbackQueue->push(static_cast<uint32_t>(i), data, static_cast<size_t>(size));
+            break;
+        }
+    }
+    return 0;
+}
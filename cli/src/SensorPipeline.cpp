@@ -0,0 +1,297 @@
+#include "SensorPipeline.h"
+#include <iostream>
+#include <cstring>
+#include <chrono>
+#include <cmath>
+
+namespace {
+    // Sorgenti della stima d'assetto
+    const char* ACC_SENSOR = "lsm6dsv16x_acc";
+    const char* GYRO_SENSOR = "lsm6dsv16x_gyro";
+    const char* MAG_SENSOR = "lis2mdl_mag";
+
+    const char* SENSOR_NAMES[] = { ACC_SENSOR, GYRO_SENSOR, MAG_SENSOR };
+
+    // Blocchi in elaborazione oltre i quali la modalità parallela scarta (il pool non tiene il passo)
+    const size_t MAX_TASKS = 512;
+
+    const float DEG_TO_RAD = 0.017453292519943295f;
+
+    // Bande di frequenza (Hz) per l'energia di vibrazione
+    const double VIBRATION_BANDS[] = { 0.0, 5.0, 10.0, 20.0, 50.0, 100.0, 200.0, 400.0 };
+
+    // Avanza il cursore fino all'ultimo campione non successivo a ts
+    inline size_t seekSample(const TriaxialBlock& block, size_t cursor, double ts) {
+        if (cursor >= block.count) cursor = 0;
+        while (cursor + 1 < block.count && block.t[cursor + 1] <= ts) cursor++;
+        return cursor;
+    }
+}
+
+SensorPipeline::SensorPipeline(const std::string& outputDir)
+    : baseDir(outputDir), orientationEnabled(false), firstOrientation(true),
+      orientationPeriod(0.0), nextOrientationTs(0.0), lastGyroTs(0.0),
+      accCursor(0), magCursor(0), spectralEnabled(false), spectralWindow(0),
+      spectralOverlap(0.5), firstVibration(true), dropped(0) {}
+
+SensorPipeline::~SensorPipeline() {
+    close();
+}
+
+double SensorPipeline::getCurrentTimeSec() {
+    auto now = std::chrono::system_clock::now();
+    auto duration = now.time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::duration<double>>(duration).count();
+}
+
+void SensorPipeline::configure(const DeviceStatus& status, const UnitConverter& unitTable) {
+    units = unitTable;
+    // Componenti: { "<nome_componente>": { "odr": ... } }
+    for (const auto& comp : status.components()) {
+        const DeviceStatus::Value* value = comp.find("odr");
+        if (value && value->isNumber()) odr[comp.name] = value->asNumber();
+    }
+}
+
+bool SensorPipeline::enableOrientation(double rateHz) {
+    if (rateHz <= 0.0) return false;
+    // Acc e mag vengono normalizzati dal filtro, la scala del giroscopio invece è indispensabile
+    if (!units.find(GYRO_SENSOR)) {
+        std::cerr << "[Pipeline] No " << GYRO_SENSOR << " sensitivity in the device status, orientation disabled\n";
+        return false;
+    }
+    orientationFile.open(baseDir + "/orientation.json");
+    orientationFile << "[\n";
+    orientationFile.setf(std::ios::fixed, std::ios::floatfield);
+    orientationFile.precision(6);
+    orientationPeriod = 1.0 / rateHz;
+    orientationEnabled = true;
+    return true;
+}
+
+bool SensorPipeline::isValidSpectralWindow(size_t windowSize) {
+    return windowSize >= MIN_SPECTRAL_WINDOW && (windowSize & (windowSize - 1)) == 0;
+}
+
+bool SensorPipeline::enableSpectral(size_t windowSize, double overlap, double vibrationThreshold) {
+    if (!isValidSpectralWindow(windowSize)) {
+        std::cerr << "[Pipeline] Spectral window of " << windowSize << " points is not a power of two >= "
+                  << MIN_SPECTRAL_WINDOW << ", spectral analysis disabled\n";
+        return false;
+    }
+    spectralWindow = windowSize;
+    spectralOverlap = overlap;
+    spectralEnabled = true;
+
+    vibrationFile.open(baseDir + "/vibration.json");
+    vibrationFile << "[\n";
+    vibrationFile.setf(std::ios::fixed, std::ios::floatfield);
+    vibrationFile.precision(6);
+    events.reset(new EventDetector(baseDir, vibrationThreshold));
+    return true;
+}
+
+bool SensorPipeline::decodeTriaxial(const std::string& name, const uint8_t* data, int size, double now, TriaxialBlock& out) {
+    // Formato B: header 4 byte + terne int16 (vedi Spiegazione.md)
+    const int headerSize = PacketLayout::PACKED_HEADER_SIZE;
+    const int sampleSize = PacketLayout::TriaxInt16Packed::sampleSize;
+    if (size < 10 || (size - headerSize) % sampleSize != 0) return false;
+
+    int nSamples = (size - headerSize) / sampleSize;
+
+    double prev = lastBlockEndTime[name];
+    if (prev == 0.0) prev = now - 0.05;
+    double timeStep = (now - prev) / nSamples;
+    lastBlockEndTime[name] = now;
+
+    float scale = units.scaleFor(name);
+
+    SampleDecoder::decode<PacketLayout::TriaxInt16Packed>(data + headerSize, nSamples, out, scale, prev, timeStep);
+    return true;
+}
+
+void SensorPipeline::processBlock(const std::string& name, const uint8_t* data, int size) {
+    if (!orientationEnabled && !spectralEnabled) return;
+    if (name != ACC_SENSOR && name != GYRO_SENSOR && name != MAG_SENSOR) return;
+
+    if (scheduler) {
+        int sensor = (name == ACC_SENSOR) ? ACC : (name == GYRO_SENSOR) ? GYRO : MAG;
+        BlockTask* task = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(taskMutex);
+            if (!freeTasks.empty()) {
+                task = freeTasks.back();
+                freeTasks.pop_back();
+            } else if (tasks.size() < MAX_TASKS) {
+                tasks.emplace_back(new BlockTask());
+                task = tasks.back().get();
+                task->owner = this;
+            }
+        }
+        if (!task) {
+            dropped++;
+            return;
+        }
+        // Il buffer di acquisizione viene riutilizzato alla lettura successiva: copia
+        task->sensor = sensor;
+        task->forOrientation = false;
+        task->hostTime = getCurrentTimeSec();
+        task->raw.assign(data, data + size);
+        scheduler->submit(sensorStrands[sensor], task);
+        return;
+    }
+
+    TriaxialBlock& block = blocks[name];
+    if (!decodeTriaxial(name, data, size, getCurrentTimeSec(), block)) return;
+
+    if (name == ACC_SENSOR) {
+        accCursor = 0;
+        if (spectralEnabled) runSpectral(block);
+    } else if (name == MAG_SENSOR) {
+        magCursor = 0;
+    } else if (orientationEnabled) {
+        runOrientation(block, blocks[ACC_SENSOR], blocks[MAG_SENSOR]);
+    }
+}
+
+void SensorPipeline::enableParallel(int threads) {
+    if (threads < 1 || scheduler) return;
+    // Chiavi create qui: dai worker le mappe vengono solo lette o aggiornate su chiavi esistenti
+    for (const char* name : SENSOR_NAMES) lastBlockEndTime[name] = 0.0;
+    tasks.reserve(MAX_TASKS);
+    freeTasks.reserve(MAX_TASKS);
+    scheduler.reset(new TaskScheduler(threads));
+}
+
+void SensorPipeline::runTask(BlockTask* task) {
+    if (!task->forOrientation) {
+        // Strand del sensore: decodifica e stadi che usano solo questo sensore
+        if (!decodeTriaxial(SENSOR_NAMES[task->sensor], task->raw.data(), static_cast<int>(task->raw.size()),
+                            task->hostTime, task->decoded)) {
+            recycle(task);
+            return;
+        }
+        if (task->sensor == ACC && spectralEnabled) runSpectral(task->decoded);
+        if (orientationEnabled) {
+            task->forOrientation = true;
+            scheduler->submit(orientationStrand, task);
+            return;
+        }
+    } else if (task->sensor == ACC) {
+        // Strand dell'assetto: acc e mag più recenti scambiati (nessuna copia), il giroscopio integra
+        std::swap(orientationAcc, task->decoded);
+        accCursor = 0;
+    } else if (task->sensor == MAG) {
+        std::swap(orientationMag, task->decoded);
+        magCursor = 0;
+    } else {
+        runOrientation(task->decoded, orientationAcc, orientationMag);
+    }
+    recycle(task);
+}
+
+void SensorPipeline::recycle(BlockTask* task) {
+    std::lock_guard<std::mutex> lock(taskMutex);
+    freeTasks.push_back(task);
+}
+
+void SensorPipeline::runSpectral(const TriaxialBlock& acc) {
+    if (!spectral) {
+        // ODR dallo stato del dispositivo, altrimenti stimato dal blocco corrente
+        double rate = 0.0;
+        auto it = odr.find(ACC_SENSOR);
+        if (it != odr.end()) rate = it->second;
+        else if (acc.count > 1 && acc.t[1] > acc.t[0]) rate = 1.0 / (acc.t[1] - acc.t[0]);
+        if (rate <= 0.0) return;
+
+        std::vector<double> edges;
+        for (double e : VIBRATION_BANDS) {
+            if (e < rate / 2.0) edges.push_back(e);
+        }
+        edges.push_back(rate / 2.0);
+        spectral.reset(new SpectralAnalyzer(spectralWindow, spectralOverlap, rate, edges));
+    }
+
+    // Modulo dell'accelerazione: indipendente dall'orientamento del pacco
+    for (size_t i = 0; i < acc.count; i++) {
+        float mag = std::sqrt(acc.x[i] * acc.x[i] + acc.y[i] * acc.y[i] + acc.z[i] * acc.z[i]);
+        if (spectral->push(mag, acc.t[i])) {
+            writeSpectralFrame(spectral->frame());
+            events->onSpectralFrame(spectral->frame());
+        }
+    }
+}
+
+void SensorPipeline::writeSpectralFrame(const SpectralFrame& frame) {
+    if (!firstVibration) vibrationFile << ",\n";
+    else firstVibration = false;
+    vibrationFile << "{ \"timestamp\": " << frame.timestamp
+                  << ", \"dominant_freq\": " << frame.dominantFreq
+                  << ", \"energy\": " << frame.totalEnergy
+                  << ", \"bands\": [";
+    for (size_t b = 0; b < frame.bandEnergy.size(); b++) {
+        if (b > 0) vibrationFile << ", ";
+        vibrationFile << frame.bandEnergy[b];
+    }
+    vibrationFile << "] }";
+}
+
+void SensorPipeline::runOrientation(const TriaxialBlock& gyro, const TriaxialBlock& acc, const TriaxialBlock& mag) {
+    if (acc.count == 0) return;
+
+    // Il giroscopio guida l'integrazione; acc e mag sono allineati per timestamp
+    for (size_t i = 0; i < gyro.count; i++) {
+        double ts = gyro.t[i];
+        float dt = (lastGyroTs > 0.0) ? static_cast<float>(ts - lastGyroTs) : 0.0f;
+        lastGyroTs = ts;
+        if (dt <= 0.0f || dt > 0.5f) continue;
+
+        accCursor = seekSample(acc, accCursor, ts);
+        float gx = gyro.x[i] * DEG_TO_RAD;
+        float gy = gyro.y[i] * DEG_TO_RAD;
+        float gz = gyro.z[i] * DEG_TO_RAD;
+
+        if (mag.count > 0) {
+            magCursor = seekSample(mag, magCursor, ts);
+            orientation.update(gx, gy, gz,
+                               acc.x[accCursor], acc.y[accCursor], acc.z[accCursor],
+                               mag.x[magCursor], mag.y[magCursor], mag.z[magCursor], dt);
+        } else {
+            orientation.updateImu(gx, gy, gz,
+                                  acc.x[accCursor], acc.y[accCursor], acc.z[accCursor], dt);
+        }
+
+        if (ts >= nextOrientationTs) {
+            nextOrientationTs = ts + orientationPeriod;
+            float roll, pitch, yaw;
+            orientation.getEuler(roll, pitch, yaw);
+
+            if (!firstOrientation) orientationFile << ",\n";
+            else firstOrientation = false;
+            orientationFile << "{ \"timestamp\": " << ts
+                            << ", \"roll\": " << roll
+                            << ", \"pitch\": " << pitch
+                            << ", \"yaw\": " << yaw << " }";
+        }
+    }
+}
+
+void SensorPipeline::close() {
+    // Modalità parallela: i blocchi già inviati vengono elaborati prima di chiudere i file
+    if (scheduler) {
+        scheduler->wait();
+        scheduler.reset();
+    }
+    if (orientationFile.is_open()) {
+        orientationFile << "\n]";
+        orientationFile.close();
+    }
+    orientationEnabled = false;
+
+    if (vibrationFile.is_open()) {
+        vibrationFile << "\n]";
+        vibrationFile.close();
+    }
+    if (events) events->close();
+    spectralEnabled = false;
+}
@@ -0,0 +1,475 @@
+#include "SessionSummary.h"
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+#include <limits>
+#include "ImuCodec.h"
+#include "TaskScheduler.h"
+#include "json.hpp"
+
+namespace {
+    // Pezzi da ~2 MB ai confini delle voci dell'indice; ondate di 2 pezzi per thread
+    const uint64_t CHUNK_BYTES = 2 * 1024 * 1024;
+    const int CHUNKS_PER_THREAD = 2;
+
+    // Superamenti della soglia a meno di 50 ms l'uno dall'altro fanno parte dello stesso urto
+    const double SHOCK_MERGE_SEC = 0.05;
+    const size_t SHOCK_CAP = 4 * SessionSummary::MAX_SHOCKS;
+
+    void keepLongestGap(std::vector<SessionSummary::Gap>& gaps, const SessionSummary::Gap& gap) {
+        if (gaps.size() < SessionSummary::MAX_GAPS) {
+            gaps.push_back(gap);
+            return;
+        }
+        auto shortest = std::min_element(gaps.begin(), gaps.end(), [](const SessionSummary::Gap& a, const SessionSummary::Gap& b) {
+            return a.duration < b.duration;
+        });
+        if (shortest->duration < gap.duration) *shortest = gap;
+    }
+
+    // Oltre il limite si scarta il picco più basso, tranne l'ultimo urto (può ancora estendersi)
+    void trimShocks(std::vector<SessionSummary::Shock>& shocks) {
+        while (shocks.size() > SHOCK_CAP) {
+            auto lowest = std::min_element(shocks.begin(), shocks.end() - 1, [](const SessionSummary::Shock& a, const SessionSummary::Shock& b) {
+                return a.peak < b.peak;
+            });
+            shocks.erase(lowest);
+        }
+    }
+}
+
+void SessionSummary::ChannelStats::add(double v) {
+    if (count == 0) {
+        min = max = v;
+    } else {
+        if (v < min) min = v;
+        if (v > max) max = v;
+    }
+    sum += v;
+    count++;
+    sketch.add(v);
+}
+
+void SessionSummary::ChannelStats::merge(const ChannelStats& other) {
+    if (other.count == 0) return;
+    if (count == 0) {
+        min = other.min;
+        max = other.max;
+    } else {
+        min = std::min(min, other.min);
+        max = std::max(max, other.max);
+    }
+    sum += other.sum;
+    count += other.count;
+    sketch.merge(other.sketch);
+}
+
+void SessionSummary::Partial::clear() {
+    samples = 0;
+    bytes = 0;
+    first = last = 0.0;
+    axes = 0;
+    for (auto& c : channels) c = ChannelStats();
+    interval = ChannelStats();
+    gapCount = 0;
+    gapTotal = 0.0;
+    gaps.clear();
+    shockCount = 0;
+    shocks.clear();
+}
+
+struct SessionSummary::SensorJob {
+    std::string name;
+    uint32_t kind = SparseIndex::KIND_RAW;
+    int segments = 0;
+    int skippedSegments = 0;
+    double scale = 1.0;
+    std::string unit;
+    bool detectShocks = false;
+    double shockThreshold = 0.0;
+    double period = 0.0;           // Periodo tipico tra campioni (0: non noto)
+    double gapThreshold = std::numeric_limits<double>::infinity();
+    double nominalOdr = 0.0;
+    Partial total;
+};
+
+struct SessionSummary::ChunkTask : public TaskScheduler::Task {
+    const SensorJob* job = nullptr;
+    const SparseIndex::Segment* segment = nullptr;
+    uint64_t begin = 0;
+    uint64_t end = 0;
+    Partial result;
+    std::vector<char> buffer;
+    std::vector<int16_t> samples;
+    bool failed = false;
+
+    void addSample(double ts, const double* values, int axes) {
+        Partial& r = result;
+        if (r.samples > 0) {
+            double dt = ts - r.last;
+            r.interval.add(dt);
+            if (dt > job->gapThreshold) {
+                r.gapCount++;
+                r.gapTotal += dt;
+                keepLongestGap(r.gaps, Gap{ r.last, dt });
+            }
+        } else {
+            r.first = ts;
+        }
+        r.last = ts;
+        r.samples++;
+        r.axes = axes;
+
+        if (axes == 1) {
+            r.channels[0].add(values[0]);
+            return;
+        }
+        double sq = 0.0;
+        for (int a = 0; a < 3; a++) {
+            r.channels[a].add(values[a]);
+            sq += values[a] * values[a];
+        }
+        double magnitude = std::sqrt(sq);
+        r.channels[3].add(magnitude);
+
+        if (job->detectShocks && magnitude > job->shockThreshold) {
+            if (!r.shocks.empty() && ts - r.shocks.back().end <= SHOCK_MERGE_SEC) {
+                Shock& s = r.shocks.back();
+                s.end = ts;
+                if (magnitude > s.peak) {
+                    s.peak = magnitude;
+                    s.peakTime = ts;
+                }
+            } else {
+                r.shocks.push_back(Shock{ ts, ts, magnitude, ts });
+                r.shockCount++;
+                trimShocks(r.shocks);
+            }
+        }
+    }
+
+    // Oggetti { "timestamp": t, "value": v } o { "timestamp": t, "x": .., "y": .., "z": .. }, uno per riga
+    void parseJson() {
+        const char* p = buffer.data();
+        const char* end = p + buffer.size();
+        double v[4];
+        while (true) {
+            const char* open = static_cast<const char*>(std::memchr(p, '{', end - p));
+            if (!open) break;
+            const char* close = static_cast<const char*>(std::memchr(open, '}', end - open));
+            if (!close) break;
+            p = close + 1;
+
+            int n = 0;
+            for (const char* c = open; c < close && n < 4; c++) {
+                if (*c == ':') v[n++] = std::strtod(c + 1, nullptr);
+            }
+            if (n == 2) {
+                v[1] *= job->scale;
+                addSample(v[0], v + 1, 1);
+            } else if (n == 4) {
+                for (int a = 1; a < 4; a++) v[a] *= job->scale;
+                addSample(v[0], v + 1, 3);
+            }
+        }
+    }
+
+    void parseCodec() {
+        const uint8_t* data = reinterpret_cast<const uint8_t*>(buffer.data());
+        size_t pos = 0;
+        ImuCodec::FrameInfo info;
+        double v[3];
+        while (pos < buffer.size()) {
+            size_t used = ImuCodec::decodeFrame(data + pos, buffer.size() - pos, info, samples);
+            if (used == 0) {
+                pos = ImuCodec::findNextFrame(data, buffer.size(), pos + 1);
+                continue;
+            }
+            pos += used;
+            if (info.nSamples == 0 || info.channels < 3) continue;
+            double dt = (info.tEnd - info.tStart) / info.nSamples;
+            for (uint32_t i = 0; i < info.nSamples; i++) {
+                const int16_t* s = &samples[i * info.channels];
+                for (int a = 0; a < 3; a++) v[a] = s[a] * job->scale;
+                addSample(info.tStart + i * dt, v, 3);
+            }
+        }
+    }
+
+    void run() override {
+        result.clear();
+        failed = !SparseIndex::readRange(*segment, begin, end, buffer);
+        if (failed) return;
+        result.bytes = buffer.size();
+        if (job->kind == SparseIndex::KIND_JSON) {
+            parseJson();
+        } else if (job->kind == SparseIndex::KIND_CODEC) {
+            parseCodec();
+        }
+    }
+};
+
+SessionSummary::SessionSummary(const std::string& outputDir)
+    : baseDir(outputDir), valuesScaled(false), shockThreshold(2.5), elapsedMs(0.0) {}
+
+SessionSummary::~SessionSummary() {}
+
+void SessionSummary::configure(const DeviceStatus& status, const UnitConverter& unitTable, bool scaled) {
+    units = unitTable;
+    valuesScaled = scaled;
+
+    // Componenti: { "<nome_componente>": { "odr": ..., "measodr": ... } }
+    for (const auto& comp : status.components()) {
+        double odr = comp.number("measodr", 0.0);
+        if (odr <= 0.0) odr = comp.number("odr", 0.0);
+        if (odr > 0.0) nominalOdr[comp.name] = odr;
+    }
+}
+
+void SessionSummary::merge(SensorJob& job, Partial& chunk) {
+    Partial& total = job.total;
+    total.bytes += chunk.bytes;
+    if (chunk.samples == 0) return;
+
+    // Continuità al confine tra pezzi (o segmenti) consecutivi
+    if (total.samples > 0) {
+        double dt = chunk.first - total.last;
+        total.interval.add(dt);
+        if (dt > job.gapThreshold) {
+            total.gapCount++;
+            total.gapTotal += dt;
+            keepLongestGap(total.gaps, Gap{ total.last, dt });
+        }
+    } else {
+        total.first = chunk.first;
+    }
+    total.last = chunk.last;
+    total.samples += chunk.samples;
+    total.axes = chunk.axes;
+    for (int c = 0; c < 4; c++) total.channels[c].merge(chunk.channels[c]);
+    total.interval.merge(chunk.interval);
+    total.gapCount += chunk.gapCount;
+    total.gapTotal += chunk.gapTotal;
+    for (const auto& gap : chunk.gaps) keepLongestGap(total.gaps, gap);
+
+    total.shockCount += chunk.shockCount;
+    size_t from = 0;
+    if (!total.shocks.empty() && !chunk.shocks.empty() &&
+        chunk.shocks.front().start - total.shocks.back().end <= SHOCK_MERGE_SEC) {
+        // Urto diviso dal confine del pezzo
+        Shock& last = total.shocks.back();
+        const Shock& next = chunk.shocks.front();
+        last.end = next.end;
+        if (next.peak > last.peak) {
+            last.peak = next.peak;
+            last.peakTime = next.peakTime;
+        }
+        total.shockCount--;
+        from = 1;
+    }
+    for (size_t i = from; i < chunk.shocks.size(); i++) total.shocks.push_back(chunk.shocks[i]);
+    trimShocks(total.shocks);
+}
+
+bool SessionSummary::run(int threads) {
+    auto started = std::chrono::steady_clock::now();
+    threads = std::max(1, threads);
+
+    auto bySensor = SparseIndex::loadDirectory(baseDir);
+    if (bySensor.empty()) {
+        std::cerr << "[Summary] No sparse index in " << baseDir << ", summary skipped\n";
+        return false;
+    }
+
+    // Lavori per sensore e pezzi in ordine di file e di offset
+    struct Chunk {
+        SensorJob* job;
+        const SparseIndex::Segment* segment;
+        uint64_t begin;
+        uint64_t end;
+    };
+    std::vector<std::unique_ptr<SensorJob>> jobs;
+    std::vector<Chunk> chunks;
+    for (const auto& pair : bySensor) {
+        std::unique_ptr<SensorJob> job(new SensorJob());
+        job->name = pair.first;
+        job->kind = pair.second.front().header.kind;
+
+        const UnitConverter::SensorUnits* sensorUnits = units.find(job->name);
+        // Sensibilità solo sui conteggi int16 (sempre nei .imz, nei JSON se non già convertiti con -n);
+        // i layout float sono già in unità fisiche. Indici senza layout: come conteggi
+        bool codec = job->kind == SparseIndex::KIND_CODEC;
+        bool counts = pair.second.front().header.layout != SparseIndex::LAYOUT_VALUES;
+        if (sensorUnits && (codec || (!valuesScaled && counts))) job->scale = sensorUnits->sensitivity;
+        if (sensorUnits) job->unit = sensorUnits->unit;
+        // Urti solo sui valori di accelerazione in g
+        job->detectShocks = job->name.find("acc") != std::string::npos && sensorUnits != nullptr;
+        job->shockThreshold = shockThreshold;
+
+        auto odrIt = nominalOdr.find(job->name);
+        if (odrIt != nominalOdr.end()) job->nominalOdr = odrIt->second;
+
+        // Periodo tipico: mediana dei periodi tra voci consecutive dell'indice, altrimenti ODR nominale
+        std::vector<double> periods;
+        for (const auto& segment : pair.second) {
+            const auto& e = segment.entries;
+            for (size_t i = 1; i < e.size(); i++) {
+                if (e[i].sample > e[i - 1].sample && e[i].sampleTime > e[i - 1].sampleTime) {
+                    periods.push_back((e[i].sampleTime - e[i - 1].sampleTime) / static_cast<double>(e[i].sample - e[i - 1].sample));
+                }
+            }
+        }
+        if (!periods.empty()) {
+            std::nth_element(periods.begin(), periods.begin() + periods.size() / 2, periods.end());
+            job->period = periods[periods.size() / 2];
+        } else if (job->nominalOdr > 0.0) {
+            job->period = 1.0 / job->nominalOdr;
+        }
+        if (job->period > 0.0) job->gapThreshold = GAP_FACTOR * job->period;
+
+        for (const auto& segment : pair.second) {
+            std::ifstream probe(segment.dataPath, std::ios::binary);
+            if (!probe || (segment.compressed && !SparseIndex::canReadCompressed())) {
+                job->skippedSegments++;
+                continue;
+            }
+            job->segments++;
+            const auto& e = segment.entries;
+            uint64_t chunkStart = e.front().offset;
+            // Un .gz si legge solo decomprimendo dall'inizio: un unico pezzo per segmento
+            for (size_t i = 1; i < e.size() && !segment.compressed; i++) {
+                if (e[i].offset - chunkStart >= CHUNK_BYTES) {
+                    chunks.push_back(Chunk{ job.get(), &segment, chunkStart, e[i].offset });
+                    chunkStart = e[i].offset;
+                }
+            }
+            chunks.push_back(Chunk{ job.get(), &segment, chunkStart, std::numeric_limits<uint64_t>::max() });
+        }
+        jobs.push_back(std::move(job));
+    }
+
+    // Ondate di pezzi in parallelo, fusi in ordine: memoria limitata dalla dimensione dell'ondata
+    TaskScheduler scheduler(threads);
+    const size_t wave = static_cast<size_t>(threads * CHUNKS_PER_THREAD);
+    std::vector<ChunkTask> tasks(wave);
+    std::vector<TaskScheduler::Strand> strands(wave);
+    for (size_t next = 0; next < chunks.size(); next += wave) {
+        size_t count = std::min(wave, chunks.size() - next);
+        for (size_t i = 0; i < count; i++) {
+            const Chunk& chunk = chunks[next + i];
+            tasks[i].job = chunk.job;
+            tasks[i].segment = chunk.segment;
+            tasks[i].begin = chunk.begin;
+            tasks[i].end = chunk.end;
+            scheduler.submit(strands[i], &tasks[i]);
+        }
+        scheduler.wait();
+        for (size_t i = 0; i < count; i++) {
+            if (tasks[i].failed) {
+                std::cerr << "[Summary] Cannot read " << tasks[i].segment->dataPath << "\n";
+                continue;
+            }
+            merge(*chunks[next + i].job, tasks[i].result);
+        }
+    }
+
+    elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+    return writeJson(jobs, threads);
+}
+
+bool SessionSummary::writeJson(const std::vector<std::unique_ptr<SensorJob>>& jobs, int threads) {
+    static const double QUANTILES[] = { 0.01, 0.05, 0.25, 0.5, 0.75, 0.95, 0.99 };
+    static const char* QUANTILE_NAMES[] = { "p1", "p5", "p25", "p50", "p75", "p95", "p99" };
+
+    auto channelJson = [](const ChannelStats& c) {
+        nlohmann::json out;
+        out["min"] = c.min;
+        out["max"] = c.max;
+        out["mean"] = c.count ? c.sum / static_cast<double>(c.count) : 0.0;
+        nlohmann::json percentiles;
+        for (size_t q = 0; q < sizeof(QUANTILES) / sizeof(QUANTILES[0]); q++) {
+            percentiles[QUANTILE_NAMES[q]] = c.sketch.quantile(QUANTILES[q]);
+        }
+        out["percentiles"] = percentiles;
+        return out;
+    };
+
+    nlohmann::json summary;
+    summary["generated"] = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+    summary["threads"] = threads;
+    summary["elapsed_ms"] = elapsedMs;
+    summary["sensors"] = nlohmann::json::object();
+
+    for (const auto& jobPtr : jobs) {
+        const SensorJob& job = *jobPtr;
+        Partial& total = jobPtr->total;
+        nlohmann::json sensor;
+        sensor["format"] = job.kind == SparseIndex::KIND_JSON ? "json" : (job.kind == SparseIndex::KIND_CODEC ? "imz" : "raw");
+        sensor["segments"] = job.segments;
+        if (job.skippedSegments > 0) sensor["skipped_segments"] = job.skippedSegments;
+        sensor["bytes"] = total.bytes;
+        if (job.kind == SparseIndex::KIND_RAW) {
+            summary["sensors"][job.name] = sensor;
+            continue;
+        }
+
+        sensor["samples"] = total.samples;
+        sensor["start"] = total.first;
+        sensor["end"] = total.last;
+        double duration = total.last - total.first;
+        sensor["duration"] = duration;
+        nlohmann::json odr;
+        if (job.nominalOdr > 0.0) odr["nominal"] = job.nominalOdr;
+        odr["effective"] = (duration > 0.0 && total.samples > 1) ? static_cast<double>(total.samples - 1) / duration : 0.0;
+        sensor["odr"] = odr;
+        if (!job.unit.empty()) sensor["unit"] = job.unit;
+
+        nlohmann::json channels;
+        if (total.axes == 1) {
+            channels["value"] = channelJson(total.channels[0]);
+        } else if (total.axes == 3) {
+            channels["x"] = channelJson(total.channels[0]);
+            channels["y"] = channelJson(total.channels[1]);
+            channels["z"] = channelJson(total.channels[2]);
+            channels["magnitude"] = channelJson(total.channels[3]);
+        }
+        sensor["channels"] = channels;
+        sensor["interval"] = channelJson(total.interval);
+
+        std::sort(total.gaps.begin(), total.gaps.end(), [](const Gap& a, const Gap& b) { return a.start < b.start; });
+        nlohmann::json gaps;
+        gaps["threshold"] = std::isfinite(job.gapThreshold) ? job.gapThreshold : 0.0;
+        gaps["count"] = total.gapCount;
+        gaps["total_duration"] = total.gapTotal;
+        gaps["list"] = nlohmann::json::array();
+        for (const auto& gap : total.gaps) gaps["list"].push_back({ { "start", gap.start }, { "duration", gap.duration } });
+        sensor["gaps"] = gaps;
+
+        if (job.detectShocks) {
+            std::sort(total.shocks.begin(), total.shocks.end(), [](const Shock& a, const Shock& b) { return a.peak > b.peak; });
+            if (total.shocks.size() > MAX_SHOCKS) total.shocks.resize(MAX_SHOCKS);
+            nlohmann::json shocks;
+            shocks["threshold_g"] = job.shockThreshold;
+            shocks["count"] = total.shockCount;
+            shocks["peaks"] = nlohmann::json::array();
+            for (const auto& shock : total.shocks) {
+                shocks["peaks"].push_back({ { "start", shock.start }, { "end", shock.end },
+                                            { "peak", shock.peak }, { "peak_time", shock.peakTime } });
+            }
+            sensor["shocks"] = shocks;
+        }
+        summary["sensors"][job.name] = sensor;
+    }
+
+    std::ofstream out(baseDir + "/summary.json");
+    if (!out) {
+        std::cerr << "[Summary] Cannot write summary.json\n";
+        return false;
+    }
+    out << summary.dump(4);
+    return true;
+}
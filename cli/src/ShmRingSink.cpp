@@ -0,0 +1,176 @@
+#include "ShmRingSink.h"
+#include <iostream>
+#include <cstring>
+#include <new>
+
+#ifdef __linux__
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+namespace {
+    const uint32_t RING_MAGIC = 0x52534746;
+    const uint32_t RING_VERSION = 1;
+    const size_t HEADER_SIZE = 4096;
+    const size_t OFF_RESERVE = 0x40;
+    const size_t OFF_COMMIT = 0x80;
+    const size_t OFF_SEQUENCE = 0xC0;
+    const size_t OFF_SENSOR_COUNT = 0x18;
+    const size_t OFF_SENSOR_TABLE = 0x100;
+    const size_t SENSOR_NAME_LEN = 32;
+    const uint32_t MAX_SENSORS = 64;
+    const uint32_t PADDING_RECORD = 0xFFFFFFFF;
+
+    struct RecordHeader {
+        uint32_t length;
+        uint32_t sensor;
+        uint64_t sequence;
+        double timestamp;
+        uint32_t payloadSize;
+        uint32_t reserved;
+    };
+    static_assert(sizeof(RecordHeader) == 32, "layout del record condiviso");
+}
+
+ShmRingSink::ShmRingSink(const std::string& name, size_t capacity)
+    : name(name), capacity(0), mapSize(0), base(nullptr), dataArea(nullptr),
+      reservePos(nullptr), commitPos(nullptr), sequence(nullptr) {
+    // Capacità arrotondata alla potenza di due superiore
+    size_t c = 4096;
+    while (c < capacity) c <<= 1;
+    this->capacity = c;
+}
+
+ShmRingSink::~ShmRingSink() {
+    close();
+}
+
+#ifdef __linux__
+
+bool ShmRingSink::open() {
+    if (!std::atomic<uint64_t>::is_always_lock_free) {
+        std::cerr << "[SHM] 64-bit atomics are not lock-free on this platform\n";
+        return false;
+    }
+
+    std::string shmName = "/" + name;
+    int fd = shm_open(shmName.c_str(), O_CREAT | O_RDWR, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    if (fd < 0) {
+        std::cerr << "[SHM] Cannot create /dev/shm" << shmName << "\n";
+        return false;
+    }
+    mapSize = HEADER_SIZE + capacity;
+    if (ftruncate(fd, mapSize) != 0) {
+        ::close(fd);
+        return false;
+    }
+    void* p = mmap(nullptr, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) return false;
+
+    base = static_cast<uint8_t*>(p);
+    dataArea = base + HEADER_SIZE;
+    std::memset(base, 0, HEADER_SIZE);
+
+    uint64_t cap64 = capacity;
+    uint64_t off64 = HEADER_SIZE;
+    std::memcpy(base + 0x08, &cap64, sizeof(cap64));
+    std::memcpy(base + 0x10, &off64, sizeof(off64));
+    std::memcpy(base + 0x04, &RING_VERSION, sizeof(RING_VERSION));
+
+    reservePos = new (base + OFF_RESERVE) std::atomic<uint64_t>(0);
+    commitPos = new (base + OFF_COMMIT) std::atomic<uint64_t>(0);
+    sequence = new (base + OFF_SEQUENCE) std::atomic<uint64_t>(0);
+
+    // Il magic per ultimo: i lettori attendono un header completo
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(base, &RING_MAGIC, sizeof(RING_MAGIC));
+    return true;
+}
+
+void ShmRingSink::close() {
+    if (!base) return;
+    munmap(base, mapSize);
+    shm_unlink(("/" + name).c_str());
+    base = dataArea = nullptr;
+    reservePos = commitPos = sequence = nullptr;
+}
+
+#else
+
+bool ShmRingSink::open() {
+    std::cerr << "[SHM] Not supported on this platform\n";
+    return false;
+}
+
+void ShmRingSink::close() {}
+
+#endif
+
+uint32_t ShmRingSink::getChannel(const std::string& channel) {
+    auto it = channelIndex.find(channel);
+    if (it != channelIndex.end()) return it->second;
+
+    uint32_t idx = static_cast<uint32_t>(channelIndex.size());
+    if (idx >= MAX_SENSORS) return PADDING_RECORD;
+
+    uint8_t* entry = base + OFF_SENSOR_TABLE + idx * SENSOR_NAME_LEN;
+    std::strncpy(reinterpret_cast<char*>(entry), channel.c_str(), SENSOR_NAME_LEN - 1);
+    // Il nome va pubblicato prima del contatore che lo rende visibile
+    std::atomic_thread_fence(std::memory_order_release);
+    uint32_t count = idx + 1;
+    std::memcpy(base + OFF_SENSOR_COUNT, &count, sizeof(count));
+
+    channelIndex[channel] = idx;
+    return idx;
+}
+
+void ShmRingSink::copyIn(uint64_t pos, const void* src, size_t len) {
+    size_t offset = pos & (capacity - 1);
+    std::memcpy(dataArea + offset, src, len);
+}
+
+void ShmRingSink::onData(const std::string& sensorName, const uint8_t* data, int size, double timestamp) {
+    publish(sensorName, data, size, timestamp);
+}
+
+void ShmRingSink::publish(const std::string& channel, const uint8_t* data, size_t size, double timestamp) {
+    if (!base) return;
+    uint32_t sensor = getChannel(channel);
+    if (sensor == PADDING_RECORD) return;
+
+    size_t length = (sizeof(RecordHeader) + size + 7) & ~static_cast<size_t>(7);
+    if (length > capacity / 2) return;
+
+    uint64_t head = commitPos->load(std::memory_order_relaxed);
+    size_t offset = head & (capacity - 1);
+
+    // Il record non viene mai spezzato: si inserisce un padding fino a fine buffer
+    size_t toEnd = capacity - offset;
+    uint64_t padding = (toEnd < length) ? toEnd : 0;
+
+    reservePos->store(head + padding + length, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    if (padding > 0) {
+        RecordHeader pad = { static_cast<uint32_t>(padding), PADDING_RECORD, 0, 0.0, 0, 0 };
+        if (padding >= sizeof(pad)) copyIn(head, &pad, sizeof(pad));
+        else copyIn(head, &pad, 8); // Basta la lunghezza (allineamento a 8 byte)
+        head += padding;
+    }
+
+    RecordHeader rec;
+    rec.length = static_cast<uint32_t>(length);
+    rec.sensor = sensor;
+    rec.sequence = sequence->load(std::memory_order_relaxed) + 1;
+    rec.timestamp = timestamp;
+    rec.payloadSize = static_cast<uint32_t>(size);
+    rec.reserved = 0;
+    copyIn(head, &rec, sizeof(rec));
+    copyIn(head + sizeof(rec), data, size);
+
+    sequence->store(rec.sequence, std::memory_order_relaxed);
+    commitPos->store(head + length, std::memory_order_release);
+}
@@ -0,0 +1,149 @@
+#include "SparseIndex.h"
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+#ifdef __linux__
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+#ifdef HSD_HAVE_ZLIB
+#include <cstdio>
+#include <zlib.h>
+#endif
+
+namespace SparseIndex {
+
+Header makeHeader(const std::string& sensor, Kind kind, uint32_t interval) {
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, MAGIC, sizeof(header.magic));
+    header.interval = interval;
+    header.kind = kind;
+    header.layout = (kind == KIND_CODEC) ? LAYOUT_COUNTS : LAYOUT_UNKNOWN;
+    std::strncpy(header.sensor, sensor.c_str(), sizeof(header.sensor) - 1);
+    return header;
+}
+
+bool load(const std::string& path, Header& header, std::vector<Entry>& entries) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) return false;
+    std::streamoff size = in.tellg();
+    if (size < static_cast<std::streamoff>(sizeof(Header))) return false;
+    in.seekg(0);
+    in.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!in || std::memcmp(header.magic, MAGIC, sizeof(header.magic)) != 0) return false;
+    header.sensor[sizeof(header.sensor) - 1] = '\0';
+
+    // Una voce troncata in coda (acquisizione interrotta) viene ignorata
+    size_t count = static_cast<size_t>(size - sizeof(Header)) / sizeof(Entry);
+    entries.resize(count);
+    in.read(reinterpret_cast<char*>(entries.data()), static_cast<std::streamsize>(count * sizeof(Entry)));
+    return static_cast<bool>(in);
+}
+
+std::map<std::string, std::vector<Segment>> loadDirectory(const std::string& dir) {
+    std::map<std::string, std::vector<Segment>> bySensor;
+#ifdef __linux__
+    DIR* d = opendir(dir.c_str());
+    if (!d) return bySensor;
+    while (dirent* ent = readdir(d)) {
+        std::string name = ent->d_name;
+        if (name.size() <= 4 || name.compare(name.size() - 4, 4, ".idx") != 0) continue;
+        Segment seg;
+        seg.dataPath = dir + "/" + name.substr(0, name.size() - 4);
+        if (!load(dir + "/" + name, seg.header, seg.entries) || seg.entries.empty()) continue;
+        // Segmento finalizzato con -z: l'indice resta accanto al file compresso
+        struct stat st;
+        if (stat(seg.dataPath.c_str(), &st) != 0 && stat((seg.dataPath + ".gz").c_str(), &st) == 0) {
+            seg.dataPath += ".gz";
+            seg.compressed = true;
+        }
+        bySensor[seg.header.sensor].push_back(std::move(seg));
+    }
+    closedir(d);
+    for (auto& pair : bySensor) {
+        std::sort(pair.second.begin(), pair.second.end(), [](const Segment& a, const Segment& b) {
+            return a.entries.front().hostTime < b.entries.front().hostTime;
+        });
+    }
+#endif
+    return bySensor;
+}
+
+bool readRange(const Segment& segment, uint64_t begin, uint64_t end, std::vector<char>& out) {
+    out.clear();
+    if (segment.compressed) {
+#ifdef HSD_HAVE_ZLIB
+        gzFile in = gzopen(segment.dataPath.c_str(), "rb");
+        if (!in) return false;
+        gzbuffer(in, 128 * 1024);
+        if (begin > 0 && gzseek(in, static_cast<z_off_t>(begin), SEEK_SET) < 0) {
+            gzclose(in);
+            return false;
+        }
+        // A passi di 1 MB: con end oltre la fine la dimensione non compressa non è nota
+        const size_t STEP = 1024 * 1024;
+        uint64_t wanted = (begin < end) ? end - begin : 0;
+        while (out.size() < wanted) {
+            size_t used = out.size();
+            size_t step = static_cast<size_t>(std::min<uint64_t>(STEP, wanted - used));
+            out.resize(used + step);
+            int got = gzread(in, out.data() + used, static_cast<unsigned>(step));
+            if (got < 0) {
+                gzclose(in);
+                return false;
+            }
+            out.resize(used + static_cast<size_t>(got));
+            if (static_cast<size_t>(got) < step) break;
+        }
+        gzclose(in);
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    std::ifstream in(segment.dataPath, std::ios::binary | std::ios::ate);
+    if (!in) return false;
+    uint64_t size = static_cast<uint64_t>(in.tellg());
+    end = std::min(end, size);
+    if (begin >= end) return true;
+    out.resize(end - begin);
+    in.seekg(static_cast<std::streamoff>(begin));
+    in.read(out.data(), static_cast<std::streamsize>(out.size()));
+    return static_cast<bool>(in);
+}
+
+bool canReadCompressed() {
+#ifdef HSD_HAVE_ZLIB
+    return true;
+#else
+    return false;
+#endif
+}
+
+size_t lowerEntry(const std::vector<Entry>& entries, double t) {
+    size_t upper = upperEntry(entries, t);
+    return (upper > 0) ? upper - 1 : 0;
+}
+
+size_t upperEntry(const std::vector<Entry>& entries, double t) {
+    auto it = std::upper_bound(entries.begin(), entries.end(), t,
+                               [](double value, const Entry& e) { return value < e.hostTime; });
+    return static_cast<size_t>(it - entries.begin());
+}
+
+double hostToSampleTime(const std::vector<Entry>& entries, double t) {
+    if (entries.empty()) return t;
+    if (entries.size() == 1) return entries[0].sampleTime + (t - entries[0].hostTime);
+
+    // Segmento tra due voci consecutive (il primo o l'ultimo fuori dall'intervallo coperto)
+    size_t i = std::min(lowerEntry(entries, t), entries.size() - 2);
+    const Entry& a = entries[i];
+    const Entry& b = entries[i + 1];
+    double span = b.hostTime - a.hostTime;
+    if (span <= 0.0) return a.sampleTime + (t - a.hostTime);
+    return a.sampleTime + (t - a.hostTime) * (b.sampleTime - a.sampleTime) / span;
+}
+
+}
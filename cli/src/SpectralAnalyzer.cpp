@@ -0,0 +1,143 @@
+#include "SpectralAnalyzer.h"
+#include <cmath>
+
+namespace {
+    const double PI = 3.14159265358979323846;
+}
+
+SpectralAnalyzer::SpectralAnalyzer(size_t windowSize, double overlap, double sampleRate,
+                                   const std::vector<double>& bandEdges)
+    : windowSize(windowSize), sampleRate(sampleRate), bandEdges(bandEdges),
+      windowPower(0.0), ringPos(0), filled(0), sinceLast(0) {
+    if (overlap < 0.0) overlap = 0.0;
+    if (overlap > 0.95) overlap = 0.95;
+    hopSize = static_cast<size_t>(windowSize * (1.0 - overlap));
+    if (hopSize == 0) hopSize = 1;
+
+    // Finestra di Hann (periodica)
+    window.resize(windowSize);
+    for (size_t i = 0; i < windowSize; i++) {
+        window[i] = static_cast<float>(0.5 - 0.5 * std::cos(2.0 * PI * i / windowSize));
+        windowPower += static_cast<double>(window[i]) * window[i];
+    }
+
+    ring.assign(windowSize, 0.0f);
+    frameData.resize(windowSize);
+
+    // FFT reale di N punti calcolata come FFT complessa di N/2 punti
+    size_t half = windowSize / 2;
+    fftBuffer.resize(half);
+    twiddles.resize(half);
+    for (size_t k = 0; k < half; k++) {
+        double angle = -2.0 * PI * k / windowSize;
+        twiddles[k] = std::complex<float>(static_cast<float>(std::cos(angle)), static_cast<float>(std::sin(angle)));
+    }
+
+    bitReverse.resize(half);
+    size_t bits = 0;
+    while ((static_cast<size_t>(1) << bits) < half) bits++;
+    for (size_t i = 0; i < half; i++) {
+        size_t r = 0;
+        for (size_t b = 0; b < bits; b++) {
+            if (i & (static_cast<size_t>(1) << b)) r |= static_cast<size_t>(1) << (bits - 1 - b);
+        }
+        bitReverse[i] = r;
+    }
+
+    // Mappa bin -> banda (bandEdges.size() indica "nessuna banda")
+    size_t nBands = bandEdges.size() > 1 ? bandEdges.size() - 1 : 0;
+    bandOfBin.assign(half + 1, nBands);
+    for (size_t k = 0; k <= half; k++) {
+        double f = k * sampleRate / windowSize;
+        for (size_t b = 0; b < nBands; b++) {
+            if (f >= bandEdges[b] && f < bandEdges[b + 1]) {
+                bandOfBin[k] = b;
+                break;
+            }
+        }
+    }
+    result.bandEnergy.assign(nBands, 0.0);
+}
+
+bool SpectralAnalyzer::push(float sample, double timestamp) {
+    ring[ringPos] = sample;
+    ringPos = (ringPos + 1) % windowSize;
+    if (filled < windowSize) filled++;
+    sinceLast++;
+
+    if (filled < windowSize || sinceLast < hopSize) return false;
+    sinceLast = 0;
+
+    // Linearizza il buffer circolare (il campione più vecchio è in ringPos)
+    size_t tail = windowSize - ringPos;
+    for (size_t i = 0; i < tail; i++) frameData[i] = ring[ringPos + i];
+    for (size_t i = 0; i < ringPos; i++) frameData[tail + i] = ring[i];
+
+    analyze(frameData.data(), timestamp);
+    return true;
+}
+
+void SpectralAnalyzer::fftInPlace() {
+    size_t n = fftBuffer.size();
+    for (size_t i = 0; i < n; i++) {
+        size_t j = bitReverse[i];
+        if (j > i) std::swap(fftBuffer[i], fftBuffer[j]);
+    }
+
+    // Radix-2 iterativa; i twiddle di N/2 punti sono quelli di N punti a passo doppio
+    for (size_t len = 2; len <= n; len <<= 1) {
+        size_t halfLen = len >> 1;
+        size_t step = (2 * n) / len;
+        for (size_t i = 0; i < n; i += len) {
+            for (size_t j = 0; j < halfLen; j++) {
+                std::complex<float> u = fftBuffer[i + j];
+                std::complex<float> v = fftBuffer[i + j + halfLen] * twiddles[j * step];
+                fftBuffer[i + j] = u + v;
+                fftBuffer[i + j + halfLen] = u - v;
+            }
+        }
+    }
+}
+
+void SpectralAnalyzer::analyze(const float* samples, double timestamp) {
+    size_t half = windowSize / 2;
+
+    // Rimozione della componente continua (gravità) prima della finestra
+    double mean = 0.0;
+    for (size_t i = 0; i < windowSize; i++) mean += samples[i];
+    float dc = static_cast<float>(mean / windowSize);
+
+    for (size_t k = 0; k < half; k++) {
+        fftBuffer[k] = std::complex<float>((samples[2 * k] - dc) * window[2 * k],
+                                           (samples[2 * k + 1] - dc) * window[2 * k + 1]);
+    }
+    fftInPlace();
+
+    for (auto& e : result.bandEnergy) e = 0.0;
+    result.totalEnergy = 0.0;
+    result.dominantFreq = 0.0;
+    result.timestamp = timestamp;
+
+    // Separazione dello spettro reale: X[k] = (Z[k] + Z*[M-k])/2 - j W^k (Z[k] - Z*[M-k])/2
+    const double norm = 1.0 / (static_cast<double>(windowSize) * windowPower);
+    size_t nBands = result.bandEnergy.size();
+    double peak = 0.0;
+    for (size_t k = 0; k <= half; k++) {
+        std::complex<float> zk = fftBuffer[k % half];
+        std::complex<float> zc = std::conj(fftBuffer[(half - k) % half]);
+        std::complex<float> even = 0.5f * (zk + zc);
+        std::complex<float> odd = 0.5f * (zk - zc);
+        std::complex<float> w = (k < half) ? twiddles[k] : std::complex<float>(-1.0f, 0.0f);
+        std::complex<float> xk = even + std::complex<float>(0.0f, -1.0f) * w * odd;
+
+        double power = std::norm(xk) * norm;
+        if (k != 0 && k != half) power *= 2.0; // Spettro monolatero
+
+        result.totalEnergy += power;
+        if (bandOfBin[k] < nBands) result.bandEnergy[bandOfBin[k]] += power;
+        if (k > 0 && power > peak) {
+            peak = power;
+            result.dominantFreq = k * sampleRate / windowSize;
+        }
+    }
+}
@@ -0,0 +1,82 @@
+#include "StartupTimeline.h"
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <map>
+#include <algorithm>
+#include "json.hpp"
+
+StartupTimeline::StartupTimeline() : origin(std::chrono::steady_clock::now()) {}
+
+StartupTimeline::Phase::Phase(StartupTimeline& timeline, const char* name, const char* lane)
+    : timeline(timeline), name(name), lane(lane), startMs(timeline.elapsedMs()), open(true) {}
+
+StartupTimeline::Phase::~Phase() {
+    end();
+}
+
+void StartupTimeline::Phase::end() {
+    if (!open) return;
+    open = false;
+    timeline.add(name, lane, startMs, timeline.elapsedMs() - startMs);
+}
+
+void StartupTimeline::mark(const char* name) {
+    add(name, "", elapsedMs(), 0.0);
+}
+
+double StartupTimeline::elapsedMs() const {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - origin).count();
+}
+
+void StartupTimeline::add(const char* name, const char* lane, double startMs, double durationMs) {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.push_back({ name, lane, startMs, durationMs });
+}
+
+std::vector<StartupTimeline::Entry> StartupTimeline::sorted() const {
+    std::vector<Entry> copy;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        copy = entries;
+    }
+    std::stable_sort(copy.begin(), copy.end(), [](const Entry& a, const Entry& b) { return a.startMs < b.startMs; });
+    return copy;
+}
+
+std::string StartupTimeline::summary() const {
+    std::vector<Entry> list = sorted();
+    std::map<std::string, double> busy;
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1) << "Startup timeline (ms):\n";
+    for (const auto& e : list) {
+        if (e.lane.empty()) {
+            out << "  " << std::setw(8) << e.startMs << "            " << e.name << "\n";
+            continue;
+        }
+        out << "  " << std::setw(8) << e.startMs << " +" << std::setw(8) << e.durationMs
+            << "  " << std::left << std::setw(7) << e.lane << std::right << e.name << "\n";
+        busy[e.lane] += e.durationMs;
+    }
+    out << "  busy:";
+    for (const auto& pair : busy) out << " " << pair.first << " " << pair.second << " ms";
+    out << "\n";
+    return out.str();
+}
+
+bool StartupTimeline::writeJson(const std::string& path) const {
+    nlohmann::json phases = nlohmann::json::array();
+    nlohmann::json marks = nlohmann::json::object();
+    for (const auto& e : sorted()) {
+        if (e.lane.empty()) {
+            marks[e.name] = e.startMs;
+        } else {
+            phases.push_back({ { "name", e.name }, { "lane", e.lane },
+                               { "start_ms", e.startMs }, { "duration_ms", e.durationMs } });
+        }
+    }
+    std::ofstream out(path, std::ios::out | std::ios::trunc);
+    if (!out) return false;
+    out << nlohmann::json{ { "phases", phases }, { "marks", marks } }.dump(2) << "\n";
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,361 @@
+#include "StreamServer.h"
+#include <iostream>
+#include <sstream>
+#include <cstring>
+
+#ifdef __linux__
+    #include <sys/socket.h>
+    #include <sys/un.h>
+    #include <sys/epoll.h>
+    #include <sys/uio.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <cerrno>
+#endif
+
+namespace {
+    const char BASE64_TABLE[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    // Ritorna il puntatore dopo l'ultimo carattere scritto
+    uint8_t* writeBase64(uint8_t* out, const uint8_t* data, int size) {
+        int i = 0;
+        for (; i + 2 < size; i += 3) {
+            uint32_t v = (data[i] << 16) | (data[i + 1] << 8) | data[i + 2];
+            *out++ = BASE64_TABLE[(v >> 18) & 0x3F];
+            *out++ = BASE64_TABLE[(v >> 12) & 0x3F];
+            *out++ = BASE64_TABLE[(v >> 6) & 0x3F];
+            *out++ = BASE64_TABLE[v & 0x3F];
+        }
+        if (i < size) {
+            uint32_t v = data[i] << 16;
+            if (i + 1 < size) v |= data[i + 1] << 8;
+            *out++ = BASE64_TABLE[(v >> 18) & 0x3F];
+            *out++ = BASE64_TABLE[(v >> 12) & 0x3F];
+            *out++ = (i + 1 < size) ? BASE64_TABLE[(v >> 6) & 0x3F] : '=';
+            *out++ = '=';
+        }
+        return out;
+    }
+
+    const size_t MAX_COMMAND_LEN = 1024;
+
+    // Classi di dimensione dei frame (intestazione inclusa); oltre l'ultima si usa l'heap
+    const size_t FRAME_SIZE_CLASSES[] = { 1024, 4096, 16384, 65536 };
+}
+
+StreamServer::StreamServer(const std::string& socketPath, SlowPolicy policy, size_t maxQueuedBytes)
+    : socketPath(socketPath), policy(policy), maxQueuedBytes(maxQueuedBytes), listenFd(-1), epollFd(-1) {
+    for (size_t size : FRAME_SIZE_CLASSES) framePools.emplace_back(new BlockPool(arena, size));
+}
+
+StreamServer::~StreamServer() {
+    close();
+}
+
+StreamServer::Frame::~Frame() {
+    if (!buf || --buf->refs > 0) return;
+    if (buf->pool) buf->pool->release(buf);
+    else ::operator delete(buf);
+}
+
+StreamServer::Frame StreamServer::allocateFrame(size_t size) {
+    size_t total = sizeof(FrameBuffer) + size;
+    FrameBuffer* buf = nullptr;
+    BlockPool* pool = nullptr;
+    for (auto& p : framePools) {
+        if (total <= p->blockSize()) {
+            pool = p.get();
+            break;
+        }
+    }
+    buf = static_cast<FrameBuffer*>(pool ? pool->acquire() : ::operator new(total));
+    buf->pool = pool;
+    buf->refs = 1;
+    buf->size = static_cast<uint32_t>(size);
+    return Frame(buf);
+}
+
+StreamServer::Frame StreamServer::makeBinaryFrame(const std::string& sensorName, const uint8_t* data, int size, double timestamp) {
+    uint16_t nameLen = static_cast<uint16_t>(sensorName.size());
+    uint32_t frameLen = static_cast<uint32_t>(sizeof(nameLen) + nameLen + sizeof(timestamp) + size);
+
+    Frame frame = allocateFrame(sizeof(frameLen) + frameLen);
+    uint8_t* p = frame.writableData();
+    std::memcpy(p, &frameLen, sizeof(frameLen)); p += sizeof(frameLen);
+    std::memcpy(p, &nameLen, sizeof(nameLen)); p += sizeof(nameLen);
+    std::memcpy(p, sensorName.data(), nameLen); p += nameLen;
+    std::memcpy(p, &timestamp, sizeof(timestamp)); p += sizeof(timestamp);
+    std::memcpy(p, data, size);
+    return frame;
+}
+
+StreamServer::Frame StreamServer::makeJsonFrame(const std::string& sensorName, const uint8_t* data, int size, double timestamp) {
+    static const char PREFIX[] = "{\"sensor\": \"";
+    static const char MIDDLE[] = "\", \"timestamp\": ";
+    static const char DATA[] = ", \"data\": \"";
+
+    // Timestamp formattato a parte: con valori enormi %.6f supera qualsiasi stima fissa
+    char ts[64];
+    int tsLen = snprintf(ts, sizeof(ts), "%.6f", timestamp);
+    if (tsLen < 0 || static_cast<size_t>(tsLen) >= sizeof(ts)) return Frame();
+
+    // Nome con escape minimo per restare JSON valido (virgolette, backslash, controlli scartati)
+    size_t nameLen = 0;
+    for (char c : sensorName) {
+        if (c == '"' || c == '\\') nameLen += 2;
+        else if (static_cast<unsigned char>(c) >= 0x20) nameLen++;
+    }
+
+    size_t maxLen = sizeof(PREFIX) - 1 + nameLen + sizeof(MIDDLE) - 1 + static_cast<size_t>(tsLen) +
+                    sizeof(DATA) - 1 + (size + 2) / 3 * 4 + 3;
+    Frame frame = allocateFrame(maxLen);
+    uint8_t* p = frame.writableData();
+    std::memcpy(p, PREFIX, sizeof(PREFIX) - 1); p += sizeof(PREFIX) - 1;
+    for (char c : sensorName) {
+        if (c == '"' || c == '\\') *p++ = '\\';
+        if (static_cast<unsigned char>(c) >= 0x20) *p++ = static_cast<uint8_t>(c);
+    }
+    std::memcpy(p, MIDDLE, sizeof(MIDDLE) - 1); p += sizeof(MIDDLE) - 1;
+    std::memcpy(p, ts, static_cast<size_t>(tsLen)); p += tsLen;
+    std::memcpy(p, DATA, sizeof(DATA) - 1); p += sizeof(DATA) - 1;
+    p = writeBase64(p, data, size);
+    std::memcpy(p, "\"}\n", 3);
+    return frame;
+}
+
+void StreamServer::onData(const std::string& sensorName, const uint8_t* data, int size, double timestamp) {
+    // Serializzazione pigra: al più un buffer per formato, condiviso da tutti i client
+    Frame binary, json;
+    for (auto& pair : clients) {
+        Client& client = pair.second;
+        if (!client.subscribed) continue;
+        if (!client.allSensors && !client.sensors.count(sensorName)) continue;
+
+        Frame& frame = client.ndjson ? json : binary;
+        if (!frame) {
+            frame = client.ndjson ? makeJsonFrame(sensorName, data, size, timestamp)
+                                  : makeBinaryFrame(sensorName, data, size, timestamp);
+            if (!frame) continue;   // Timestamp non rappresentabile nella riga JSON
+        }
+
+        if (client.queuedBytes + frame.size() > maxQueuedBytes) {
+            if (policy == SlowPolicy::DropFrames) {
+                client.droppedFrames++;
+                continue;
+            }
+            // Disconnessione differita a poll(): qui si sta iterando sulla mappa
+            client.slow = true;
+            client.subscribed = false;
+            continue;
+        }
+        client.queue.push_back(frame);
+        client.queuedBytes += frame.size();
+    }
+}
+
+#ifdef __linux__
+
+bool StreamServer::start() {
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(addr.sun_path)) return false;
+    std::strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd < 0) return false;
+    unlink(socketPath.c_str());
+    if (bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(listenFd, 8) != 0) {
+        std::cerr << "[Stream] Cannot listen on " << socketPath << "\n";
+        ::close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    epoll_event ev;
+    std::memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = listenFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &ev);
+    return true;
+}
+
+void StreamServer::acceptClients() {
+    while (true) {
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;
+        Client& client = clients[fd];
+        client.fd = fd;
+
+        epoll_event ev;
+        std::memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev);
+    }
+}
+
+void StreamServer::readCommands(Client& client) {
+    char buf[256];
+    bool closed = false;
+    while (true) {
+        ssize_t n = recv(client.fd, buf, sizeof(buf), 0);
+        if (n > 0) {
+            client.command.append(buf, n);
+            if (client.command.size() > MAX_COMMAND_LEN) {
+                dropClient(client.fd);
+                return;
+            }
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else if (n == 0) {
+            // EOF: i comandi già ricevuti vanno eseguiti, l'ultima riga anche senza '\n'
+            closed = true;
+            if (!client.command.empty() && client.command.back() != '\n') client.command += '\n';
+            break;
+        } else {
+            dropClient(client.fd);
+            return;
+        }
+    }
+
+    size_t eol;
+    while ((eol = client.command.find('\n')) != std::string::npos) {
+        std::istringstream line(client.command.substr(0, eol));
+        client.command.erase(0, eol + 1);
+
+        std::string verb, list, format;
+        line >> verb >> list >> format;
+        if (verb == "TAG" && !list.empty()) {
+            if (tagHandler) tagHandler(list, format == "on" ? 1 : (format == "off" ? 0 : -1));
+            continue;
+        }
+        if (verb != "SUBSCRIBE" || list.empty()) continue;
+
+        client.sensors.clear();
+        client.allSensors = (list == "*");
+        std::istringstream names(list);
+        std::string sensor;
+        while (std::getline(names, sensor, ',')) {
+            if (!sensor.empty()) client.sensors.insert(sensor);
+        }
+        client.ndjson = (format == "ndjson");
+        client.subscribed = true;
+    }
+    if (closed) dropClient(client.fd);
+}
+
+bool StreamServer::flushClient(Client& client) {
+    // Invio vettoriale dei frame in coda, senza copie intermedie
+    while (!client.queue.empty()) {
+        iovec iov[64];
+        int count = 0;
+        for (; count < 64 && static_cast<size_t>(count) < client.queue.size(); count++) {
+            const Frame& frame = client.queue.at(count);
+            size_t skip = (count == 0) ? client.frontOffset : 0;
+            iov[count].iov_base = const_cast<uint8_t*>(frame.data()) + skip;
+            iov[count].iov_len = frame.size() - skip;
+        }
+
+        // sendmsg con MSG_NOSIGNAL: un subscriber già disconnesso dà EPIPE invece di SIGPIPE
+        msghdr msg;
+        std::memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = static_cast<size_t>(count);
+        ssize_t n = sendmsg(client.fd, &msg, MSG_NOSIGNAL);
+        if (n < 0) return errno == EAGAIN || errno == EWOULDBLOCK;
+
+        size_t written = static_cast<size_t>(n);
+        client.queuedBytes -= written;
+        while (written > 0) {
+            size_t remaining = client.queue.front().size() - client.frontOffset;
+            if (written >= remaining) {
+                written -= remaining;
+                client.queue.pop_front();
+                client.frontOffset = 0;
+            } else {
+                client.frontOffset += written;
+                written = 0;
+            }
+        }
+    }
+    return true;
+}
+
+void StreamServer::dropClient(int fd) {
+    auto it = clients.find(fd);
+    if (it == clients.end()) return;
+    if (it->second.droppedFrames > 0) {
+        std::cerr << "[Stream] Subscriber dropped " << it->second.droppedFrames << " frames\n";
+    }
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    ::close(fd);
+    clients.erase(it);
+}
+
+void StreamServer::poll() {
+    if (epollFd < 0) return;
+
+    epoll_event events[32];
+    int n = epoll_wait(epollFd, events, 32, 0);
+    for (int i = 0; i < n; i++) {
+        int fd = events[i].data.fd;
+        if (fd == listenFd) {
+            acceptClients();
+            continue;
+        }
+        auto it = clients.find(fd);
+        if (it == clients.end()) continue;
+        // Comandi ancora nel socket letti anche alla chiusura: un client "una tantum" (es. TAG
+        // da socat) scrive e chiude prima del poll successivo
+        if (events[i].events & EPOLLIN) readCommands(it->second);
+        if ((events[i].events & (EPOLLHUP | EPOLLERR)) && clients.count(fd)) dropClient(fd);
+    }
+
+    // Invio dei dati accodati (sendmsg vettoriale non bloccante) e rimozione dei client lenti
+    std::vector<int> toDrop;
+    for (auto& pair : clients) {
+        Client& client = pair.second;
+        if (client.slow) {
+            std::cerr << "[Stream] Disconnecting slow subscriber\n";
+            toDrop.push_back(pair.first);
+            continue;
+        }
+        if (!flushClient(client)) toDrop.push_back(pair.first);
+    }
+    for (int fd : toDrop) dropClient(fd);
+}
+
+void StreamServer::close() {
+    std::vector<int> fds;
+    for (auto& pair : clients) fds.push_back(pair.first);
+    for (int fd : fds) {
+        flushClient(clients[fd]);
+        dropClient(fd);
+    }
+    if (listenFd >= 0) {
+        ::close(listenFd);
+        unlink(socketPath.c_str());
+        listenFd = -1;
+    }
+    if (epollFd >= 0) {
+        ::close(epollFd);
+        epollFd = -1;
+    }
+}
+
+#else
+
+bool StreamServer::start() {
+    std::cerr << "[Stream] Not supported on this platform\n";
+    return false;
+}
+void StreamServer::acceptClients() {}
+void StreamServer::readCommands(Client&) {}
+bool StreamServer::flushClient(Client&) { return true; }
+void StreamServer::dropClient(int) {}
+void StreamServer::poll() {}
+void StreamServer::close() {}
+
+#endif
@@ -4,8 +4,14 @@
 #include <csignal>
 #include <iomanip>
 #include <sstream>
+#include <mutex>
+#include <cstring>
+#include <cerrno>
 
 #ifdef __linux__
+    #include <pthread.h>
+    #include <sched.h>
+    #include <sys/mman.h>
     #include <sys/stat.h>
     #include <sys/ioctl.h>
     #include <termios.h>
@@ -45,6 +51,14 @@ bool SystemUtils::createDirectory(const std::string& path) {
     #endif
 }
 
+bool SystemUtils::removeDirectory(const std::string& path) {
+    #ifdef __linux__
+        return rmdir(path.c_str()) == 0;
+    #elif _WIN32
+        return _rmdir(path.c_str()) == 0;
+    #endif
+}
+
 void SystemUtils::sleepMs(int milliseconds) {
     #ifdef __linux__
         usleep(milliseconds * 1000);
@@ -85,4 +99,117 @@ bool SystemUtils::getKeyboardInput(char *c) {
         }
     #endif
     return false;
-}
\ No newline at end of file
+}
+
+namespace {
+    std::mutex g_roleMutex;
+    std::vector<int> g_roleCpus[3];
+    #ifdef __linux__
+        // Affinità del processo prima di qualsiasi vincolo: la ritrovano i ruoli senza core assegnati
+        cpu_set_t g_processCpus;
+        bool g_haveProcessCpus = false;
+    #endif
+}
+
+std::vector<int> SystemUtils::parseCpuList(const std::string& list) {
+    std::vector<int> cpus;
+    std::stringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (item.empty()) continue;
+        size_t dash = item.find('-');
+        try {
+            int first = std::stoi(item.substr(0, dash));
+            int last = (dash == std::string::npos) ? first : std::stoi(item.substr(dash + 1));
+            for (int c = first; c <= last; c++) cpus.push_back(c);
+        } catch (const std::exception&) {
+            std::cerr << "[System] Invalid CPU list: " << list << "\n";
+            return std::vector<int>();
+        }
+    }
+    return cpus;
+}
+
+void SystemUtils::setRoleCpus(ThreadRole role, const std::vector<int>& cpus) {
+    std::lock_guard<std::mutex> lock(g_roleMutex);
+    #ifdef __linux__
+        if (!g_haveProcessCpus) {
+            CPU_ZERO(&g_processCpus);
+            g_haveProcessCpus = sched_getaffinity(0, sizeof(g_processCpus), &g_processCpus) == 0;
+        }
+    #endif
+    g_roleCpus[static_cast<int>(role)] = cpus;
+}
+
+void SystemUtils::applyThreadRole(ThreadRole role) {
+    std::vector<int> cpus;
+    #ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        bool restore = false;
+    #endif
+    {
+        std::lock_guard<std::mutex> lock(g_roleMutex);
+        cpus = g_roleCpus[static_cast<int>(role)];
+        #ifdef __linux__
+            if (cpus.empty() && g_haveProcessCpus) {
+                set = g_processCpus;
+                restore = true;
+            }
+        #endif
+    }
+
+    #ifdef __linux__
+        if (role != ThreadRole::Acquisition) {
+            int policy;
+            sched_param param;
+            if (pthread_getschedparam(pthread_self(), &policy, &param) == 0 && policy != SCHED_OTHER) {
+                param.sched_priority = 0;
+                pthread_setschedparam(pthread_self(), SCHED_OTHER, &param);
+            }
+        }
+        // Senza core assegnati il thread torna all'affinità del processo, non a quella del thread creatore
+        if (cpus.empty() && !restore) return;
+        for (int c : cpus) CPU_SET(c, &set);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0 && !restore) {
+            std::cerr << "[System] Cannot pin thread to the requested CPUs\n";
+        }
+    #elif _WIN32
+        DWORD_PTR mask = 0;
+        if (cpus.empty()) {
+            DWORD_PTR systemMask = 0;
+            if (!GetProcessAffinityMask(GetCurrentProcess(), &mask, &systemMask)) return;
+        }
+        for (int c : cpus) mask |= (DWORD_PTR)1 << c;
+        SetThreadAffinityMask(GetCurrentThread(), mask);
+    #endif
+}
+
+bool SystemUtils::setRealtimePriority(int priority) {
+    #ifdef __linux__
+        sched_param param;
+        std::memset(&param, 0, sizeof(param));
+        param.sched_priority = priority;
+        int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (err != 0) {
+            std::cerr << "[System] SCHED_FIFO priority " << priority << " not allowed: " << std::strerror(err) << "\n";
+            return false;
+        }
+        return true;
+    #elif _WIN32
+        (void)priority;
+        return SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL) != 0;
+    #endif
+}
+
+bool SystemUtils::lockMemory() {
+    #ifdef __linux__
+        if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+            std::cerr << "[System] mlockall failed: " << std::strerror(errno) << "\n";
+            return false;
+        }
+        return true;
+    #elif _WIN32
+        return false;
+    #endif
+}
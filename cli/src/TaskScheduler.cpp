@@ -0,0 +1,128 @@
+#include "TaskScheduler.h"
+#include "SystemUtils.h"
+
+TaskScheduler::TaskScheduler(int threads)
+    : runnable(0), sleepers(0), pending(0), steals(0), nextWorker(0), stopping(false) {
+    if (threads < 1) threads = 1;
+    for (int i = 0; i < threads; i++) workers.emplace_back(new Worker());
+    for (int i = 0; i < threads; i++) {
+        workers[i]->thread = std::thread(&TaskScheduler::run, this, i);
+    }
+}
+
+TaskScheduler::~TaskScheduler() {
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(idleMutex);
+        stopping = true;
+    }
+    idleCv.notify_all();
+    for (auto& w : workers) {
+        if (w->thread.joinable()) w->thread.join();
+    }
+}
+
+void TaskScheduler::submit(Strand& strand, Task* task) {
+    pending.fetch_add(1);
+    task->next = nullptr;
+    bool schedule = false;
+    int worker;
+    {
+        std::lock_guard<std::mutex> lock(strand.mutex);
+        if (strand.tail) strand.tail->next = task;
+        else strand.head = task;
+        strand.tail = task;
+        if (!strand.scheduled) {
+            strand.scheduled = true;
+            schedule = true;
+        }
+        worker = strand.lastWorker;
+    }
+    if (!schedule) return;   // Lo strand è già in coda o in esecuzione: il task verrà raccolto da lì
+    if (worker < 0) worker = static_cast<int>(nextWorker.fetch_add(1) % workers.size());
+    enqueue(&strand, worker);
+}
+
+void TaskScheduler::enqueue(Strand* strand, int worker) {
+    {
+        std::lock_guard<std::mutex> lock(workers[worker]->mutex);
+        workers[worker]->queue.push_back(strand);
+    }
+    // Dekker con i worker che si addormentano: o vedono runnable > 0, o noi vediamo sleepers > 0
+    runnable.fetch_add(1);
+    if (sleepers.load() > 0) {
+        std::lock_guard<std::mutex> lock(idleMutex);
+        idleCv.notify_one();
+    }
+}
+
+TaskScheduler::Strand* TaskScheduler::take(int index) {
+    size_t n = workers.size();
+    for (size_t k = 0; k < n; k++) {
+        Worker& w = *workers[(index + k) % n];
+        std::lock_guard<std::mutex> lock(w.mutex);
+        if (w.queue.empty()) continue;
+        Strand* strand = w.queue.front();
+        w.queue.pop_front();
+        runnable.fetch_sub(1);
+        if (k > 0) steals.fetch_add(1, std::memory_order_relaxed);
+        return strand;
+    }
+    return nullptr;
+}
+
+void TaskScheduler::execute(Strand* strand, int index) {
+    // Si prelevano tutti i task presenti; quelli inviati nel frattempo restano nello strand
+    Task* list;
+    {
+        std::lock_guard<std::mutex> lock(strand->mutex);
+        list = strand->head;
+        strand->head = strand->tail = nullptr;
+        strand->lastWorker = index;
+    }
+
+    uint64_t done = 0;
+    while (list) {
+        Task* next = list->next;
+        list->next = nullptr;
+        list->run();
+        list = next;
+        done++;
+    }
+
+    bool requeue;
+    {
+        std::lock_guard<std::mutex> lock(strand->mutex);
+        requeue = strand->head != nullptr;
+        if (!requeue) strand->scheduled = false;
+    }
+    // In fondo alla propria coda: gli altri strand in attesa hanno il loro turno
+    if (requeue) enqueue(strand, index);
+
+    if (pending.fetch_sub(done) == done) {
+        std::lock_guard<std::mutex> lock(idleMutex);
+        doneCv.notify_all();
+    }
+}
+
+void TaskScheduler::run(int index) {
+    SystemUtils::applyThreadRole(SystemUtils::ThreadRole::Dsp);
+    while (true) {
+        Strand* strand = take(index);
+        if (strand) {
+            execute(strand, index);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(idleMutex);
+        sleepers.fetch_add(1);
+        while (!stopping && runnable.load() <= 0) idleCv.wait(lock);
+        sleepers.fetch_sub(1);
+        if (stopping && runnable.load() <= 0) break;
+    }
+}
+
+void TaskScheduler::wait() {
+    std::unique_lock<std::mutex> lock(idleMutex);
+    doneCv.wait(lock, [this]() { return pending.load() == 0; });
+}
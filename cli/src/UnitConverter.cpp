@@ -0,0 +1,54 @@
+#include "UnitConverter.h"
+#include <fstream>
+#include "json.hpp"
+
+namespace {
+    // Unità dedotta dal nome del componente (stessa convenzione di DataWriter)
+    const char* unitForSensor(const std::string& name) {
+        if (name.find("_acc") != std::string::npos) return "g";
+        if (name.find("_gyro") != std::string::npos) return "dps";
+        if (name.find("_mag") != std::string::npos) return "gauss";
+        return nullptr;
+    }
+}
+
+void UnitConverter::configure(const DeviceStatus& status) {
+    sensors.clear();
+    // Componenti: { "<nome_componente>": { "sensitivity": ..., "fs": ... } }
+    for (const auto& comp : status.components()) {
+        const char* unit = unitForSensor(comp.name);
+        const DeviceStatus::Value* sensitivity = comp.find("sensitivity");
+        if (!unit || !sensitivity || !sensitivity->isNumber()) continue;
+
+        SensorUnits units;
+        units.sensitivity = sensitivity->asNumber();
+        units.fullScale = comp.number("fs", 0.0);
+        units.unit = unit;
+        sensors[comp.name] = units;
+    }
+}
+
+const UnitConverter::SensorUnits* UnitConverter::find(const std::string& sensorName) const {
+    auto it = sensors.find(sensorName);
+    return (it != sensors.end()) ? &it->second : nullptr;
+}
+
+float UnitConverter::scaleFor(const std::string& sensorName, float defaultValue) const {
+    const SensorUnits* units = find(sensorName);
+    return units ? static_cast<float>(units->sensitivity) : defaultValue;
+}
+
+bool UnitConverter::writeSummary(const std::string& path) const {
+    nlohmann::json summary = nlohmann::json::object();
+    for (const auto& pair : sensors) {
+        summary[pair.first] = {
+            { "unit", pair.second.unit },
+            { "sensitivity", pair.second.sensitivity },
+            { "full_scale", pair.second.fullScale }
+        };
+    }
+    std::ofstream out(path);
+    if (!out) return false;
+    out << summary.dump(4);
+    return true;
+}
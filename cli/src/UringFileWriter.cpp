@@ -0,0 +1,208 @@
+#include "AsyncFileWriter.h"
+#include <iostream>
+#include <cstring>
+
+#ifdef __linux__
+    #include <linux/io_uring.h>
+    #include <sys/syscall.h>
+    #include <sys/mman.h>
+    #include <sys/uio.h>
+    #include <unistd.h>
+    #include <cerrno>
+#endif
+
+#if defined(__linux__) && defined(__NR_io_uring_setup)
+
+namespace {
+    int sysSetup(unsigned entries, io_uring_params* p) {
+        return static_cast<int>(syscall(__NR_io_uring_setup, entries, p));
+    }
+    int sysEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+        return static_cast<int>(syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+    }
+    int sysRegister(int fd, unsigned opcode, void* arg, unsigned nArgs) {
+        return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, nArgs));
+    }
+
+    template <typename T>
+    T* ringPtr(void* base, unsigned offset) {
+        return reinterpret_cast<T*>(static_cast<uint8_t*>(base) + offset);
+    }
+}
+
+UringFileWriter::UringFileWriter(size_t bufferSize, size_t nBuffers)
+    : AsyncFileWriter(bufferSize, nBuffers), ringFd(-1), fixedBuffers(false), toSubmit(0), inflightOps(0),
+      sqRing(nullptr), cqRing(nullptr), sqes(nullptr), sqRingSize(0), cqRingSize(0), sqesSize(0),
+      sqHead(nullptr), sqTail(nullptr), sqMask(nullptr), sqArray(nullptr), sqEntries(0),
+      cqHead(nullptr), cqTail(nullptr), cqMask(nullptr), cqes(nullptr) {}
+
+UringFileWriter::~UringFileWriter() {
+    stopSyncThread();
+    if (ringFd >= 0) {
+        std::unique_lock<std::mutex> lock(mtx);
+        drainLocked(lock);
+    }
+    for (auto& f : files) {
+        if (f.fd >= 0) ::close(f.fd);
+    }
+    closeRing();
+}
+
+void UringFileWriter::closeRing() {
+    if (sqes) munmap(sqes, sqesSize);
+    if (cqRing && cqRing != sqRing) munmap(cqRing, cqRingSize);
+    if (sqRing) munmap(sqRing, sqRingSize);
+    if (ringFd >= 0) ::close(ringFd);
+    sqes = sqRing = cqRing = nullptr;
+    ringFd = -1;
+}
+
+bool UringFileWriter::init() {
+    // Una SQE per buffer: l'anello non può mai riempirsi
+    unsigned entries = 1;
+    while (entries < buffers.size()) entries <<= 1;
+
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    ringFd = sysSetup(entries, &params);
+    if (ringFd < 0) return false;
+
+    sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool singleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMmap) sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+
+    sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+    if (sqRing == MAP_FAILED) { sqRing = nullptr; closeRing(); return false; }
+    if (singleMmap) {
+        cqRing = sqRing;
+    } else {
+        cqRing = mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+        if (cqRing == MAP_FAILED) { cqRing = nullptr; closeRing(); return false; }
+    }
+    sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    sqes = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) { sqes = nullptr; closeRing(); return false; }
+
+    sqHead = ringPtr<unsigned>(sqRing, params.sq_off.head);
+    sqTail = ringPtr<unsigned>(sqRing, params.sq_off.tail);
+    sqMask = ringPtr<unsigned>(sqRing, params.sq_off.ring_mask);
+    sqArray = ringPtr<unsigned>(sqRing, params.sq_off.array);
+    sqEntries = params.sq_entries;
+    cqHead = ringPtr<unsigned>(cqRing, params.cq_off.head);
+    cqTail = ringPtr<unsigned>(cqRing, params.cq_off.tail);
+    cqMask = ringPtr<unsigned>(cqRing, params.cq_off.ring_mask);
+    cqes = ringPtr<void>(cqRing, params.cq_off.cqes);
+
+    // Registrazione dei buffer del pool: il kernel evita il pin delle pagine ad ogni scrittura
+    std::vector<iovec> iov(registeredBuffers);
+    for (size_t i = 0; i < registeredBuffers; i++) {
+        iov[i].iov_base = buffers[i].data;
+        iov[i].iov_len = buffers[i].capacity;
+    }
+    fixedBuffers = sysRegister(ringFd, IORING_REGISTER_BUFFERS, iov.data(), static_cast<unsigned>(iov.size())) == 0;
+
+    ops.resize(buffers.size());
+    return true;
+}
+
+void UringFileWriter::pushSqe(Buffer* buffer) {
+    Op& op = ops[buffer->index];
+
+    unsigned tail = *sqTail;
+    unsigned idx = tail & *sqMask;
+    io_uring_sqe* sqe = static_cast<io_uring_sqe*>(sqes) + idx;
+    std::memset(sqe, 0, sizeof(*sqe));
+
+    bool fixed = fixedBuffers && static_cast<size_t>(buffer->index) < registeredBuffers;
+    sqe->opcode = fixed ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+    sqe->fd = files[op.file].fd;
+    sqe->off = op.offset + op.done;
+    sqe->addr = reinterpret_cast<uint64_t>(buffer->data + op.done);
+    sqe->len = static_cast<uint32_t>(op.len - op.done);
+    if (fixed) sqe->buf_index = static_cast<uint16_t>(buffer->index);
+    sqe->user_data = static_cast<uint64_t>(buffer->index);
+
+    sqArray[idx] = idx;
+    __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+    toSubmit++;
+    inflightOps++;
+}
+
+void UringFileWriter::enqueueLocked(int file, Buffer* buffer, size_t len, uint64_t offset) {
+    if (ops.size() < buffers.size()) ops.resize(buffers.size());
+    // Se il pool è cresciuto oltre la dimensione dell'anello si attende che si liberi una SQE
+    while (inflightOps >= sqEntries) enterLocked(true);
+    Op& op = ops[buffer->index];
+    op.file = file;
+    op.len = len;
+    op.done = 0;
+    op.offset = offset;
+    pushSqe(buffer);
+}
+
+void UringFileWriter::submitLocked(bool wait, std::unique_lock<std::mutex>&) {
+    enterLocked(wait);
+}
+
+void UringFileWriter::enterLocked(bool wait) {
+    unsigned minComplete = (wait && inflightOps > 0) ? 1 : 0;
+    if (toSubmit > 0 || minComplete > 0) {
+        // Un'unica io_uring_enter invia tutte le scritture in coda (di tutti i file)
+        int r = sysEnter(ringFd, toSubmit, minComplete, minComplete ? IORING_ENTER_GETEVENTS : 0);
+        syscalls++;
+        if (r > 0) toSubmit -= std::min<unsigned>(toSubmit, static_cast<unsigned>(r));
+        else if (r < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+            std::cerr << "[Writer] io_uring_enter failed: " << std::strerror(errno) << "\n";
+        }
+    }
+    reapLocked();
+}
+
+void UringFileWriter::reapLocked() {
+    unsigned head = *cqHead;
+    unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+    while (head != tail) {
+        io_uring_cqe* cqe = static_cast<io_uring_cqe*>(cqes) + (head & *cqMask);
+        Buffer* buffer = &buffers[static_cast<size_t>(cqe->user_data)];
+        Op& op = ops[buffer->index];
+        int res = cqe->res;
+        head++;
+        inflightOps--;
+
+        if (res == -EAGAIN || res == -EINTR) {
+            pushSqe(buffer);
+            continue;
+        }
+        if (res < 0) {
+            std::cerr << "[Writer] write failed: " << std::strerror(-res) << "\n";
+        } else {
+            op.done += res;
+            // Scrittura parziale: si accoda il resto
+            if (res > 0 && op.done < op.len) {
+                pushSqe(buffer);
+                continue;
+            }
+        }
+        completeLocked(op.file, buffer);
+    }
+    __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+}
+
+#else
+
+UringFileWriter::UringFileWriter(size_t bufferSize, size_t nBuffers)
+    : AsyncFileWriter(bufferSize, nBuffers), ringFd(-1), fixedBuffers(false), toSubmit(0), inflightOps(0),
+      sqRing(nullptr), cqRing(nullptr), sqes(nullptr), sqRingSize(0), cqRingSize(0), sqesSize(0),
+      sqHead(nullptr), sqTail(nullptr), sqMask(nullptr), sqArray(nullptr), sqEntries(0),
+      cqHead(nullptr), cqTail(nullptr), cqMask(nullptr), cqes(nullptr) {}
+UringFileWriter::~UringFileWriter() {}
+void UringFileWriter::closeRing() {}
+bool UringFileWriter::init() { return false; }
+void UringFileWriter::pushSqe(Buffer*) {}
+void UringFileWriter::enqueueLocked(int, Buffer*, size_t, uint64_t) {}
+void UringFileWriter::submitLocked(bool, std::unique_lock<std::mutex>&) {}
+void UringFileWriter::enterLocked(bool) {}
+void UringFileWriter::reapLocked() {}
+
+#endif
@@ -3,11 +3,25 @@
 #include <chrono>
 #include <thread>
 #include <iomanip>
+#include <memory>
+#include <sstream>
+#include <future>
 
 #include "ArgParser.h"
 #include "SystemUtils.h"
 #include "SensorDevice.h"
 #include "DataWriter.h"
+#include "AllocCounter.h"
+#include "LatencyStats.h"
+#include "UnitConverter.h"
+#include "SensorPipeline.h"
+#include "MqttSink.h"
+#include "ShmRingSink.h"
+#include "StreamServer.h"
+#include "AnnotationTrack.h"
+#include "StartupTimeline.h"
+#include "ConfigCache.h"
+#include "SessionSummary.h"
 #include "json.hpp"
 
 using namespace std;
@@ -15,9 +29,45 @@ using namespace std;
 
 void printHelp() {
     cout << "HSDatalog CLI Example - Refactored\n"
-         << "Usage: cli_example [-f config.json] [-u config.ucf] [-t timeout_sec]\n"
+         << "Usage: cli_example [-f config.json] [-u config.ucf] [-t timeout_sec] [-o orientation_hz] [-v fft_window]\n"
+         << "                   [-m host[:port]] [-q qos] [-s shm_name] [-l socket_path]\n"
+         << "                   [-r rotate_sec] [-b rotate_mb] [-z] [-c json|delta] [-a]\n"
+         << "                   [-y sync_sec] [-p prealloc_mb] [-d] [-w]\n"
+         << "                   [-A cpus] [-W cpus] [-P cpus] [-R rt_priority] [-L] [-e]\n"
+         << "                   [-j dsp_threads] [-n] [-k mlc_labels.json] [-T tag1,tag2,...] [-H]\n"
+         << "                   [-x index_interval] [-G shock_g] [-N]\n"
          << "  -h : Help\n"
-         << "  -g : Get current device config and exit\n";
+         << "  -g : Get current device config and exit\n"
+         << "  -o : Enable orientation estimation (roll/pitch/yaw) at the given rate\n"
+         << "  -v : Enable accelerometer vibration spectrum (window size, power of two >= 16)\n"
+         << "  -m : Publish live data to an MQTT broker (topic fastgo/sensortile/<sensor>)\n"
+         << "  -q : MQTT QoS level (0 or 1, default 0)\n"
+         << "  -s : Publish live data to a shared-memory ring buffer (/dev/shm/<name>)\n"
+         << "  -l : Serve live data to subscribers on a Unix domain socket\n"
+         << "  -r : Start a new file segment per sensor every N seconds\n"
+         << "  -b : Start a new file segment per sensor every N MB\n"
+         << "  -z : Compress finalized segments (gzip)\n"
+         << "  -c : Output codec for acc/gyro/mag streams (json, delta = delta+zigzag+varint .imz)\n"
+         << "  -a : Asynchronous batched file writes (io_uring, pwrite thread fallback)\n"
+         << "  -y : fdatasync output files every N seconds (implies -a)\n"
+         << "  -p : Preallocate N MB per output file with fallocate (implies -a)\n"
+         << "  -d : Write output files with O_DIRECT, bypassing the page cache (implies -a)\n"
+         << "  -w : Write raw .dat streams through a memory-mapped file readable live\n"
+         << "  -A : Pin the acquisition thread to the given CPUs (e.g. 3 or 2-3)\n"
+         << "  -W : Pin writer threads (async I/O, fsync, segment finalizer) to the given CPUs\n"
+         << "  -P : Pin DSP threads to the given CPUs\n"
+         << "  -R : Run the acquisition thread with SCHED_FIFO at the given priority (1-99)\n"
+         << "  -L : Lock process memory in RAM (mlockall)\n"
+         << "  -e : Event-driven acquisition through the library data ready callbacks\n"
+         << "  -j : Run orientation/spectrum processing on N work-stealing worker threads\n"
+         << "  -n : Write acc/gyro/mag JSON values in physical units (g, dps, gauss)\n"
+         << "  -k : Class labels for the MLC event log ({\"<tree>\": {\"<value>\": \"<label>\"}})\n"
+         << "  -T : Software tag labels (e.g. pickup,delivery,drop), toggled with keys 1-9 or TAG over -l\n"
+         << "  -H : Enable the device hardware tags\n"
+         << "  -x : Sparse index entry every N samples per sensor file (default 1000, 0 = no index)\n"
+         << "  -G : Shock threshold in g for the session summary (default 2.5)\n"
+         << "  -N : Skip the post-session summary (summary.json)\n"
+         << "  -F : Always re-send -f/-u, even if the device already has them (fingerprint cache)\n";
 }
 
 string readFileContent(const string& path) {
@@ -27,6 +77,8 @@ string readFileContent(const string& path) {
 }
 
 int main(int argc, char *argv[]) {
+    // Origine della cronologia di avvio: tutto ciò che precede il primo campione
+    StartupTimeline timeline;
     ArgParser input(argc, argv);
     SystemUtils::setupSignalHandler();
 
@@ -35,13 +87,68 @@ int main(int argc, char *argv[]) {
         return 0;
     }
 
+    // Finestra spettrale controllata prima di connettere il dispositivo
+    if (input.cmdOptionExists("-v") && !SensorPipeline::isValidSpectralWindow(stoul(input.getCmdOption("-v")))) {
+        cerr << "Invalid -v window: " << input.getCmdOption("-v") << " (must be a power of two, at least "
+             << SensorPipeline::MIN_SPECTRAL_WINDOW << ", e.g. 1024)\n";
+        return -1;
+    }
+
+    // --- Preparazione host in parallelo alla connessione ---
+    // Lettura di configurazione e UCF e creazione della cartella mentre la libreria enumera l'USB
+    bool exportOnly = input.cmdOptionExists("-g");
+    string dirName = "./" + SystemUtils::getCurrentTimestampString();
+    string configFile = input.getCmdOption("-f");
+    string ucfFile = input.getCmdOption("-u");
+    struct HostFiles {
+        string config;
+        string ucf;      // Mantenuta in memoria per salvarla dopo
+        string error;
+        bool directory = false;
+        ConfigCache cache;            // Impronte delle configurazioni già applicate
+        ConfigCache::Entry wanted;    // Impronte di -f/-u di questa sessione
+    };
+    future<HostFiles> hostFiles;
+    if (!exportOnly) {
+        hostFiles = async(launch::async, [&]() {
+            HostFiles files;
+            {
+                StartupTimeline::Phase phase(timeline, "read config/UCF files", "host");
+                if (!configFile.empty()) {
+                    files.config = readFileContent(configFile);
+                    if (files.config.empty()) files.error = "Error reading config file: " + configFile;
+                }
+                if (files.error.empty() && !ucfFile.empty()) {
+                    files.ucf = readFileContent(ucfFile);
+                    if (files.ucf.empty()) files.error = "Error reading UCF file.";
+                }
+                files.wanted.config = ConfigCache::hash(files.config);
+                files.wanted.ucf = ConfigCache::hash(files.ucf);
+                if (!configFile.empty() || !ucfFile.empty()) files.cache.load();
+            }
+            if (files.error.empty()) {
+                StartupTimeline::Phase phase(timeline, "create data directory", "host");
+                files.directory = SystemUtils::createDirectory(dirName);
+            }
+            return files;
+        });
+    }
+
     SensorDevice sensor;
-    if (!sensor.connect()) {
+    bool connected;
+    {
+        StartupTimeline::Phase phase(timeline, "connect", "device");
+        connected = sensor.connect();
+    }
+    HostFiles files;
+    if (hostFiles.valid()) files = hostFiles.get();
+    if (!connected) {
+        if (files.directory) SystemUtils::removeDirectory(dirName);
         return -1;
     }
 
     // --- Gestione Export Configurazione Corrente (-g) ---
-    if (input.cmdOptionExists("-g")) {
+    if (exportOnly) {
         string config = sensor.getDeviceStatusJSON();
         ofstream out("device_config.json");
         out << config;
@@ -49,16 +156,38 @@ int main(int argc, char *argv[]) {
         return 0;
     }
 
-    // --- Caricamento Configurazione Dispositivo (-f) ---
-    string configFile = input.getCmdOption("-f");
-    if (!configFile.empty()) {
-        string content = readFileContent(configFile);
-        if (content.empty()) {
-            cerr << "Error reading config file: " << configFile << endl;
-            return -1;
+    if (!files.error.empty()) {
+        cerr << files.error << endl;
+        return -1;
+    }
+
+    // --- Configurazione già presente sul dispositivo (-f/-u) ---
+    // Stesse impronte dei file dell'ultima applicazione su questa scheda e stato del dispositivo
+    // ancora quello lasciato allora: il reinvio viene saltato. Lo stato letto per il confronto
+    // resta in cache e sostituisce la lettura successiva
+    string identity;
+    bool skipConfig = false, skipUcf = false;
+    if (!configFile.empty() || !ucfFile.empty()) {
+        StartupTimeline::Phase phase(timeline, "validate cached config", "device");
+        int boardId = 0, fwId = 0;
+        ConfigCache::Entry previous;
+        if (sensor.getIdentity(boardId, fwId)) identity = ConfigCache::identityKey(boardId, fwId);
+        if (!identity.empty() && !input.cmdOptionExists("-F") &&
+            files.cache.lookup(identity, previous) && previous.config == files.wanted.config) {
+            uint64_t digest = ConfigCache::statusDigest(sensor.getDeviceStatus());
+            skipConfig = (digest != 0 && digest == previous.status);
+            skipUcf = skipConfig && previous.ucf == files.wanted.ucf;
         }
-        if (!sensor.setDeviceConfig(content)) {
+    }
+
+    // --- Caricamento Configurazione Dispositivo (-f) ---
+    if (!configFile.empty() && skipConfig) {
+        cout << "Device configuration unchanged on the device, not re-sent (-F to force).\n";
+    } else if (!configFile.empty()) {
+        StartupTimeline::Phase phase(timeline, "apply device config", "device");
+        if (!sensor.setDeviceConfig(files.config)) {
             cerr << "Error applying device configuration.\n";
+            if (files.directory) SystemUtils::removeDirectory(dirName);
             return -1;
         }
         cout << "Device configuration applied.\n";
@@ -67,49 +196,281 @@ int main(int argc, char *argv[]) {
     }
 
     // --- Caricamento Configurazione UCF/MLC (-u) ---
-    string ucfFile = input.getCmdOption("-u");
-    string ucfContent; // Mantienuta in memoria per salvarla dopo
-    if (!ucfFile.empty()) {
-        ucfContent = readFileContent(ucfFile);
-        if (ucfContent.empty()) {
-            cerr << "Error reading UCF file.\n";
-            return -1;
-        }
-        if (!sensor.loadUCF(ucfContent)) {
+    // Lo stato letto da loadUCF per la mappa dei componenti resta in cache: niente seconda lettura
+    if (!ucfFile.empty() && skipUcf) {
+        cout << "UCF unchanged on the device, not re-sent (-F to force).\n";
+    } else if (!ucfFile.empty()) {
+        StartupTimeline::Phase phase(timeline, "load UCF + components map", "device");
+        if (!sensor.loadUCF(files.ucf)) {
             cerr << "Error loading UCF to MLC.\n";
+            files.wanted.ucf = 0;   // Non applicato: non entra nell'impronta
         } else {
             cout << "UCF loaded successfully.\n";
         }
     }
 
     // --- Preparazione Output ---
-    string dirName = "./" + SystemUtils::getCurrentTimestampString();
-    SystemUtils::createDirectory(dirName);
     cout << "Data Directory: " << dirName << endl;
 
-    // Salvataggio copia dell'UCF 
-    if (!ucfContent.empty()) {
-        ofstream dst(dirName + "/configuration.ucf", ios::binary);
-        dst << ucfContent;
+    // Affinità e priorità dei thread: impostate prima di creare i thread di scrittura ed elaborazione
+    SystemUtils::setRoleCpus(SystemUtils::ThreadRole::Acquisition, SystemUtils::parseCpuList(input.getCmdOption("-A")));
+    SystemUtils::setRoleCpus(SystemUtils::ThreadRole::Writer, SystemUtils::parseCpuList(input.getCmdOption("-W")));
+    SystemUtils::setRoleCpus(SystemUtils::ThreadRole::Dsp, SystemUtils::parseCpuList(input.getCmdOption("-P")));
+    SystemUtils::applyThreadRole(SystemUtils::ThreadRole::Acquisition);
+    if (input.cmdOptionExists("-L") && SystemUtils::lockMemory()) cout << "Process memory locked in RAM.\n";
+    if (input.cmdOptionExists("-R") && SystemUtils::setRealtimePriority(stoi(input.getCmdOption("-R")))) {
+        cout << "Acquisition thread running with SCHED_FIFO priority " << input.getCmdOption("-R") << ".\n";
     }
 
-    // Inizializzazione Writer
+    // I lavori host in parallelo scrivono i messaggi qui; stampati dopo l'attesa, in ordine
+    ostringstream sinkLog, sinkErr, writerLog, writerErr;
+
+    // Copia dell'UCF e destinazioni live (la connessione al broker MQTT può richiedere secondi)
+    unique_ptr<MqttSink> mqtt;
+    unique_ptr<ShmRingSink> shmRing;
+    unique_ptr<StreamServer> streamServer;
+    bool shmOpen = false, streamStarted = false;
+    auto sinksReady = async(launch::async, [&]() {
+        // Creato dopo il ruolo real-time: la connessione MQTT non deve girare in SCHED_FIFO sui core -A
+        SystemUtils::applyThreadRole(SystemUtils::ThreadRole::Writer);
+        StartupTimeline::Phase phase(timeline, "UCF copy + live sinks", "host");
+        if (!files.ucf.empty()) {
+            ofstream dst(dirName + "/configuration.ucf", ios::binary);
+            dst << files.ucf;
+        }
+
+        // Pubblicazione live su MQTT (opzionale)
+        string mqttBroker = input.getCmdOption("-m");
+        if (!mqttBroker.empty()) {
+            string host = mqttBroker;
+            int port = 1883;
+            size_t colon = mqttBroker.rfind(':');
+            if (colon != string::npos) {
+                host = mqttBroker.substr(0, colon);
+                port = stoi(mqttBroker.substr(colon + 1));
+            }
+            int qos = input.cmdOptionExists("-q") ? stoi(input.getCmdOption("-q")) : 0;
+            mqtt.reset(new MqttSink(host, port, "fastgo/sensortile", qos, dirName + "/mqtt_spool.bin"));
+            if (mqtt->start()) {
+                sinkLog << "MQTT connected to " << host << ":" << port << " (QoS " << (qos > 0 ? 1 : 0)
+                        << ", client id " << mqtt->getClientId() << ")\n";
+            } else {
+                sinkErr << "MQTT broker unavailable, spooling to disk until it comes back.\n";
+            }
+        }
+
+        // Ring buffer in memoria condivisa per i processi locali (opzionale)
+        string shmName = input.getCmdOption("-s");
+        if (!shmName.empty()) {
+            shmRing.reset(new ShmRingSink(shmName));
+            shmOpen = shmRing->open();
+            if (shmOpen) sinkLog << "Shared memory ring: /dev/shm/" << shmName << "\n";
+        }
+
+        // Server di streaming su socket Unix (opzionale)
+        string socketPath = input.getCmdOption("-l");
+        if (!socketPath.empty()) {
+            streamServer.reset(new StreamServer(socketPath));
+            streamStarted = streamServer->start();
+            if (streamStarted) sinkLog << "Streaming server: " << socketPath << "\n";
+        }
+    });
+
+    vector<string> activeSensors;
+    {
+        StartupTimeline::Phase phase(timeline, "list active sensors", "device");
+        activeSensors = sensor.getActiveSensors();
+    }
+
+    // Inizializzazione Writer e parsing dello stato in parallelo ai comandi al dispositivo
+    // che seguono (stato, tag, callback); lo stato arriva al lavoro host con statusPromise
     DataWriter writer(dirName);
-    auto activeSensors = sensor.getActiveSensors();
-    writer.initSensorFiles(activeSensors);
+    UnitConverter units;
+    SensorPipeline pipeline(dirName);
+    promise<DeviceStatus> statusPromise;
+    auto writerReady = async(launch::async, [&, statusFuture = statusPromise.get_future()]() mutable {
+        SystemUtils::applyThreadRole(SystemUtils::ThreadRole::Writer);
+        {
+            StartupTimeline::Phase phase(timeline, "writer init", "host");
+            if (input.getCmdOption("-c") == "delta") writer.setCodec(DataWriter::OutputCodec::DeltaVarint);
+            if (input.cmdOptionExists("-x")) writer.setIndexInterval(static_cast<uint32_t>(stoul(input.getCmdOption("-x"))));
+            if (input.cmdOptionExists("-r") || input.cmdOptionExists("-b")) {
+                double rotateSec = input.cmdOptionExists("-r") ? stod(input.getCmdOption("-r")) : 0.0;
+                double rotateMb = input.cmdOptionExists("-b") ? stod(input.getCmdOption("-b")) : 0.0;
+                writer.setRotation(rotateSec, static_cast<size_t>(rotateMb * 1024 * 1024), input.cmdOptionExists("-z"));
+            }
+            if (input.cmdOptionExists("-w") && !writer.enableMappedOutput()) {
+                writerErr << "[Writer] Memory-mapped output not available, using standard file streams\n";
+            }
+            if (input.cmdOptionExists("-y") || input.cmdOptionExists("-p") || input.cmdOptionExists("-d")) {
+                DurabilityPolicy policy;
+                if (input.cmdOptionExists("-y")) policy.syncIntervalSec = stod(input.getCmdOption("-y"));
+                if (input.cmdOptionExists("-p")) policy.preallocateBytes = static_cast<size_t>(stod(input.getCmdOption("-p")) * 1024 * 1024);
+                policy.directIo = input.cmdOptionExists("-d");
+                if (!writer.setDurability(policy)) writerErr << "[Writer] Durability policy not available on this platform\n";
+            } else if (input.cmdOptionExists("-a") && !writer.enableAsyncIo()) {
+                writerErr << "[Writer] Async I/O not available, using standard file streams\n";
+            }
+            writer.initSensorFiles(activeSensors);
+        }
+
+        DeviceStatus deviceStatus = statusFuture.get();
+        StartupTimeline::Phase phase(timeline, "status parse (units, MLC, pipeline)", "host");
+
+        // Sensibilità e fondo scala letti una volta, condivisi da scrittura e pipeline
+        units.configure(deviceStatus);
+        if (input.cmdOptionExists("-n")) {
+            writer.enableUnitConversion(units);
+            writerLog << "Writing acc/gyro/mag values in physical units (g, dps, gauss).\n";
+        }
+
+        // Uscite MLC: cambi di classe su mlc_events.jsonl e sulle destinazioni live
+        if (writer.enableMlcEvents(activeSensors, deviceStatus, input.getCmdOption("-k"))) {
+            writerLog << "MLC class events: " << dirName << "/mlc_events.jsonl\n";
+        }
+
+        // Pipeline di elaborazione online (opzionale)
+        if (input.cmdOptionExists("-o") || input.cmdOptionExists("-v")) {
+            pipeline.configure(deviceStatus, units);
+        }
+        if (input.cmdOptionExists("-o")) pipeline.enableOrientation(stod(input.getCmdOption("-o")));
+        if (input.cmdOptionExists("-v")) pipeline.enableSpectral(stoul(input.getCmdOption("-v")));
+        if (input.cmdOptionExists("-j")) {
+            int dspThreads = stoi(input.getCmdOption("-j"));
+            pipeline.enableParallel(dspThreads);
+            writerLog << "Signal processing on " << dspThreads << " worker threads.\n";
+        }
+
+        // Impronte della configurazione appena applicata, per saltarne il reinvio alla prossima sessione
+        if (!identity.empty() && !(skipConfig && (skipUcf || ucfFile.empty()))) {
+            ConfigCache::Entry applied = files.wanted;
+            applied.status = ConfigCache::statusDigest(deviceStatus);
+            files.cache.store(identity, applied);
+            if (applied.status != 0 && !files.cache.save()) {
+                writerErr << "[Device] Cannot save configuration cache " << ConfigCache::defaultPath() << "\n";
+            }
+        }
+    });
+
+    // Stato del dispositivo letto una volta, dopo la configurazione (in cache se già letto da loadUCF)
+    DeviceStatus deviceStatus;
+    {
+        StartupTimeline::Phase phase(timeline, "device status", "device");
+        deviceStatus = sensor.getDeviceStatus();
+    }
+    statusPromise.set_value(deviceStatus);
+    {
+        StartupTimeline::Phase phase(timeline, "prepare buffers", "host");
+        sensor.prepareBuffers(activeSensors, deviceStatus);
+    }
+
+    // Annotazioni (-T/-H): tag software rinominati con le etichette dell'utente, tag hardware abilitati
+    unique_ptr<AnnotationTrack> annotations;
+    vector<string> tagLabels;
+    if (input.cmdOptionExists("-T") || input.cmdOptionExists("-H")) {
+        StartupTimeline::Phase phase(timeline, "tags", "device");
+        vector<SensorDevice::TagClass> swTags, hwTags;
+        for (const auto& tag : sensor.getTagClasses()) (tag.hardware ? hwTags : swTags).push_back(tag);
+
+        istringstream labels(input.getCmdOption("-T"));
+        string label;
+        while (getline(labels, label, ',')) {
+            if (label.empty()) continue;
+            if (tagLabels.size() >= swTags.size()) {
+                cerr << "[Tags] Device supports " << swTags.size() << " software tags, ignoring '" << label << "'\n";
+                continue;
+            }
+            if (!sensor.setSwTagLabel(swTags[tagLabels.size()].component, label)) {
+                cerr << "[Tags] Cannot set label '" << label << "' on " << swTags[tagLabels.size()].component << "\n";
+            }
+            tagLabels.push_back(label);
+        }
+        if (input.cmdOptionExists("-H")) {
+            for (const auto& tag : hwTags) {
+                if (!sensor.enableHwTag(tag.component, true)) cerr << "[Tags] Cannot enable " << tag.component << "\n";
+            }
+            cout << "Hardware tags enabled: " << hwTags.size() << "\n";
+        }
+
+        annotations.reset(new AnnotationTrack(dirName));
+        if (!annotations->open()) annotations.reset();
+        for (size_t i = 0; i < tagLabels.size() && i < 9; i++) {
+            cout << "Press " << (i + 1) << " to toggle tag '" << tagLabels[i] << "'\n";
+        }
+    }
+
+    // Acquisizione a callback (-e): i thread della libreria accodano i blocchi senza lock
+    unique_ptr<BlockQueue> blockQueue;
+    if (input.cmdOptionExists("-e")) {
+        StartupTimeline::Phase phase(timeline, "register callbacks", "device");
+        blockQueue.reset(new BlockQueue());
+        if (sensor.enableCallbacks(*blockQueue)) {
+            cout << "Event-driven acquisition enabled.\n";
+        } else {
+            cerr << "[Device] Falling back to polling acquisition.\n";
+            blockQueue.reset();
+        }
+    }
+
+    // Attesa dei lavori host: tutto deve essere pronto prima del primo campione
+    {
+        StartupTimeline::Phase phase(timeline, "wait for host work", "wait");
+        writerReady.get();
+        sinksReady.get();
+    }
+    cout << writerLog.str() << sinkLog.str() << flush;
+    cerr << writerErr.str() << sinkErr.str() << flush;
+    if (mqtt) writer.addSink(mqtt.get());
+    if (shmOpen) writer.addSink(shmRing.get());
+    if (streamStarted) writer.addSink(streamServer.get());
+
+    // Inizio/fine di un tag: sul dispositivo (tag software) e nella traccia con gli offset dei file
+    vector<DataWriter::StreamPosition> tagPositions;
+    auto toggleTag = [&](const string& label, int state, const char* source) {
+        if (!annotations) return;
+        bool on = (state < 0) ? !annotations->isActive(label) : (state == 1);
+        if (!sensor.setSwTag(label, on)) cerr << "\n[Tags] Device rejected tag '" << label << "'\n";
+        double now = chrono::duration<double>(chrono::system_clock::now().time_since_epoch()).count();
+        writer.getStreamPositions(tagPositions);
+        const string& line = annotations->record(label, on, source, now, tagPositions);
+        writer.publishEvent("tags", line, now);
+        cout << "\n[Tags] " << label << (on ? " ON" : " OFF") << "\n";
+    };
+    if (streamServer && streamStarted && annotations) {
+        streamServer->setTagHandler([&](const string& label, int state) { toggleTag(label, state, "socket"); });
+    }
 
     // --- Avvio Logging ---
     cout << "Starting log... (Press 'q' or ESC to stop)\n";
-    sensor.startLog();
+    {
+        StartupTimeline::Phase phase(timeline, "set RTC + start log", "device");
+        sensor.startLog();
+    }
+
+    // Cronologia di avvio stampata e salvata all'arrivo del primo campione
+    bool startupReported = false;
+    auto reportStartup = [&]() {
+        startupReported = true;
+        timeline.mark("first_sample");
+        cout << "\nFirst sample " << fixed << setprecision(1) << timeline.elapsedMs() << defaultfloat
+             << " ms after launch.\n" << timeline.summary();
+        timeline.writeJson(dirName + "/startup_timeline.json");
+    };
 
     // Loop Variabili
     auto startTime = chrono::high_resolution_clock::now();
     unsigned long timeout = 0;
     if (input.cmdOptionExists("-t")) timeout = stoul(input.getCmdOption("-t"));
 
-    vector<uint8_t> dataBuffer; 
-    int actualSize = 0;
     long totalBytes = 0;
+    unsigned long iterations = 0;
+    LatencyStats wakeupLatency;
+    LatencyStats callbackLatency;
+
+    // Allocazioni a regime (build Debug): conteggio dopo i primi secondi di riscaldamento
+    const long ALLOC_WARMUP_SEC = 2;
+    bool allocBaselineTaken = false;
+    uint64_t allocBaseline = 0;
 
     // --- Main Loop ---
     while (!g_exit_requested) {
@@ -117,6 +478,8 @@ int main(int argc, char *argv[]) {
         char key;
         if (SystemUtils::getKeyboardInput(&key)) {
             if (key == 'q' || key == 0x1B) g_exit_requested = true;
+            size_t tagIndex = static_cast<size_t>(key - '1');
+            if (key >= '1' && key <= '9' && tagIndex < tagLabels.size()) toggleTag(tagLabels[tagIndex], -1, "key");
         }
 
         // Controllo Timeout
@@ -124,24 +487,106 @@ int main(int argc, char *argv[]) {
         auto elapsedSec = chrono::duration_cast<chrono::seconds>(now - startTime).count();
         if (timeout > 0 && static_cast<unsigned long>(elapsedSec) >= timeout) g_exit_requested = true;
 
+        if (!allocBaselineTaken && elapsedSec >= ALLOC_WARMUP_SEC) {
+            allocBaseline = AllocCounter::allocations();
+            allocBaselineTaken = true;
+        }
+
         // UI Update 
         cout << "\rElapsed: " << elapsedSec << "s | Total Bytes: " << totalBytes << flush;
 
         // Lettura Dati Sensori
-        for (const auto& sName : activeSensors) {
-            if (sensor.getData(sName, dataBuffer, actualSize)) {
-                writer.writeData(sName, dataBuffer.data(), actualSize);
-                totalBytes += actualSize;
+        if (blockQueue) {
+            // Attesa sul doorbell della coda (al più 10 ms), poi consumo di tutti i blocchi pronti
+            blockQueue->wait(10);
+            BlockQueue::Block block;
+            while (blockQueue->front(block)) {
+                const string& name = activeSensors[block.sensor];
+                writer.writeData(name, block.data, static_cast<int>(block.size));
+                pipeline.processBlock(name, block.data, static_cast<int>(block.size));
+                totalBytes += block.size;
+                callbackLatency.record((BlockQueue::nowNs() - block.enqueueNs) / 1000.0);
+                blockQueue->release();
             }
+            if (!startupReported && totalBytes > 0) reportStartup();
+            iterations++;
+            writer.poll();
+            continue;
+        }
+
+        bool morePending = sensor.readAll([&](size_t i, const uint8_t* block, int size) {
+            writer.writeData(activeSensors[i], block, size);
+            pipeline.processBlock(activeSensors[i], block, size);
+            totalBytes += size;
+        });
+        if (!startupReported && totalBytes > 0) reportStartup();
+        iterations++;
+
+        writer.poll();
+        // Raffica ancora in corso: nuovo giro senza dormire
+        if (!morePending) {
+            // Latenza di schedulazione: ritardo del risveglio oltre i 10 ms richiesti
+            auto sleepStart = chrono::steady_clock::now();
+            SystemUtils::sleepMs(10);
+            double sleptUs = chrono::duration<double, micro>(chrono::steady_clock::now() - sleepStart).count();
+            wakeupLatency.record(sleptUs - 10000.0);
         }
-        
-        SystemUtils::sleepMs(10); 
+    }
+
+    if (AllocCounter::enabled() && allocBaselineTaken) {
+        cout << "\nHeap allocations in steady state: " << (AllocCounter::allocations() - allocBaseline) << "\n";
+    }
+
+    if (wakeupLatency.count() > 0) {
+        cout << "\nScheduling latency: " << wakeupLatency.summary() << "\n";
+    }
+    if (callbackLatency.count() > 0) {
+        cout << "\nCallback to consumer latency: " << callbackLatency.summary() << "\n";
+    }
+    if (blockQueue && blockQueue->droppedBlocks() > 0) {
+        cerr << "\n[Device] " << blockQueue->droppedBlocks() << " blocks dropped (callback queue full)\n";
+    }
+    if (iterations > 0 && !blockQueue) {
+        cout << "\nLibrary data calls per iteration: " << fixed << setprecision(2)
+             << static_cast<double>(sensor.libraryCallCount()) / iterations << defaultfloat << "\n";
     }
 
     cout << "\nStopping acquisition...\n";
+    // Tag ancora aperti: chiusi prima dello stop, sul dispositivo e nella traccia
+    if (annotations) {
+        for (const auto& label : annotations->activeLabels()) toggleTag(label, 0, "stop");
+    }
     sensor.stopLog();
+    pipeline.close();
+    if (pipeline.droppedBlocks() > 0) {
+        cerr << "[Pipeline] " << pipeline.droppedBlocks() << " blocks skipped by signal processing (workers behind)\n";
+    }
+    writer.closeAll();
+    // Nessun campione ricevuto: la cronologia di avvio viene salvata comunque
+    if (!startupReported) timeline.writeJson(dirName + "/startup_timeline.json");
+
+    // Indice delle annotazioni, con i tag registrati dal dispositivo (anche hardware)
+    if (annotations) {
+        annotations->setDeviceTags(sensor.getAcquisitionInfoJSON());
+        if (annotations->writeIndex()) {
+            cout << "Annotations: " << annotations->intervalCount() << " intervals in " << dirName << "/annotations_index.json\n";
+        }
+    }
     
+    // Riassunto per sensore (summary.json), in parallelo su sensori e pezzi dei file
+    if (!input.cmdOptionExists("-N")) {
+        int summaryThreads = input.cmdOptionExists("-j") ? stoi(input.getCmdOption("-j"))
+                                                         : static_cast<int>(max(1u, thread::hardware_concurrency()));
+        SessionSummary summary(dirName);
+        summary.configure(deviceStatus, units, input.cmdOptionExists("-n"));
+        if (input.cmdOptionExists("-G")) summary.setShockThreshold(stod(input.getCmdOption("-G")));
+        cout << "Computing session summary...\n";
+        if (summary.run(summaryThreads)) cout << "Summary: " << dirName << "/summary.json\n";
+    }
+
     // Salvataggio configurazione finale
+    // Stato riletto dopo lo stop: ODR misurati, tag e stato del logging finali
+    sensor.invalidateStatus();
     ofstream finalConfig(dirName + "/acquisition_info.json");
     finalConfig << sensor.getDeviceStatusJSON();
     
@@ -0,0 +1,43 @@
+#pragma once
+#include <iostream>
+#include <cmath>
+
+/**
+ * @brief Verifiche minime per i test (nessuna dipendenza esterna).
+ *
+ * CHECK registra il fallimento e prosegue, così un'esecuzione riporta tutte le
+ * verifiche fallite; testResult() è il codice di uscita del test per CTest.
+ */
+namespace TestCheck {
+    inline int& failures() {
+        static int count = 0;
+        return count;
+    }
+
+    inline int testResult(const char* name) {
+        if (failures() == 0) {
+            std::cout << name << ": OK\n";
+            return 0;
+        }
+        std::cout << name << ": " << failures() << " failed checks\n";
+        return 1;
+    }
+}
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #cond ") failed\n"; \
+            TestCheck::failures()++; \
+        } \
+    } while (0)
+
+#define CHECK_NEAR(a, b, tol) \
+    do { \
+        double va_ = (a), vb_ = (b); \
+        if (!(std::fabs(va_ - vb_) <= (tol))) { \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK_NEAR(" #a ", " #b ") failed: " \
+                      << va_ << " vs " << vb_ << "\n"; \
+            TestCheck::failures()++; \
+        } \
+    } while (0)
@@ -0,0 +1,111 @@
+// BlockQueue con più produttori in contesa e un consumatore: nessun blocco perso o
+// duplicato, ordine per produttore rispettato, contenuto intatto anche per i blocchi
+// che occupano più slot
+#include "BlockQueue.h"
+#include "TestCheck.h"
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <cstring>
+
+namespace {
+    const int PRODUCERS = 4;
+    const uint32_t BLOCKS_PER_PRODUCER = 20000;
+    const size_t SLOT_PAYLOAD = 64;
+
+    // Blocco riconoscibile: [uint32 produttore][uint32 numero][byte derivati dai due]
+    size_t blockSize(uint32_t seq) {
+        return 8 + (seq * 37) % (SLOT_PAYLOAD * 3);
+    }
+
+    uint8_t fill(uint32_t producer, uint32_t seq, size_t i) {
+        return static_cast<uint8_t>(producer * 31 + seq * 7 + i);
+    }
+
+    void testContention() {
+        BlockQueue queue(64, SLOT_PAYLOAD);
+        std::atomic<uint64_t> refused(0);
+
+        std::vector<std::thread> producers;
+        for (int p = 0; p < PRODUCERS; p++) {
+            producers.emplace_back([&queue, &refused, p]() {
+                std::vector<uint8_t> block;
+                for (uint32_t seq = 0; seq < BLOCKS_PER_PRODUCER; seq++) {
+                    block.resize(blockSize(seq));
+                    uint32_t producer = static_cast<uint32_t>(p);
+                    std::memcpy(block.data(), &producer, 4);
+                    std::memcpy(block.data() + 4, &seq, 4);
+                    for (size_t i = 8; i < block.size(); i++) block[i] = fill(producer, seq, i);
+                    // Coda piena: il blocco è rifiutato (e contato), qui lo si ripropone
+                    while (!queue.push(producer, block.data(), block.size())) {
+                        refused++;
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+
+        std::vector<uint32_t> expected(PRODUCERS, 0);
+        uint64_t received = 0;
+        bool intact = true;
+        const uint64_t total = static_cast<uint64_t>(PRODUCERS) * BLOCKS_PER_PRODUCER;
+        while (received < total) {
+            if (!queue.wait(100)) continue;
+            BlockQueue::Block block;
+            while (queue.front(block)) {
+                uint32_t producer = 0, seq = 0;
+                if (block.size < 8) {
+                    intact = false;
+                } else {
+                    std::memcpy(&producer, block.data, 4);
+                    std::memcpy(&seq, block.data + 4, 4);
+                    if (producer >= PRODUCERS || block.sensor != producer || seq != expected[producer] ||
+                        block.size != blockSize(seq)) {
+                        intact = false;
+                    } else {
+                        for (size_t i = 8; i < block.size; i++) {
+                            if (block.data[i] != fill(producer, seq, i)) intact = false;
+                        }
+                        expected[producer]++;
+                    }
+                }
+                queue.release();
+                received++;
+            }
+        }
+        for (auto& t : producers) t.join();
+
+        CHECK(intact);
+        CHECK(received == total);
+        for (int p = 0; p < PRODUCERS; p++) CHECK(expected[p] == BLOCKS_PER_PRODUCER);
+        CHECK(queue.droppedBlocks() == refused.load());
+
+        BlockQueue::Block block;
+        CHECK(!queue.front(block));
+    }
+
+    void testOversizedBlock() {
+        BlockQueue queue(8, 16);
+        std::vector<uint8_t> big(8 * 16 + 1, 1);
+        CHECK(!queue.push(0, big.data(), big.size()));
+        CHECK(queue.droppedBlocks() == 1);
+
+        // Esattamente la capacità: accettato e ricomposto
+        big.resize(8 * 16);
+        for (size_t i = 0; i < big.size(); i++) big[i] = static_cast<uint8_t>(i);
+        CHECK(queue.push(3, big.data(), big.size()));
+        BlockQueue::Block block;
+        CHECK(queue.front(block));
+        CHECK(block.sensor == 3);
+        CHECK(block.size == big.size());
+        CHECK(std::memcmp(block.data, big.data(), big.size()) == 0);
+        queue.release();
+        CHECK(!queue.front(block));
+    }
+}
+
+int main() {
+    testContention();
+    testOversizedBlock();
+    return TestCheck::testResult("test_block_queue");
+}
@@ -0,0 +1,60 @@
+// ConfigCache: hash dei file, chiave dell'identità, salvataggio e rilettura delle
+// impronte, file assente o corrotto
+#include "ConfigCache.h"
+#include "TestCheck.h"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+
+namespace {
+    void testConfigCache() {
+        char pattern[] = "/tmp/test_config_cache_XXXXXX";
+        const char* dir = mkdtemp(pattern);
+        CHECK(dir != nullptr);
+        if (!dir) return;
+        std::string path = std::string(dir) + "/cache.json";
+
+        CHECK(ConfigCache::hash("") == 0);
+        CHECK(ConfigCache::hash("a") != 0);
+        CHECK(ConfigCache::hash("ab") != ConfigCache::hash("ba"));
+        CHECK(ConfigCache::identityKey(14, 7) == "board_14_fw_7");
+
+        ConfigCache missing(path);
+        CHECK(!missing.load());
+
+        ConfigCache::Entry entry;
+        entry.config = 0xFEDCBA9876543210ULL;
+        entry.ucf = 0;
+        entry.status = 0x1ULL;
+        ConfigCache cache(path);
+        cache.store("board_14_fw_7", entry);
+        CHECK(cache.save());
+
+        ConfigCache reloaded(path);
+        CHECK(reloaded.load());
+        ConfigCache::Entry found;
+        CHECK(reloaded.lookup("board_14_fw_7", found));
+        CHECK(found.config == entry.config);
+        CHECK(found.ucf == 0);
+        CHECK(found.status == entry.status);
+        CHECK(!reloaded.lookup("board_1_fw_1", found));
+
+        // File corrotto: nessuna voce
+        std::FILE* f = std::fopen(path.c_str(), "w");
+        if (f) {
+            std::fputs("{ not json", f);
+            std::fclose(f);
+        }
+        CHECK(!reloaded.load());
+        CHECK(!reloaded.lookup("board_14_fw_7", found));
+
+        std::remove(path.c_str());
+        rmdir(dir);
+    }
+}
+
+int main() {
+    testConfigCache();
+    return TestCheck::testResult("test_config_cache");
+}
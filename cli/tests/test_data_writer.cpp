@@ -0,0 +1,184 @@
+// DataWriter: il JSON scritto con to_chars per ciascuno dei sei layout dei pacchetti è identico
+// byte per byte a quello della formattazione originale con ostream (writeJsonSample), inclusi
+// i campioni con timestamp non valido (saltati), gli estremi int16 e float piccoli/grandi/negativi
+#include "DataWriter.h"
+#include "TestCheck.h"
+#include <string>
+#include <vector>
+#include <sstream>
+#include <fstream>
+#include <limits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+namespace {
+    const double NOT_A_TIME = std::numeric_limits<double>::quiet_NaN();
+
+    // Timestamp validi e non validi (saltati): negativo, NaN, oltre 4e9
+    const double TIMES[] = { 1792415619.123456, -1.0, 0.0, NOT_A_TIME, 1792415619.9999996, 5e9, 12.5 };
+    const float FLOATS[] = { 0.1f, -2.5e10f, 1e-7f, 1234567.0f, 23.456789f, -0.0f, 100.0f };
+    const int16_t INTS[] = { 32767, -32768, 0, -1, 1, 12345, -4096 };
+    const size_t N = sizeof(TIMES) / sizeof(TIMES[0]);
+
+    // Riferimento: writeJsonSample prima della specializzazione per layout (ostream, precisione 6)
+    void baselineSample(std::ostream& file, bool scalar, bool& isFirst, double timestamp,
+                        float x, float y, float z, bool isInt16, int16_t ix, int16_t iy, int16_t iz) {
+        if (!isFirst) file << ",\n";
+        else isFirst = false;
+
+        file.setf(std::ios::fixed, std::ios::floatfield);
+        file.precision(6);
+        file << "{ \"timestamp\": " << timestamp;
+        file.unsetf(std::ios::floatfield);
+        file.precision(6);
+        if (scalar) {
+            file << ", \"value\": " << (isInt16 ? static_cast<float>(ix) : x) << " }";
+        } else if (isInt16) {
+            file << ", \"x\": " << ix << ", \"y\": " << iy << ", \"z\": " << iz << " }";
+        } else {
+            file << ", \"x\": " << x << ", \"y\": " << y << ", \"z\": " << z << " }";
+        }
+    }
+
+    bool validTime(double ts) {
+        return !(std::isnan(ts) || ts < 0 || ts > 4e9);
+    }
+
+    template <typename T>
+    void put(std::vector<uint8_t>& block, size_t offset, T value) {
+        std::memcpy(block.data() + offset, &value, sizeof(T));
+    }
+
+    std::string readFile(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        std::ostringstream text;
+        text << in.rdbuf();
+        return text.str();
+    }
+
+    struct Case {
+        std::string sensor;
+        size_t sampleSize;
+        size_t count;
+        std::vector<uint8_t> block;
+        std::string expected;
+    };
+
+    // Un blocco per layout (dimensioni scelte perché DataWriter riconosca proprio quel layout)
+    std::vector<Case> buildCases() {
+        std::vector<Case> cases = {
+            { "a_temp", 16, N, {}, {} },       // ScalarFloatTsEnd: [4 byte][float][float64 ts]
+            { "b_press", 12, N, {}, {} },      // ScalarFloat: [float64 ts][float]
+            { "c_temp", 10, N, {}, {} },       // ScalarInt16: [float64 ts][int16]
+            { "d_acc", 14, N, {}, {} },        // TriaxInt16: [float64 ts][3 x int16]
+            { "e_gyro", 20, N - 1, {}, {} },   // TriaxFloat: [float64 ts][3 x float]
+        };
+        for (Case& c : cases) {
+            // 112, 84, 70, 98 e 120 byte: nessuna dimensione è ambigua con un layout controllato prima
+            c.block.assign(c.sampleSize * c.count, 0);
+            std::ostringstream expected;
+            expected << "[\n";
+            bool isFirst = true;
+            for (size_t i = 0; i < c.count; i++) {
+                size_t o = i * c.sampleSize;
+                float x = FLOATS[i], y = FLOATS[(i + 1) % N], z = FLOATS[(i + 2) % N];
+                int16_t ix = INTS[i], iy = INTS[(i + 1) % N], iz = INTS[(i + 2) % N];
+                switch (c.sampleSize) {
+                    case 16: put(c.block, o + 4, x); put(c.block, o + 8, TIMES[i]); break;
+                    case 12: put(c.block, o, TIMES[i]); put(c.block, o + 8, x); break;
+                    case 10: put(c.block, o, TIMES[i]); put(c.block, o + 8, ix); break;
+                    case 14: put(c.block, o, TIMES[i]); put(c.block, o + 8, ix); put(c.block, o + 10, iy); put(c.block, o + 12, iz); break;
+                    case 20: put(c.block, o, TIMES[i]); put(c.block, o + 8, x); put(c.block, o + 12, y); put(c.block, o + 16, z); break;
+                }
+                if (!validTime(TIMES[i])) continue;
+                bool scalar = c.sampleSize == 16 || c.sampleSize == 12 || c.sampleSize == 10;
+                bool isInt16 = c.sampleSize == 10 || c.sampleSize == 14;
+                baselineSample(expected, scalar, isFirst, TIMES[i], x, y, z, isInt16, ix, iy, iz);
+            }
+            expected << "\n]";
+            c.expected = expected.str();
+        }
+        return cases;
+    }
+
+    void testFixedLayouts(const std::string& dir) {
+        std::vector<Case> cases = buildCases();
+        {
+            DataWriter writer(dir);
+            std::vector<std::string> names;
+            for (const Case& c : cases) names.push_back(c.sensor);
+            writer.initSensorFiles(names);
+            for (const Case& c : cases) writer.writeData(c.sensor, c.block.data(), static_cast<int>(c.block.size()));
+            writer.closeAll();
+        }
+        for (const Case& c : cases) {
+            std::string path = dir + "/" + c.sensor + ".json";
+            std::string actual = readFile(path);
+            if (actual != c.expected) {
+                std::fprintf(stderr, "%s:\n--- expected\n%s\n--- actual\n%s\n", c.sensor.c_str(),
+                             c.expected.c_str(), actual.c_str());
+            }
+            CHECK(actual == c.expected);
+            std::remove(path.c_str());
+            std::remove((path + ".idx").c_str());
+        }
+    }
+
+    void testPackedLayout(const std::string& dir) {
+        // Formato B: [uint32 header][terne int16], timestamp interpolati dal tempo host di arrivo
+        std::vector<uint8_t> block(4 + 6 * N * 2, 0);
+        put<uint32_t>(block, 0, 0x1234);
+        for (size_t i = 0; i < 2 * N; i++) {
+            put(block, 4 + 6 * i, INTS[i % N]);
+            put(block, 6 + 6 * i, INTS[(i + 3) % N]);
+            put(block, 8 + 6 * i, INTS[(i + 5) % N]);
+        }
+        {
+            DataWriter writer(dir);
+            writer.initSensorFiles({ "f_mag" });
+            writer.writeData("f_mag", block.data(), static_cast<int>(block.size()));
+            writer.writeData("f_mag", block.data(), static_cast<int>(block.size()));
+            writer.closeAll();
+        }
+        std::string path = dir + "/f_mag.json";
+        std::string actual = readFile(path);
+
+        // I timestamp dipendono dall'orologio: si rileggono dal file e si riformattano con ostream
+        std::ostringstream expected;
+        expected << "[\n";
+        bool isFirst = true;
+        size_t pos = 0;
+        double lastTs = 0.0;
+        for (size_t i = 0; i < 4 * N; i++) {
+            size_t at = actual.find("\"timestamp\": ", pos);
+            CHECK(at != std::string::npos);
+            if (at == std::string::npos) break;
+            pos = at + 13;
+            double ts = std::strtod(actual.c_str() + pos, nullptr);
+            CHECK(ts >= lastTs);
+            lastTs = ts;
+            size_t k = i % (2 * N);
+            baselineSample(expected, false, isFirst, ts, 0, 0, 0, true, INTS[k % N], INTS[(k + 3) % N], INTS[(k + 5) % N]);
+        }
+        expected << "\n]";
+        CHECK(actual == expected.str());
+        std::remove(path.c_str());
+        std::remove((path + ".idx").c_str());
+    }
+}
+
+int main() {
+    char pattern[] = "/tmp/test_data_writer_XXXXXX";
+    const char* dir = mkdtemp(pattern);
+    if (!dir) {
+        std::perror("mkdtemp");
+        return 1;
+    }
+    testFixedLayouts(dir);
+    testPackedLayout(dir);
+    rmdir(dir);
+    return TestCheck::testResult("test_data_writer");
+}
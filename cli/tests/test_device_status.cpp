@@ -0,0 +1,106 @@
+// DeviceStatus: i campi estratti in un passaggio SAX coincidono con quelli letti dal
+// DOM di nlohmann::json; l'impronta ignora i campi volatili e cambia con la configurazione
+#include "DeviceStatus.h"
+#include "ConfigCache.h"
+#include "TestCheck.h"
+#include "json.hpp"
+#include <string>
+
+namespace {
+    const char* STATUS = R"({
+      "devices": [ { "board_id": 14, "fw_id": 7, "components": [
+        { "firmware_info": { "alias": "bench \"A\"", "fw_name": "FP-SNS-DATALOG2", "c_type": 5 } },
+        { "lsm6dsv16x_acc": { "enable": true, "odr": 960.0, "measodr": 957.31, "fs": 16, "sensitivity": 0.000488,
+                              "aop": 1, "dim": 3, "samples_per_ts": 1000, "usb_dps": 1536, "data_type": "int16",
+                              "initial_offset": 0.013, "c_type": 0, "stream_id": 1 } },
+        { "lsm6dsv16x_mlc": { "enable": false, "odr": 30, "dim": 8, "samples_per_ts": 1, "ucf_status": false,
+                              "data_type": "int8" } },
+        { "stts22h_temp": { "enable": true, "odr": 200, "fs": 100, "sensitivity": 1.0, "usb_dps": 200, "dim": 1 } },
+        { "log_controller": { "log_status": false, "sd_mounted": false, "controller_type": 0 } },
+        { "tags_info": { "max_tags_num": 16, "sw_tag0": { "label": "SW_TAG_0", "enabled": true, "status": false } } },
+        { "acquisition_info": { "name": "run_1", "description": "", "start_time": "2026-01-01T00:00:00" } }
+      ] } ]
+    })";
+
+    std::string replaceAll(std::string text, const std::string& from, const std::string& to) {
+        size_t pos = 0;
+        while ((pos = text.find(from, pos)) != std::string::npos) {
+            text.replace(pos, from.size(), to);
+            pos += to.size();
+        }
+        return text;
+    }
+
+    void testExtractorMatchesDom() {
+        DeviceStatus status;
+        CHECK(status.parse(STATUS));
+        nlohmann::json dom = nlohmann::json::parse(STATUS);
+
+        size_t componentCount = 0;
+        for (const auto& entry : dom["devices"][0]["components"]) {
+            for (auto it = entry.begin(); it != entry.end(); ++it) {
+                componentCount++;
+                const DeviceStatus::Component* comp = status.find(it.key());
+                CHECK(comp != nullptr);
+                if (!comp) continue;
+                // Ogni scalare di FIELDS nel DOM è estratto con lo stesso valore, e nient'altro
+                size_t expectedFields = 0;
+                for (const char* const* f = DeviceStatus::FIELDS; *f; f++) {
+                    auto field = it->find(*f);
+                    if (field == it->end() || field->is_structured()) continue;
+                    expectedFields++;
+                    const DeviceStatus::Value* value = comp->find(*f);
+                    CHECK(value != nullptr);
+                    if (value) CHECK(value->dump() == field->dump());
+                }
+                CHECK(comp->fields.size() == expectedFields);
+            }
+        }
+        CHECK(status.components().size() == componentCount);
+        CHECK(status.components().front().name == "firmware_info");
+        CHECK(status.alias() == "bench \"A\"");
+
+        const DeviceStatus::Component* acc = status.find("lsm6dsv16x_acc");
+        CHECK(acc && acc->number("sensitivity", 0.0) == 0.000488);
+        CHECK(acc && acc->text("data_type") == "int16");
+        CHECK(acc && !acc->has("stream_id"));
+
+        // Risposta di un singolo componente: oggetto componente alla radice
+        DeviceStatus single;
+        CHECK(single.parse(R"({ "lsm6dsv16x_gyro": { "enable": true, "odr": 120, "fs": 2000 } })"));
+        CHECK(single.find("lsm6dsv16x_gyro") && single.find("lsm6dsv16x_gyro")->number("fs", 0.0) == 2000.0);
+
+        DeviceStatus invalid;
+        CHECK(!invalid.parse("{ \"devices\": [ "));
+        CHECK(invalid.empty());
+        CHECK(invalid.digest() == 0);
+    }
+
+    void testDigest() {
+        DeviceStatus base, drifted, reconfigured, retagged;
+        CHECK(base.parse(STATUS));
+        CHECK(base.digest() != 0);
+
+        // Solo campi volatili diversi: stessa impronta
+        std::string text = replaceAll(STATUS, "957.31", "951.0");
+        text = replaceAll(text, "\"log_status\": false", "\"log_status\": true");
+        text = replaceAll(text, "run_1", "run_2");
+        text = replaceAll(text, "\"initial_offset\": 0.013", "\"initial_offset\": 1.5");
+        CHECK(drifted.parse(text));
+        CHECK(drifted.digest() == base.digest());
+
+        // Proprietà configurabile fuori da FIELDS: impronta diversa
+        CHECK(reconfigured.parse(replaceAll(STATUS, "\"stream_id\": 1", "\"stream_id\": 2")));
+        CHECK(reconfigured.digest() != base.digest());
+        CHECK(retagged.parse(replaceAll(STATUS, "SW_TAG_0", "walk")));
+        CHECK(retagged.digest() != base.digest());
+
+        CHECK(ConfigCache::statusDigest(base) == base.digest());
+    }
+}
+
+int main() {
+    testExtractorMatchesDom();
+    testDigest();
+    return TestCheck::testResult("test_device_status");
+}
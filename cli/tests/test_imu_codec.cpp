@@ -0,0 +1,97 @@
+// Codec delta + zigzag + varint: decodifica identica ai campioni originali, anche
+// con salti da un estremo all'altro dell'int16, e risincronizzazione sul magic
+#include "ImuCodec.h"
+#include "TestCheck.h"
+#include <vector>
+#include <random>
+#include <limits>
+
+namespace {
+    std::vector<int16_t> makeSamples(uint32_t nSamples, uint32_t channels, std::mt19937& rng) {
+        std::uniform_int_distribution<int> noise(-40, 40);
+        std::uniform_int_distribution<int> full(std::numeric_limits<int16_t>::min(), std::numeric_limits<int16_t>::max());
+        std::vector<int16_t> samples(nSamples * channels);
+        for (uint32_t i = 0; i < nSamples; i++) {
+            for (uint32_t c = 0; c < channels; c++) {
+                int prev = (i > 0) ? samples[(i - 1) * channels + c] : 0;
+                int v = (i % 17 == 5) ? full(rng) : prev + noise(rng);
+                v = std::max<int>(std::numeric_limits<int16_t>::min(), std::min<int>(std::numeric_limits<int16_t>::max(), v));
+                samples[i * channels + c] = static_cast<int16_t>(v);
+            }
+        }
+        // Salti estremi: delta di +-65535 modulo 2^16
+        if (nSamples >= 3) {
+            samples[channels * 1] = std::numeric_limits<int16_t>::min();
+            samples[channels * 2] = std::numeric_limits<int16_t>::max();
+        }
+        return samples;
+    }
+
+    void testRoundTrip() {
+        std::mt19937 rng(1234);
+        std::vector<uint8_t> stream;
+        std::vector<uint16_t> scratch;
+        std::vector<std::vector<int16_t>> blocks;
+        const uint32_t sizes[] = { 1, 3, 96, 512, 7 };
+
+        double t = 1000.0;
+        for (uint32_t n : sizes) {
+            blocks.push_back(makeSamples(n, 3, rng));
+            ImuCodec::encodeFrame(blocks.back().data(), n, 3, 0xABCD0000u + n, t, t + 0.1, stream, scratch);
+            t += 0.1;
+        }
+
+        size_t pos = 0;
+        std::vector<int16_t> decoded;
+        ImuCodec::FrameInfo info;
+        t = 1000.0;
+        for (size_t b = 0; b < blocks.size(); b++) {
+            size_t used = ImuCodec::decodeFrame(stream.data() + pos, stream.size() - pos, info, decoded);
+            CHECK(used > 0);
+            if (used == 0) return;
+            pos += used;
+            CHECK(info.channels == 3);
+            CHECK(info.nSamples == sizes[b]);
+            CHECK(info.deviceHeader == 0xABCD0000u + sizes[b]);
+            CHECK(info.tStart == t);
+            CHECK(info.tEnd == t + 0.1);
+            CHECK(decoded.size() >= blocks[b].size());
+            CHECK(std::equal(blocks[b].begin(), blocks[b].end(), decoded.begin()));
+            t += 0.1;
+        }
+        CHECK(pos == stream.size());
+    }
+
+    void testCorruptionAndResync() {
+        std::mt19937 rng(99);
+        std::vector<uint8_t> stream;
+        std::vector<uint16_t> scratch;
+        std::vector<int16_t> first = makeSamples(64, 3, rng), second = makeSamples(64, 3, rng);
+        ImuCodec::encodeFrame(first.data(), 64, 3, 1, 0.0, 1.0, stream, scratch);
+        size_t secondStart = stream.size();
+        ImuCodec::encodeFrame(second.data(), 64, 3, 2, 1.0, 2.0, stream, scratch);
+
+        // Un byte alterato nel payload del primo frame: checksum non valido
+        stream[ImuCodec::FRAME_HEADER_SIZE + 10] ^= 0x5A;
+        ImuCodec::FrameInfo info;
+        std::vector<int16_t> decoded;
+        CHECK(ImuCodec::decodeFrame(stream.data(), stream.size(), info, decoded) == 0);
+
+        // Il frame successivo viene ritrovato e decodificato intatto
+        size_t next = ImuCodec::findNextFrame(stream.data(), stream.size(), 1);
+        CHECK(next == secondStart);
+        size_t used = ImuCodec::decodeFrame(stream.data() + next, stream.size() - next, info, decoded);
+        CHECK(used == stream.size() - secondStart);
+        CHECK(info.deviceHeader == 2);
+        CHECK(std::equal(second.begin(), second.end(), decoded.begin()));
+
+        // Frame troncato: non valido
+        CHECK(ImuCodec::decodeFrame(stream.data() + secondStart, used - 1, info, decoded) == 0);
+    }
+}
+
+int main() {
+    testRoundTrip();
+    testCorruptionAndResync();
+    return TestCheck::testResult("test_imu_codec");
+}
@@ -0,0 +1,96 @@
+// RingQueue (FIFO attraverso crescita e giro del buffer) e BlockPool (blocchi
+// distinti, riuso dopo release, nessun nuovo slab a regime)
+#include "MemoryPool.h"
+#include "TestCheck.h"
+#include <set>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+
+namespace {
+    void testRingQueue() {
+        RingQueue<int> queue;
+        CHECK(queue.empty());
+
+        // Push e pop alternati: la testa gira più volte prima della crescita
+        int next = 0, expected = 0;
+        for (int round = 0; round < 100; round++) {
+            for (int i = 0; i < 10; i++) queue.push_back(next++);
+            for (int i = 0; i < 7; i++) {
+                CHECK(queue.front() == expected);
+                queue.pop_front();
+                expected++;
+            }
+        }
+        CHECK(queue.size() == static_cast<size_t>(next - expected));
+        for (size_t i = 0; i < queue.size(); i++) CHECK(queue.at(i) == expected + static_cast<int>(i));
+        while (!queue.empty()) {
+            CHECK(queue.front() == expected++);
+            queue.pop_front();
+        }
+        CHECK(expected == next);
+
+        queue.push_back(1);
+        queue.push_back(2);
+        queue.clear();
+        CHECK(queue.empty());
+        CHECK(queue.size() == 0);
+    }
+
+    void testBlockPool() {
+        Arena arena(4096);
+        BlockPool pool(arena, 48, 8);
+        CHECK(pool.blockSize() >= 48);
+
+        std::vector<void*> blocks;
+        std::set<void*> distinct;
+        for (int i = 0; i < 20; i++) {
+            void* b = pool.acquire();
+            CHECK(b != nullptr);
+            CHECK(reinterpret_cast<uintptr_t>(b) % alignof(void*) == 0);
+            std::memset(b, i, 48);
+            blocks.push_back(b);
+            distinct.insert(b);
+        }
+        CHECK(distinct.size() == blocks.size());
+        // Nessuna sovrapposizione: ogni blocco conserva il proprio contenuto
+        for (int i = 0; i < 20; i++) {
+            const uint8_t* p = static_cast<const uint8_t*>(blocks[i]);
+            CHECK(p[0] == i && p[47] == i);
+        }
+
+        // A regime: acquire/release riusano i blocchi senza nuovi slab dall'arena
+        for (void* b : blocks) pool.release(b);
+        size_t reserved = arena.bytesReserved();
+        for (int round = 0; round < 100; round++) {
+            std::vector<void*> again;
+            for (int i = 0; i < 20; i++) {
+                void* b = pool.acquire();
+                CHECK(distinct.count(b) == 1);
+                again.push_back(b);
+            }
+            for (void* b : again) pool.release(b);
+        }
+        CHECK(arena.bytesReserved() == reserved);
+    }
+
+    void testArenaAlignment() {
+        Arena arena(256);
+        for (size_t align : { 1, 8, 16, 64 }) {
+            void* p = arena.allocate(3, align);
+            CHECK(reinterpret_cast<uintptr_t>(p) % align == 0);
+        }
+        // Richiesta più grande di un chunk
+        void* big = arena.allocate(1000, 64);
+        CHECK(big != nullptr);
+        CHECK(reinterpret_cast<uintptr_t>(big) % 64 == 0);
+        std::memset(big, 0, 1000);
+    }
+}
+
+int main() {
+    testRingQueue();
+    testBlockPool();
+    testArenaAlignment();
+    return TestCheck::testResult("test_memory_pool");
+}
@@ -0,0 +1,163 @@
+// MlcDecoder: un gruppo (campioni + timestamp) spezzato tra due process() viene ricomposto con
+// il timestamp del dispositivo, lo stesso flusso dà gli stessi eventi con qualunque suddivisione
+// in blocchi; senza timestamp (samples_per_ts = 0) vale il tempo host; escape delle etichette
+#include "MlcDecoder.h"
+#include "DeviceStatus.h"
+#include "TestCheck.h"
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <unistd.h>
+
+namespace {
+    std::string statusJson(int dim, int samplesPerTs) {
+        return "{ \"devices\": [ { \"components\": [ { \"ism330dhcx_mlc\": { \"dim\": " + std::to_string(dim) +
+               ", \"samples_per_ts\": " + std::to_string(samplesPerTs) + " } } ] } ] }";
+    }
+
+    void configure(MlcDecoder& decoder, int dim, int samplesPerTs) {
+        DeviceStatus status;
+        CHECK(status.parse(statusJson(dim, samplesPerTs)));
+        decoder.configure("ism330dhcx_mlc", status);
+        CHECK(decoder.outputCount() == static_cast<size_t>(dim));
+    }
+
+    // Gruppo: samplesPerTs campioni da dim registri, poi il timestamp double del dispositivo
+    void appendGroup(std::vector<uint8_t>& stream, const std::vector<std::vector<uint8_t>>& samples, double ts) {
+        for (const auto& sample : samples) stream.insert(stream.end(), sample.begin(), sample.end());
+        uint8_t raw[sizeof(double)];
+        std::memcpy(raw, &ts, sizeof(ts));
+        stream.insert(stream.end(), raw, raw + sizeof(raw));
+    }
+
+    struct Seen {
+        double timestamp;
+        int tree, value, previous;
+        bool initial;
+    };
+
+    void collect(const std::vector<MlcDecoder::Event>& events, std::vector<Seen>& out) {
+        for (const auto& e : events) out.push_back({ e.timestamp, e.tree, e.value, e.previous, e.initial });
+    }
+
+    std::vector<uint8_t> groupedStream() {
+        // 2 alberi, 2 campioni per timestamp: gruppi da 2 * 2 + 8 = 12 byte
+        std::vector<uint8_t> stream;
+        appendGroup(stream, { { 0, 4 }, { 0, 4 } }, 10.0);
+        appendGroup(stream, { { 1, 4 }, { 1, 8 } }, 10.5);
+        appendGroup(stream, { { 2, 8 }, { 0, 8 } }, 11.0);
+        return stream;
+    }
+
+    void checkGroupedEvents(const std::vector<Seen>& seen) {
+        CHECK(seen.size() == 6);
+        if (seen.size() != 6) return;
+        // Stato iniziale dal primo campione
+        CHECK(seen[0].initial && seen[0].tree == 0 && seen[0].value == 0 && seen[0].timestamp == 10.0);
+        CHECK(seen[1].initial && seen[1].tree == 1 && seen[1].value == 4);
+        // Cambi di classe con il timestamp del proprio gruppo
+        CHECK(!seen[2].initial && seen[2].tree == 0 && seen[2].value == 1 && seen[2].previous == 0 && seen[2].timestamp == 10.5);
+        CHECK(seen[3].tree == 1 && seen[3].value == 8 && seen[3].previous == 4 && seen[3].timestamp == 10.5);
+        CHECK(seen[4].tree == 0 && seen[4].value == 2 && seen[4].previous == 1 && seen[4].timestamp == 11.0);
+        CHECK(seen[5].tree == 0 && seen[5].value == 0 && seen[5].previous == 2 && seen[5].timestamp == 11.0);
+    }
+
+    void testSplitGroup() {
+        std::vector<uint8_t> stream = groupedStream();
+        MlcDecoder decoder;
+        configure(decoder, 2, 2);
+
+        // Primo blocco: un gruppo e 7 byte del secondo (campioni e metà timestamp)
+        std::vector<Seen> seen;
+        collect(decoder.process(stream.data(), 12 + 7, 99.0), seen);
+        CHECK(seen.size() == 2);
+        // Secondo blocco: resto del secondo gruppo e il terzo intero
+        collect(decoder.process(stream.data() + 19, static_cast<int>(stream.size()) - 19, 99.0), seen);
+        checkGroupedEvents(seen);
+
+        // Stessi eventi con qualunque suddivisione, anche un byte per blocco
+        for (size_t chunk : { 1, 5, 11, 13, 36 }) {
+            MlcDecoder split;
+            configure(split, 2, 2);
+            std::vector<Seen> out;
+            for (size_t pos = 0; pos < stream.size(); pos += chunk) {
+                size_t len = std::min(chunk, stream.size() - pos);
+                collect(split.process(stream.data() + pos, static_cast<int>(len), 99.0), out);
+            }
+            checkGroupedEvents(out);
+        }
+
+        // Una nuova configurazione scarta il gruppo incompleto
+        MlcDecoder reset;
+        configure(reset, 2, 2);
+        reset.process(stream.data(), 5, 0.0);
+        configure(reset, 2, 2);
+        std::vector<Seen> out;
+        collect(reset.process(stream.data(), static_cast<int>(stream.size()), 0.0), out);
+        checkGroupedEvents(out);
+    }
+
+    void testWithoutTimestamp() {
+        // samples_per_ts = 0: solo registri (3 byte per campione), timestamp host del blocco
+        MlcDecoder decoder;
+        configure(decoder, 3, 0);
+        const uint8_t stream[] = { 1, 2, 3,  1, 2, 3,  1, 5, 3,  0, 5, 3 };
+        std::vector<Seen> seen;
+        collect(decoder.process(stream, 4, 100.0), seen);   // Un campione e un byte del successivo
+        CHECK(seen.size() == 3);
+        for (const Seen& s : seen) CHECK(s.initial && s.timestamp == 100.0);
+        collect(decoder.process(stream + 4, 4, 101.0), seen);   // Chiude il secondo, inizia il terzo
+        CHECK(seen.size() == 3);
+        collect(decoder.process(stream + 8, 4, 102.0), seen);
+        CHECK(seen.size() == 5);
+        if (seen.size() == 5) {
+            CHECK(seen[3].tree == 1 && seen[3].value == 5 && seen[3].previous == 2 && seen[3].timestamp == 102.0);
+            CHECK(seen[4].tree == 0 && seen[4].value == 0 && seen[4].previous == 1 && seen[4].timestamp == 102.0);
+        }
+    }
+
+    void testFormatEvent(const std::string& dir) {
+        std::string path = dir + "/labels.json";
+        {
+            std::ofstream out(path);
+            out << R"({ "0": { "0": "still", "1": "say \"hi\"\\now\n\ttab" }, "1": { "4": "walk" } })";
+        }
+        MlcDecoder decoder;
+        configure(decoder, 2, 2);
+        CHECK(decoder.loadLabels(path));
+        CHECK(!decoder.loadLabels(dir + "/missing.json"));
+
+        std::vector<uint8_t> stream = groupedStream();
+        std::vector<std::string> lines;
+        for (const auto& event : decoder.process(stream.data(), static_cast<int>(stream.size()), 0.0)) {
+            lines.push_back(decoder.formatEvent(event));
+        }
+        CHECK(lines.size() == 6);
+        if (lines.size() == 6) {
+            CHECK(lines[0] == R"({ "timestamp": 10.000000, "tree": 0, "value": 0, "label": "still" })");
+            CHECK(lines[1] == R"({ "timestamp": 10.000000, "tree": 1, "value": 4, "label": "walk" })");
+            // Virgolette e backslash con escape, caratteri di controllo rimossi
+            CHECK(lines[2] == R"({ "timestamp": 10.500000, "tree": 0, "value": 1, "previous": 0, "label": "say \"hi\"\\nowtab" })");
+            CHECK(lines[3] == R"({ "timestamp": 10.500000, "tree": 1, "value": 8, "previous": 4 })");
+        }
+        std::remove(path.c_str());
+    }
+}
+
+int main() {
+    testSplitGroup();
+    testWithoutTimestamp();
+
+    char pattern[] = "/tmp/test_mlc_decoder_XXXXXX";
+    const char* dir = mkdtemp(pattern);
+    if (!dir) {
+        std::perror("mkdtemp");
+        return 1;
+    }
+    testFormatEvent(dir);
+    rmdir(dir);
+    return TestCheck::testResult("test_mlc_decoder");
+}
@@ -0,0 +1,286 @@
+// MQTT: codifica di CONNECT e PUBLISH (Remaining Length a 1, 2 e 3 byte, QoS 1 con packet id
+// e DUP) letta da un broker finto su loopback; messaggi QoS 1 senza PUBACK alla caduta della
+// connessione restituiti con DUP e spostati nello spool; record dello spool andata e ritorno
+#include "MqttClient.h"
+#include "MqttSink.h"
+#include "TestCheck.h"
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+namespace {
+    struct Packet {
+        uint8_t header;
+        std::vector<uint8_t> remainingLength;   // Byte della codifica a lunghezza variabile
+        std::vector<uint8_t> body;
+    };
+
+    /**
+     * Broker finto a connessione singola: risponde al CONNECT, raccoglie i PUBLISH e
+     * conferma i QoS 1 (se ack), poi chiude dopo closeAfter PUBLISH.
+     */
+    class FakeBroker {
+    public:
+        FakeBroker(size_t closeAfter, bool ack) : closeAfter(closeAfter), ack(ack), done(false) {
+            listenFd = socket(AF_INET, SOCK_STREAM, 0);
+            sockaddr_in addr;
+            std::memset(&addr, 0, sizeof(addr));
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+            listen(listenFd, 1);
+            socklen_t len = sizeof(addr);
+            getsockname(listenFd, reinterpret_cast<sockaddr*>(&addr), &len);
+            port = ntohs(addr.sin_port);
+            worker = std::thread(&FakeBroker::run, this);
+        }
+
+        ~FakeBroker() {
+            worker.join();
+            ::close(listenFd);
+        }
+
+        int port;
+        std::vector<Packet> packets;   // Leggibili dopo finished()
+        bool finished() const { return done.load(); }
+
+    private:
+        int listenFd;
+        size_t closeAfter;
+        bool ack;
+        std::atomic<bool> done;
+        std::thread worker;
+
+        bool readExact(int fd, uint8_t* out, size_t len) {
+            while (len > 0) {
+                ssize_t n = recv(fd, out, len, 0);
+                if (n <= 0) return false;
+                out += n;
+                len -= static_cast<size_t>(n);
+            }
+            return true;
+        }
+
+        void run() {
+            int fd = accept(listenFd, nullptr, nullptr);
+            size_t publishes = 0;
+            while (fd >= 0 && publishes < closeAfter) {
+                Packet p;
+                if (!readExact(fd, &p.header, 1)) break;
+                size_t remaining = 0, shift = 0;
+                uint8_t byte = 0;
+                do {
+                    if (!readExact(fd, &byte, 1)) break;
+                    p.remainingLength.push_back(byte);
+                    remaining |= static_cast<size_t>(byte & 0x7F) << shift;
+                    shift += 7;
+                } while (byte & 0x80);
+                p.body.resize(remaining);
+                if (remaining > 0 && !readExact(fd, p.body.data(), remaining)) break;
+                packets.push_back(p);
+
+                uint8_t type = p.header & 0xF0;
+                if (type == 0x10) {
+                    const uint8_t connack[] = { 0x20, 0x02, 0x00, 0x00 };
+                    send(fd, connack, sizeof(connack), MSG_NOSIGNAL);
+                } else if (type == 0x30) {
+                    publishes++;
+                    size_t topicLen = (static_cast<size_t>(p.body[0]) << 8) | p.body[1];
+                    if (ack && (p.header & 0x06) && publishes < closeAfter) {
+                        const uint8_t puback[] = { 0x40, 0x02, p.body[2 + topicLen], p.body[3 + topicLen] };
+                        send(fd, puback, sizeof(puback), MSG_NOSIGNAL);
+                    }
+                }
+            }
+            if (fd >= 0) ::close(fd);
+            done.store(true);
+        }
+    };
+
+    void serviceUntil(MqttClient& client, const FakeBroker& broker) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (!broker.finished() && std::chrono::steady_clock::now() < deadline) {
+            client.service();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        // Chiusura dal broker rilevata dal client
+        for (int i = 0; i < 50 && client.isConnected(); i++) {
+            client.service();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    std::vector<uint8_t> payloadOf(size_t size) {
+        std::vector<uint8_t> payload(size);
+        for (size_t i = 0; i < size; i++) payload[i] = static_cast<uint8_t>(i * 13);
+        return payload;
+    }
+
+    void testEncoding() {
+        // Remaining Length = 2 + 5 (topic) + payload: 107 (1 byte), 207 (2 byte), 20007 (3 byte)
+        const size_t sizes[] = { 100, 200, 20000 };
+        const std::vector<uint8_t> expectedLength[] = { { 107 }, { 0xCF, 0x01 }, { 0xA7, 0x9C, 0x01 } };
+
+        FakeBroker broker(3, true);
+        MqttClient client;
+        CHECK(client.connect("127.0.0.1", broker.port, "fastgotest", 30));
+        for (size_t size : sizes) {
+            std::vector<uint8_t> payload = payloadOf(size);
+            CHECK(client.publish("a/acc", payload.data(), payload.size(), 0));
+        }
+        serviceUntil(client, broker);
+
+        CHECK(broker.packets.size() == 4);
+        if (broker.packets.size() != 4) return;
+
+        // CONNECT: "MQTT", livello 4, clean session, keep-alive 30, client id
+        const Packet& connect = broker.packets[0];
+        const uint8_t expectedConnect[] = { 0x00, 0x04, 'M', 'Q', 'T', 'T', 0x04, 0x02, 0x00, 30,
+                                            0x00, 10, 'f', 'a', 's', 't', 'g', 'o', 't', 'e', 's', 't' };
+        CHECK(connect.header == 0x10);
+        CHECK(connect.remainingLength == std::vector<uint8_t>({ sizeof(expectedConnect) }));
+        CHECK(connect.body == std::vector<uint8_t>(expectedConnect, expectedConnect + sizeof(expectedConnect)));
+
+        for (size_t i = 0; i < 3; i++) {
+            const Packet& publish = broker.packets[i + 1];
+            CHECK(publish.header == 0x30);
+            CHECK(publish.remainingLength == expectedLength[i]);
+            std::vector<uint8_t> body = { 0x00, 0x05, 'a', '/', 'a', 'c', 'c' };
+            std::vector<uint8_t> payload = payloadOf(sizes[i]);
+            body.insert(body.end(), payload.begin(), payload.end());
+            CHECK(publish.body == body);
+        }
+    }
+
+    void testQos1Dup() {
+        // Il broker conferma il primo QoS 1 e chiude dopo il secondo senza PUBACK
+        std::vector<uint8_t> payload = payloadOf(32);
+        std::vector<std::string> topics;
+        std::vector<bool> dups;
+        {
+            FakeBroker broker(2, true);
+            MqttClient client;
+            CHECK(client.connect("127.0.0.1", broker.port, "fastgotest", 30));
+            CHECK(client.publish("a/first", payload.data(), payload.size(), 1));
+            CHECK(client.publish("a/second", payload.data(), payload.size(), 1));
+            serviceUntil(client, broker);
+            CHECK(!client.isConnected());
+            CHECK(client.hasUndelivered());
+
+            if (broker.packets.size() == 3) {
+                const Packet& second = broker.packets[2];
+                CHECK(second.header == 0x32);   // QoS 1, senza DUP
+                CHECK(second.body.size() == 2 + 8 + 2 + payload.size());
+                CHECK(second.body[10] == 0x00 && second.body[11] == 0x02);   // Packet id 2
+            } else {
+                CHECK(broker.packets.size() == 3);
+            }
+
+            client.takeUndelivered([&](const std::string& topic, const uint8_t* data, size_t len, int qos, bool dup) {
+                topics.push_back(topic);
+                dups.push_back(dup);
+                CHECK(qos == 1);
+                CHECK(len == payload.size() && std::memcmp(data, payload.data(), len) == 0);
+            });
+            CHECK(!client.hasUndelivered());
+        }
+        CHECK(topics.size() == 1 && topics[0] == "a/second");
+        CHECK(dups.size() == 1 && dups[0]);
+
+        // Nuova consegna con DUP: flag 0x08 nell'header fisso
+        FakeBroker broker(1, false);
+        MqttClient client;
+        CHECK(client.connect("127.0.0.1", broker.port, "fastgotest", 30));
+        CHECK(client.publish("a/second", payload.data(), payload.size(), 1, true));
+        serviceUntil(client, broker);
+        CHECK(broker.packets.size() == 2 && broker.packets[1].header == 0x3A);
+    }
+
+    void testSpoolRecords(const std::string& dir) {
+        std::string path = dir + "/spool.bin";
+        FILE* f = std::fopen(path.c_str(), "wb+");
+        CHECK(f != nullptr);
+        if (!f) return;
+        std::vector<uint8_t> payload = payloadOf(300);
+        MqttSink::writeSpoolRecord(f, "fastgo/sensortile/lsm6dsv16x_acc", payload.data(), payload.size(), false);
+        MqttSink::writeSpoolRecord(f, "fastgo/sensortile/lis2mdl_mag", payload.data(), 10, true);
+        MqttSink::writeSpoolRecord(f, "empty", nullptr, 0, true);
+        long end = std::ftell(f);
+
+        std::fseek(f, 0, SEEK_SET);
+        std::string topic;
+        std::vector<uint8_t> out;
+        bool dup = true;
+        CHECK(MqttSink::readSpoolRecord(f, topic, out, dup));
+        CHECK(topic == "fastgo/sensortile/lsm6dsv16x_acc" && !dup && out == payload);
+        CHECK(MqttSink::readSpoolRecord(f, topic, out, dup));
+        CHECK(topic == "fastgo/sensortile/lis2mdl_mag" && dup);
+        CHECK(out == std::vector<uint8_t>(payload.begin(), payload.begin() + 10));
+        CHECK(MqttSink::readSpoolRecord(f, topic, out, dup));
+        CHECK(topic == "empty" && dup && out.empty());
+        CHECK(std::ftell(f) == end);
+        CHECK(!MqttSink::readSpoolRecord(f, topic, out, dup));
+        std::fclose(f);
+        std::remove(path.c_str());
+    }
+
+    void testSinkRescue(const std::string& dir) {
+        // QoS 1 senza PUBACK quando il broker chiude: il batch finisce nello spool con DUP
+        std::string spoolPath = dir + "/mqtt_spool.bin";
+        {
+            FakeBroker broker(1, false);
+            MqttSink sink("127.0.0.1", broker.port, "fg", 1, spoolPath);
+            CHECK(sink.start());
+            CHECK(sink.getClientId().size() <= 23);
+            uint8_t block[16] = { 1, 2, 3 };
+            sink.onEvent("tag", block, sizeof(block), 1.5);
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+            while (!broker.finished() && std::chrono::steady_clock::now() < deadline) {
+                sink.poll();
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            for (int i = 0; i < 50; i++) {
+                sink.poll();
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+
+            FILE* f = std::fopen(spoolPath.c_str(), "rb");
+            CHECK(f != nullptr);
+            if (f) {
+                std::string topic;
+                std::vector<uint8_t> out;
+                bool dup = false;
+                CHECK(MqttSink::readSpoolRecord(f, topic, out, dup));
+                CHECK(topic == "fg/tag" && dup);
+                CHECK(out.size() == 8 + 4 + sizeof(block));   // [float64 ts][uint32 size][blocco]
+                std::fclose(f);
+            }
+        }
+        std::remove(spoolPath.c_str());
+    }
+}
+
+int main() {
+    testEncoding();
+    testQos1Dup();
+
+    char pattern[] = "/tmp/test_mqtt_XXXXXX";
+    const char* dir = mkdtemp(pattern);
+    if (!dir) {
+        std::perror("mkdtemp");
+        return 1;
+    }
+    testSpoolRecords(dir);
+    testSinkRescue(dir);
+    rmdir(dir);
+    return TestCheck::testResult("test_mqtt");
+}
@@ -0,0 +1,88 @@
+// OrientationFilter: da fermo converge a roll/pitch noti dalla sola gravità, una rotazione a
+// velocità costante sull'asse z integra lo yaw atteso; la pipeline rifiuta l'assetto senza
+// la sensibilità del giroscopio (integrerebbe conteggi grezzi come deg/s)
+#include "OrientationFilter.h"
+#include "SensorPipeline.h"
+#include "UnitConverter.h"
+#include "DeviceStatus.h"
+#include "TestCheck.h"
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+
+namespace {
+    const float DEG_TO_RAD = 0.017453292519943295f;
+
+    void testStaticPose() {
+        const float poses[][2] = { { 0.0f, 0.0f }, { 30.0f, 0.0f }, { 0.0f, -20.0f }, { -45.0f, 15.0f } };
+        for (const auto& pose : poses) {
+            float roll = pose[0] * DEG_TO_RAD, pitch = pose[1] * DEG_TO_RAD;
+            // Gravità nel riferimento del sensore (ZYX): conteggi arbitrari, il filtro normalizza
+            float ax = -std::sin(pitch) * 16384.0f;
+            float ay = std::sin(roll) * std::cos(pitch) * 16384.0f;
+            float az = std::cos(roll) * std::cos(pitch) * 16384.0f;
+
+            OrientationFilter filter(0.1f);
+            for (int i = 0; i < 5000; i++) filter.updateImu(0.0f, 0.0f, 0.0f, ax, ay, az, 0.01f);
+            float r, p, y;
+            filter.getEuler(r, p, y);
+            CHECK_NEAR(r, pose[0], 0.5);
+            CHECK_NEAR(p, pose[1], 0.5);
+        }
+    }
+
+    void testConstantRateYaw() {
+        // 30 deg/s sull'asse z per 2 s, in piano: yaw 60 gradi, roll e pitch fermi
+        OrientationFilter filter(0.1f);
+        const float rate = 30.0f * DEG_TO_RAD;
+        const float dt = 1.0f / 960.0f;
+        for (int i = 0; i < 2 * 960; i++) filter.updateImu(0.0f, 0.0f, rate, 0.0f, 0.0f, 1.0f, dt);
+        float r, p, y;
+        filter.getEuler(r, p, y);
+        CHECK_NEAR(y, 60.0, 0.5);
+        CHECK_NEAR(r, 0.0, 0.1);
+        CHECK_NEAR(p, 0.0, 0.1);
+
+        filter.reset();
+        filter.getEuler(r, p, y);
+        CHECK_NEAR(y, 0.0, 1e-6);
+    }
+
+    void testPipelineNeedsGyroScale(const std::string& dir) {
+        const char* withGyro = R"({ "devices": [ { "components": [
+            { "lsm6dsv16x_acc": { "odr": 960, "sensitivity": 0.000061 } },
+            { "lsm6dsv16x_gyro": { "odr": 960, "sensitivity": 0.035 } } ] } ] })";
+        const char* withoutGyro = R"({ "devices": [ { "components": [
+            { "lsm6dsv16x_acc": { "odr": 960, "sensitivity": 0.000061 } },
+            { "lsm6dsv16x_gyro": { "odr": 960 } } ] } ] })";
+
+        for (int hasGyro = 0; hasGyro < 2; hasGyro++) {
+            DeviceStatus status;
+            CHECK(status.parse(hasGyro ? withGyro : withoutGyro));
+            UnitConverter units;
+            units.configure(status);
+            SensorPipeline pipeline(dir);
+            pipeline.configure(status, units);
+            CHECK(pipeline.enableOrientation(100.0) == (hasGyro == 1));
+            pipeline.close();
+        }
+        CHECK(!SensorPipeline(dir).enableOrientation(0.0));
+    }
+}
+
+int main() {
+    testStaticPose();
+    testConstantRateYaw();
+
+    char pattern[] = "/tmp/test_orientation_XXXXXX";
+    const char* dir = mkdtemp(pattern);
+    if (!dir) {
+        std::perror("mkdtemp");
+        return 1;
+    }
+    testPipelineNeedsGyroScale(dir);
+    std::remove((std::string(dir) + "/orientation.json").c_str());
+    rmdir(dir);
+    return TestCheck::testResult("test_orientation_filter");
+}
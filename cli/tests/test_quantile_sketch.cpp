@@ -0,0 +1,105 @@
+// QuantileSketch: errore relativo entro l'accuratezza dichiarata rispetto ai quantili
+// esatti, anche con valori negativi e zeri, dopo la fusione di sketch parziali e con
+// il numero di bin limitato
+#include "QuantileSketch.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+#include <cmath>
+
+namespace {
+    const double QUANTILES[] = { 0.0, 0.01, 0.1, 0.25, 0.5, 0.75, 0.9, 0.99, 0.999, 1.0 };
+
+    // Stesso rango dello sketch: floor(q * (n - 1)) sui valori ordinati
+    double exactQuantile(std::vector<double> values, double q) {
+        size_t rank = static_cast<size_t>(q * static_cast<double>(values.size() - 1));
+        std::nth_element(values.begin(), values.begin() + rank, values.end());
+        return values[rank];
+    }
+
+    bool withinRelative(double estimate, double exact, double accuracy) {
+        if (std::fabs(exact) < 1e-9) return std::fabs(estimate) < 1e-9;
+        // Margine per l'arrotondamento del logaritmo sul bordo dei bin
+        return std::fabs(estimate - exact) <= accuracy * std::fabs(exact) * (1.0 + 1e-9);
+    }
+
+    void checkAgainstExact(const QuantileSketch& sketch, const std::vector<double>& values, double accuracy) {
+        CHECK(sketch.count() == values.size());
+        for (double q : QUANTILES) {
+            double exact = exactQuantile(values, q);
+            double estimate = sketch.quantile(q);
+            if (!withinRelative(estimate, exact, accuracy)) {
+                std::cerr << "  q=" << q << " exact=" << exact << " estimate=" << estimate << "\n";
+            }
+            CHECK(withinRelative(estimate, exact, accuracy));
+        }
+    }
+
+    void testDistributions() {
+        std::mt19937 rng(7);
+        const double accuracy = 0.01;
+
+        std::vector<double> lognormal;
+        std::lognormal_distribution<double> ln(0.0, 2.0);
+        for (int i = 0; i < 50000; i++) lognormal.push_back(ln(rng));
+        QuantileSketch a(accuracy);
+        for (double v : lognormal) a.add(v);
+        checkAgainstExact(a, lognormal, accuracy);
+
+        // Valori di segno misto con zeri esatti (es. un asse fermo)
+        std::vector<double> mixed;
+        std::normal_distribution<double> normal(0.2, 1.5);
+        for (int i = 0; i < 50000; i++) mixed.push_back((i % 50 == 0) ? 0.0 : normal(rng));
+        QuantileSketch b(accuracy);
+        for (double v : mixed) b.add(v);
+        checkAgainstExact(b, mixed, accuracy);
+    }
+
+    void testMerge() {
+        std::mt19937 rng(11);
+        std::uniform_real_distribution<double> uniform(-100.0, 1000.0);
+        std::vector<double> values;
+        QuantileSketch whole(0.02), left(0.02), right(0.02);
+        for (int i = 0; i < 20000; i++) {
+            double v = uniform(rng);
+            values.push_back(v);
+            whole.add(v);
+            (i % 3 == 0 ? left : right).add(v);
+        }
+        left.merge(right);
+        CHECK(left.count() == whole.count());
+        // Fondere i bin equivale ad aver aggiunto tutti i valori allo stesso sketch
+        for (double q : QUANTILES) CHECK(left.quantile(q) == whole.quantile(q));
+        checkAgainstExact(left, values, 0.02);
+    }
+
+    void testBoundedBins() {
+        // Valori su 12 ordini di grandezza (circa 1400 bin) con 128 bin: i più piccoli vengono
+        // fusi, i quantili nell'ultimo 5% (circa 70 bin) restano entro l'accuratezza
+        std::vector<double> values;
+        QuantileSketch sketch(0.01, 128);
+        for (int i = 0; i < 12000; i++) {
+            double v = std::pow(10.0, -6.0 + 12.0 * (i / 12000.0));
+            values.push_back(v);
+            sketch.add(v);
+        }
+        CHECK(sketch.count() == values.size());
+        for (double q : { 0.95, 0.99, 1.0 }) {
+            CHECK(withinRelative(sketch.quantile(q), exactQuantile(values, q), 0.01));
+        }
+        // I quantili bassi sono sovrastimati, mai sotto il valore esatto
+        CHECK(sketch.quantile(0.0) >= exactQuantile(values, 0.0) * (1.0 - 0.01));
+
+        sketch.clear();
+        CHECK(sketch.count() == 0);
+        CHECK(sketch.quantile(0.5) == 0.0);
+    }
+}
+
+int main() {
+    testDistributions();
+    testMerge();
+    testBoundedBins();
+    return TestCheck::testResult("test_quantile_sketch");
+}
@@ -0,0 +1,159 @@
+// Indice sparso: lettura di header e voci, voce troncata ignorata, ricerca per
+// tempo host, interpolazione del tempo dei campioni, raccolta dei segmenti e lettura
+// degli intervalli di byte, anche dai segmenti compressi
+#include "SparseIndex.h"
+#include "TestCheck.h"
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+#ifdef HSD_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace {
+    std::vector<SparseIndex::Entry> makeEntries(double hostStart, double sampleStart, size_t count) {
+        std::vector<SparseIndex::Entry> entries;
+        for (size_t i = 0; i < count; i++) {
+            SparseIndex::Entry e;
+            e.hostTime = hostStart + static_cast<double>(i);
+            e.sampleTime = sampleStart + static_cast<double>(i) * 0.5;   // Orologio del dispositivo a metà velocità
+            e.offset = i * 4096;
+            e.sample = i * 1000;
+            entries.push_back(e);
+        }
+        return entries;
+    }
+
+    void writeIndex(const std::string& path, const SparseIndex::Header& header,
+                    const std::vector<SparseIndex::Entry>& entries, size_t trailingBytes = 0) {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(entries[0])));
+        std::vector<char> partial(trailingBytes, 0x7F);
+        out.write(partial.data(), static_cast<std::streamsize>(partial.size()));
+    }
+
+    void testLoad(const std::string& dir) {
+        std::string path = dir + "/acc.json.idx";
+        SparseIndex::Header header = SparseIndex::makeHeader("lsm6dsv16x_acc", SparseIndex::KIND_JSON, 1000);
+        writeIndex(path, header, makeEntries(100.0, 10.0, 5), 12);
+
+        SparseIndex::Header loaded;
+        std::vector<SparseIndex::Entry> entries;
+        CHECK(SparseIndex::load(path, loaded, entries));
+        CHECK(std::string(loaded.sensor) == "lsm6dsv16x_acc");
+        CHECK(loaded.kind == SparseIndex::KIND_JSON);
+        CHECK(loaded.interval == 1000);
+        CHECK(loaded.layout == SparseIndex::LAYOUT_UNKNOWN);
+        CHECK(entries.size() == 5);   // La voce parziale in coda è scartata
+        CHECK(entries[4].offset == 4 * 4096);
+
+        // Magic errato: non è un indice
+        SparseIndex::Header bad = header;
+        bad.magic[0] = 'X';
+        writeIndex(dir + "/bad.idx", bad, makeEntries(0.0, 0.0, 2));
+        CHECK(!SparseIndex::load(dir + "/bad.idx", loaded, entries));
+
+        SparseIndex::Header codec = SparseIndex::makeHeader("acc", SparseIndex::KIND_CODEC, 1000);
+        CHECK(codec.layout == SparseIndex::LAYOUT_COUNTS);
+    }
+
+    void testLookup() {
+        std::vector<SparseIndex::Entry> entries = makeEntries(100.0, 10.0, 5);   // host 100..104
+
+        CHECK(SparseIndex::upperEntry(entries, 99.0) == 0);
+        CHECK(SparseIndex::lowerEntry(entries, 99.0) == 0);
+        CHECK(SparseIndex::lowerEntry(entries, 100.0) == 0);
+        CHECK(SparseIndex::upperEntry(entries, 100.0) == 1);
+        CHECK(SparseIndex::lowerEntry(entries, 102.5) == 2);
+        CHECK(SparseIndex::upperEntry(entries, 102.5) == 3);
+        CHECK(SparseIndex::lowerEntry(entries, 104.0) == 4);
+        CHECK(SparseIndex::upperEntry(entries, 200.0) == 5);
+
+        // Interpolazione tra voci e estrapolazione oltre gli estremi con la pendenza vicina
+        CHECK_NEAR(SparseIndex::hostToSampleTime(entries, 101.0), 10.5, 1e-12);
+        CHECK_NEAR(SparseIndex::hostToSampleTime(entries, 102.5), 11.25, 1e-12);
+        CHECK_NEAR(SparseIndex::hostToSampleTime(entries, 98.0), 9.0, 1e-12);
+        CHECK_NEAR(SparseIndex::hostToSampleTime(entries, 106.0), 13.0, 1e-12);
+
+        std::vector<SparseIndex::Entry> single(entries.begin(), entries.begin() + 1);
+        CHECK_NEAR(SparseIndex::hostToSampleTime(single, 103.0), 13.0, 1e-12);
+        CHECK_NEAR(SparseIndex::hostToSampleTime({}, 7.0), 7.0, 0.0);
+    }
+
+    void testDirectory(const std::string& dir) {
+        // Segmenti scritti fuori ordine: restituiti in ordine di tempo; indici vuoti ignorati
+        writeIndex(dir + "/gyro_0002.json.idx", SparseIndex::makeHeader("gyro", SparseIndex::KIND_JSON, 1000), makeEntries(200.0, 0.0, 3));
+        writeIndex(dir + "/gyro_0001.json.idx", SparseIndex::makeHeader("gyro", SparseIndex::KIND_JSON, 1000), makeEntries(100.0, 0.0, 3));
+        writeIndex(dir + "/empty.json.idx", SparseIndex::makeHeader("empty", SparseIndex::KIND_JSON, 1000), {});
+
+        auto bySensor = SparseIndex::loadDirectory(dir);
+        CHECK(bySensor.count("gyro") == 1);
+        CHECK(bySensor.count("empty") == 0);
+        CHECK(bySensor.count("lsm6dsv16x_acc") == 1);
+        const auto& gyro = bySensor["gyro"];
+        CHECK(gyro.size() == 2);
+        if (gyro.size() == 2) {
+            CHECK(gyro[0].dataPath == dir + "/gyro_0001.json");
+            CHECK(gyro[1].dataPath == dir + "/gyro_0002.json");
+        }
+    }
+
+    void testReadRange(const std::string& dir) {
+        std::string data;
+        for (int i = 0; i < 300000; i++) data += static_cast<char>('a' + (i * 7) % 26);
+        std::ofstream(dir + "/mag_0001.json", std::ios::binary) << data;
+        writeIndex(dir + "/mag_0001.json.idx", SparseIndex::makeHeader("mag", SparseIndex::KIND_JSON, 1000), makeEntries(300.0, 0.0, 2));
+
+        auto bySensor = SparseIndex::loadDirectory(dir);
+        CHECK(bySensor["mag"].size() == 1);
+        if (bySensor["mag"].empty()) return;
+        std::vector<char> out;
+        CHECK(SparseIndex::readRange(bySensor["mag"][0], 1000, 1010, out));
+        CHECK(std::string(out.begin(), out.end()) == data.substr(1000, 10));
+        CHECK(SparseIndex::readRange(bySensor["mag"][0], 299990, UINT64_MAX, out));
+        CHECK(out.size() == 10);
+
+#ifdef HSD_HAVE_ZLIB
+        // Segmento compresso con -z: stesso contenuto letto dal .gz con gli offset non compressi
+        gzFile gz = gzopen((dir + "/mag_0001.json.gz").c_str(), "wb");
+        gzwrite(gz, data.data(), static_cast<unsigned>(data.size()));
+        gzclose(gz);
+        std::remove((dir + "/mag_0001.json").c_str());
+
+        bySensor = SparseIndex::loadDirectory(dir);
+        CHECK(bySensor["mag"].size() == 1);
+        if (bySensor["mag"].empty()) return;
+        const SparseIndex::Segment& seg = bySensor["mag"][0];
+        CHECK(seg.compressed);
+        CHECK(seg.dataPath == dir + "/mag_0001.json.gz");
+        CHECK(SparseIndex::readRange(seg, 250000, 250010, out));
+        CHECK(std::string(out.begin(), out.end()) == data.substr(250000, 10));
+        CHECK(SparseIndex::readRange(seg, 0, UINT64_MAX, out));
+        CHECK(std::string(out.begin(), out.end()) == data);
+#endif
+    }
+}
+
+int main() {
+    char pattern[] = "/tmp/test_sparse_index_XXXXXX";
+    const char* dir = mkdtemp(pattern);
+    if (!dir) {
+        std::perror("mkdtemp");
+        return 1;
+    }
+    testLoad(dir);
+    testLookup();
+    testDirectory(dir);
+    testReadRange(dir);
+
+    for (const char* name : { "acc.json.idx", "bad.idx", "gyro_0001.json.idx", "gyro_0002.json.idx", "empty.json.idx",
+                             "mag_0001.json", "mag_0001.json.gz", "mag_0001.json.idx" }) {
+        std::remove((std::string(dir) + "/" + name).c_str());
+    }
+    rmdir(dir);
+    return TestCheck::testResult("test_sparse_index");
+}
@@ -0,0 +1,112 @@
+// SpectralAnalyzer: un tono noto dà la frequenza dominante attesa (anche fuori dal centro
+// di un bin e con componente continua), la potenza totale rispetta Parseval sulla finestra
+// di Hann, le bande sommano al totale e push() emette un frame ogni hop
+#include "SpectralAnalyzer.h"
+#include "TestCheck.h"
+#include <vector>
+#include <cmath>
+
+namespace {
+    const double PI = 3.14159265358979323846;
+
+    std::vector<float> tone(size_t n, double fs, double freq, double amplitude, double offset) {
+        std::vector<float> samples(n);
+        for (size_t i = 0; i < n; i++) {
+            samples[i] = static_cast<float>(offset + amplitude * std::sin(2.0 * PI * freq * i / fs));
+        }
+        return samples;
+    }
+
+    // Potenza media della finestra nel tempo (DC rimossa, pesata con Hann): lato destro di Parseval
+    double windowedPower(const std::vector<float>& samples) {
+        size_t n = samples.size();
+        double mean = 0.0;
+        for (float s : samples) mean += s;
+        mean /= n;
+        double energy = 0.0, windowPower = 0.0;
+        for (size_t i = 0; i < n; i++) {
+            double w = 0.5 - 0.5 * std::cos(2.0 * PI * i / n);
+            double x = (samples[i] - mean) * w;
+            energy += x * x;
+            windowPower += w * w;
+        }
+        return energy / windowPower;
+    }
+
+    void testDominantFrequency() {
+        const double fs = 7680.0;
+        const std::vector<double> bands = { 0.0, 50.0, 200.0, fs };
+        for (size_t n : { 1024, 4096 }) {
+            const double binWidth = fs / n;
+            // Tono al centro di un bin e tono a metà tra due bin, sopra una gravità costante
+            for (double freq : { 60.0 * binWidth, 37.5 * binWidth + 10.0 }) {
+                SpectralAnalyzer analyzer(n, 0.5, fs, bands);
+                std::vector<float> samples = tone(n, fs, freq, 0.3, 1.0);
+                analyzer.analyze(samples.data(), 1.0);
+                const SpectralFrame& frame = analyzer.frame();
+                CHECK_NEAR(frame.dominantFreq, freq, binWidth / 2.0 + 1e-9);
+                CHECK_NEAR(frame.timestamp, 1.0, 1e-12);
+            }
+        }
+    }
+
+    void testParseval() {
+        const double fs = 1000.0;
+        const size_t n = 1024;
+        // Ultimo bordo oltre fs/2: anche il bin di Nyquist cade in una banda
+        const std::vector<double> bands = { 0.0, 20.0, 100.0, 300.0, fs };
+        SpectralAnalyzer analyzer(n, 0.0, fs, bands);
+
+        // Due toni (A²/2 ciascuno) più rumore deterministico a banda larga
+        std::vector<float> samples(n);
+        uint32_t state = 12345;
+        for (size_t i = 0; i < n; i++) {
+            state = state * 1664525u + 1013904223u;
+            double noise = (static_cast<double>(state >> 8) / (1u << 24) - 0.5) * 0.1;
+            samples[i] = static_cast<float>(2.0 + 0.5 * std::sin(2.0 * PI * 50.0 * i / fs)
+                                                + 0.2 * std::sin(2.0 * PI * 210.0 * i / fs) + noise);
+        }
+        analyzer.analyze(samples.data(), 0.0);
+        const SpectralFrame& frame = analyzer.frame();
+
+        double expected = windowedPower(samples);
+        CHECK_NEAR(frame.totalEnergy, expected, expected * 1e-4);
+
+        double bandSum = 0.0;
+        for (double e : frame.bandEnergy) bandSum += e;
+        CHECK(frame.bandEnergy.size() == 4);
+        CHECK_NEAR(bandSum, frame.totalEnergy, frame.totalEnergy * 1e-9);
+
+        // Ciascun tono resta quasi tutto nella sua banda (dispersione della Hann: pochi bin)
+        CHECK_NEAR(frame.bandEnergy[1], 0.5 * 0.5 * 0.5, 0.125 * 0.05);
+        CHECK_NEAR(frame.bandEnergy[2], 0.5 * 0.2 * 0.2, 0.02 * 0.1);
+        CHECK(frame.dominantFreq > 45.0 && frame.dominantFreq < 55.0);
+    }
+
+    void testPushHop() {
+        // Finestra 256, overlap 75%: primo frame a 256 campioni, poi uno ogni 64
+        const double fs = 960.0;
+        SpectralAnalyzer analyzer(256, 0.75, fs, {});
+        CHECK(analyzer.getHopSize() == 64);
+        CHECK(analyzer.frame().bandEnergy.empty());
+        std::vector<float> samples = tone(1024, fs, 120.0, 1.0, 0.0);
+        size_t frames = 0;
+        for (size_t i = 0; i < samples.size(); i++) {
+            bool ready = analyzer.push(samples[i], i / fs);
+            CHECK(ready == (i + 1 >= 256 && (i + 1 - 256) % 64 == 0));
+            if (ready) {
+                frames++;
+                CHECK_NEAR(analyzer.frame().timestamp, i / fs, 1e-12);
+                CHECK_NEAR(analyzer.frame().dominantFreq, 120.0, fs / 256 / 2.0);
+            }
+        }
+        CHECK(frames == 13);
+    }
+}
+
+int main() {
+    testDominantFrequency();
+    testParseval();
+    testPushHop();
+    return TestCheck::testResult("test_spectral_analyzer");
+}
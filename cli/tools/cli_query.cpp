@@ -0,0 +1,254 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <memory>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <algorithm>
+
+#include "ArgParser.h"
+#include "SparseIndex.h"
+#include "ImuCodec.h"
+#include "json.hpp"
+
+using namespace std;
+
+// Estrazione di una finestra temporale da un'acquisizione tramite gli indici sparsi (<file>.idx):
+// ricerca binaria sulle voci, lettura dei soli byte della finestra e decodifica, su tutti i sensori.
+
+namespace {
+
+    struct Stats {
+        uint64_t samples = 0;
+        uint64_t bytesRead = 0;
+    };
+
+    void printHelp() {
+        cout << "Usage: cli_query <acquisition_dir> [-f from] [-t to] [-T label[:n]] [-M margin_sec]\n"
+             << "                 [-s sensor1,sensor2,...] [-o out_dir]\n"
+             << "  -f : Window start, host epoch seconds or +seconds from the acquisition start\n"
+             << "  -t : Window end, same format (default: end of the acquisition)\n"
+             << "  -T : Use the n-th interval (default 1) of a tag from annotations_index.json\n"
+             << "  -M : Extend the window by the given seconds on both sides\n"
+             << "  -s : Only the given sensors\n"
+             << "  -o : Write one file per sensor (<sensor>.json, raw <sensor>.dat) instead of NDJSON on stdout\n";
+    }
+
+    bool fileExists(const string& path) {
+        ifstream f(path);
+        return static_cast<bool>(f);
+    }
+
+    double parseTime(const string& text, double sessionStart, double fallback) {
+        if (text.empty()) return fallback;
+        if (text[0] == '+') return sessionStart + stod(text.substr(1));
+        return stod(text);
+    }
+
+    // Intervallo di un tag (etichetta[:n], n da 1) dall'indice delle annotazioni
+    bool findTagInterval(const string& dir, const string& spec, double& start, double& end) {
+        string label = spec;
+        size_t wanted = 1;
+        size_t colon = spec.rfind(':');
+        if (colon != string::npos) {
+            label = spec.substr(0, colon);
+            wanted = stoul(spec.substr(colon + 1));
+        }
+        ifstream in(dir + "/annotations_index.json");
+        auto index = nlohmann::json::parse(in, nullptr, false);
+        if (index.is_discarded() || !index.contains("intervals")) return false;
+        size_t seen = 0;
+        for (const auto& interval : index["intervals"]) {
+            if (interval.value("label", "") != label) continue;
+            if (++seen == wanted) {
+                start = interval.value("start", 0.0);
+                end = interval.value("end", 0.0);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Oggetti JSON dei campioni (uno per riga, senza annidamento) con timestamp in [s0, s1]
+    void emitJson(const vector<char>& buf, double s0, double s1, const string& sensor,
+                  ostream& out, bool ndjson, bool& first, Stats& stats) {
+        const char* p = buf.data();
+        const char* end = p + buf.size();
+        while (true) {
+            const char* open = static_cast<const char*>(memchr(p, '{', end - p));
+            if (!open) break;
+            const char* close = static_cast<const char*>(memchr(open, '}', end - open));
+            if (!close) break;
+            p = close + 1;
+
+            static const char KEY[] = "\"timestamp\":";
+            const char* key = std::search(open, close, KEY, KEY + sizeof(KEY) - 1);
+            if (key == close) continue;
+            double ts = strtod(key + sizeof(KEY) - 1, nullptr);
+            if (ts < s0 || ts > s1) continue;
+
+            stats.samples++;
+            if (ndjson) {
+                out << "{ \"sensor\": \"" << sensor << "\", ";
+                out.write(open + 2, close + 1 - (open + 2));
+                out << '\n';
+            } else {
+                out << (first ? "[\n" : ",\n");
+                out.write(open, close + 1 - open);
+            }
+            first = false;
+        }
+    }
+
+    void emitCodec(const vector<char>& buf, double t0, double t1, const string& sensor,
+                   ostream& out, bool ndjson, bool& first, Stats& stats) {
+        const uint8_t* data = reinterpret_cast<const uint8_t*>(buf.data());
+        size_t pos = 0;
+        ImuCodec::FrameInfo info;
+        vector<int16_t> samples;
+        while (pos < buf.size()) {
+            size_t used = ImuCodec::decodeFrame(data + pos, buf.size() - pos, info, samples);
+            if (used == 0) {
+                pos = ImuCodec::findNextFrame(data, buf.size(), pos + 1);
+                continue;
+            }
+            pos += used;
+            if (info.nSamples == 0 || info.channels < 3) continue;
+            double dt = (info.tEnd - info.tStart) / info.nSamples;
+            for (uint32_t i = 0; i < info.nSamples; i++) {
+                double ts = info.tStart + i * dt;
+                if (ts < t0 || ts > t1) continue;
+                const int16_t* s = &samples[i * info.channels];
+                stats.samples++;
+                if (ndjson) {
+                    out << "{ \"sensor\": \"" << sensor << "\", ";
+                } else {
+                    out << (first ? "[\n{ " : ",\n{ ");
+                }
+                char line[96];
+                int n = snprintf(line, sizeof(line), "\"timestamp\": %.6f, \"x\": %d, \"y\": %d, \"z\": %d }%s",
+                                 ts, s[0], s[1], s[2], ndjson ? "\n" : "");
+                out.write(line, n);
+                first = false;
+            }
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    ArgParser input(argc, argv);
+    if (argc < 2 || input.cmdOptionExists("-h") || argv[1][0] == '-') {
+        printHelp();
+        return argc < 2 ? -1 : 0;
+    }
+    string dir = argv[1];
+    auto started = chrono::steady_clock::now();
+
+    auto bySensor = SparseIndex::loadDirectory(dir);
+    if (bySensor.empty()) {
+        cerr << "[Query] No index files (.idx) in " << dir << "\n";
+        return -1;
+    }
+
+    double sessionStart = 1e300, sessionEnd = 0.0;
+    for (const auto& pair : bySensor) {
+        sessionStart = min(sessionStart, pair.second.front().entries.front().hostTime);
+        sessionEnd = max(sessionEnd, pair.second.back().entries.back().hostTime);
+    }
+
+    // Senza estremi tutta l'acquisizione (i campioni del primo blocco precedono la prima voce)
+    double t0 = parseTime(input.getCmdOption("-f"), sessionStart, 0.0);
+    double t1 = parseTime(input.getCmdOption("-t"), sessionStart, sessionEnd + 3600.0);
+    if (input.cmdOptionExists("-T") && !findTagInterval(dir, input.getCmdOption("-T"), t0, t1)) {
+        cerr << "[Query] Tag interval '" << input.getCmdOption("-T") << "' not found in annotations_index.json\n";
+        return -1;
+    }
+    if (input.cmdOptionExists("-M")) {
+        double margin = stod(input.getCmdOption("-M"));
+        t0 -= margin;
+        t1 += margin;
+    }
+
+    set<string> wanted;
+    istringstream list(input.getCmdOption("-s"));
+    string item;
+    while (getline(list, item, ',')) if (!item.empty()) wanted.insert(item);
+
+    string outDir = input.getCmdOption("-o");
+    bool ndjson = outDir.empty();
+
+    for (const auto& pair : bySensor) {
+        const string& sensor = pair.first;
+        if (!wanted.empty() && !wanted.count(sensor)) continue;
+        const auto& segments = pair.second;
+        uint32_t kind = segments.front().header.kind;
+
+        unique_ptr<ofstream> file;
+        if (!ndjson) {
+            string ext = (kind == SparseIndex::KIND_RAW) ? ".dat" : ".json";
+            file.reset(new ofstream(outDir + "/" + sensor + ext, ios::binary));
+        } else if (kind == SparseIndex::KIND_RAW) {
+            cerr << "[Query] " << sensor << ": raw stream, use -o to extract it\n";
+            continue;
+        }
+        ostream& out = ndjson ? cout : *file;
+
+        Stats stats;
+        bool first = true;
+        vector<char> buf;
+        for (size_t i = 0; i < segments.size(); i++) {
+            const SparseIndex::Segment& seg = segments[i];
+            const auto& entries = seg.entries;
+            // Il segmento termina dove inizia il successivo
+            if (entries.front().hostTime > t1) break;
+            if (i + 1 < segments.size() && segments[i + 1].entries.front().hostTime < t0) continue;
+            if (!fileExists(seg.dataPath)) {
+                cerr << "[Query] " << seg.dataPath << " not available, skipped\n";
+                continue;
+            }
+            if (seg.compressed && !SparseIndex::canReadCompressed()) {
+                cerr << "[Query] " << seg.dataPath << " is compressed and this build has no zlib, skipped\n";
+                continue;
+            }
+
+            // Una voce di margine per lato: il tempo host di una voce è quello di scrittura del blocco
+            size_t from = SparseIndex::lowerEntry(entries, t0);
+            if (from > 0) from--;
+            size_t to = SparseIndex::upperEntry(entries, t1);
+            if (to < entries.size()) to++;
+            uint64_t begin = entries[from].offset;
+            uint64_t end = (to < entries.size()) ? entries[to].offset : UINT64_MAX;
+            if (!SparseIndex::readRange(seg, begin, end, buf)) {
+                cerr << "[Query] Cannot read " << seg.dataPath << "\n";
+                continue;
+            }
+            stats.bytesRead += buf.size();
+
+            if (kind == SparseIndex::KIND_JSON) {
+                emitJson(buf, SparseIndex::hostToSampleTime(entries, t0), SparseIndex::hostToSampleTime(entries, t1),
+                         sensor, out, ndjson, first, stats);
+            } else if (kind == SparseIndex::KIND_CODEC) {
+                emitCodec(buf, t0, t1, sensor, out, ndjson, first, stats);
+            } else {
+                // Blocchi grezzi: granularità della voce dell'indice
+                out.write(buf.data(), static_cast<streamsize>(buf.size()));
+                stats.samples += buf.size();
+            }
+        }
+        if (!ndjson && kind != SparseIndex::KIND_RAW) out << (first ? "[\n]" : "\n]");
+
+        cerr << "[Query] " << sensor << ": " << stats.samples
+             << (kind == SparseIndex::KIND_RAW ? " bytes" : " samples") << ", " << stats.bytesRead << " bytes read\n";
+    }
+
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - started).count();
+    cerr << "[Query] Window " << fixed << setprecision(3) << t0 << " - " << t1 << " in " << ms << " ms\n";
+    return 0;
+}